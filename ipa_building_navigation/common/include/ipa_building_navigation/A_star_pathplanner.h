@@ -10,11 +10,13 @@
 #include <ctime>
 #include <cstdlib>
 #include <stdio.h>
+#include <vector>
 
 #include <opencv2/opencv.hpp>
 #include <opencv2/highgui/highgui.hpp>
 
 #include <ipa_building_navigation/node.h>
+#include <ipa_building_navigation/map_context.h>
 
 #pragma once //make sure this header gets included only one time when multiple classes need it in the same project
 			 //regarding to https://en.wikipedia.org/wiki/Pragma_once this is more efficient than #define
@@ -29,6 +31,17 @@
 //The algorithm also needs the Robot radius [m] and the map resolution [m²/pixel] to calculate the needed
 //amount of erosions to include the radius in the planning.
 //
+//Two search modes are available (setSearchMode): the standard A* search and a Jump Point Search, which skips the expansion of
+//symmetric path segments on the uniform-cost grid and uses the exact octile distance as heuristic. Both return paths of the
+//same (minimal) cost, Jump Point Search expands far fewer nodes on large open maps and long corridors. The search mode is a
+//setting of each planner object (default: ASTAR_STANDARD).
+//
+//The planner keeps no static state, i.e. different AStarPlanner objects can be used in parallel threads. A single object
+//must not be shared between threads since it stores the last computed route and its search buffers, which are allocated once
+//and reused for all queries on maps of the same size.
+//
+
+enum AStarSearchModes {ASTAR_STANDARD=1, ASTAR_JUMP_POINT_SEARCH=2};
 
 class AStarPlanner
 {
@@ -36,16 +49,66 @@ protected:
 	int n;
 	int m;
 
-	std::string route_;
+	int search_mode_;	// search algorithm used by planPath, see AStarSearchModes
+
+	std::vector<cv::Point> route_;	// cells of the last computed route on the searched map, including start and goal cell
+
+	int expanding_counter_;		// number of expanded child nodes during the last search
+
+	// search context, allocated once for the map size and reused by all subsequent queries on maps of the same size
+	// a cell entry is only valid if its visited_generation_ equals generation_, so the arrays never need to be cleared between queries
+	int context_cells_;
+	unsigned int generation_;
+	std::vector<unsigned int> visited_generation_;	// generation in which the cell has been put on the open list
+	std::vector<unsigned int> closed_generation_;	// generation in which the cell has been expanded
+	std::vector<int> cost_;							// accumulated cost from the start (10 per straight, 14 per diagonal step)
+	std::vector<int> priority_;						// cost + heuristic estimate to the goal
+	std::vector<signed char> parent_direction_;		// direction index pointing to the parent cell
+	std::vector<int> parent_cell_;					// index of the parent jump point (Jump Point Search)
+	std::vector<int> heap_;							// binary min-heap of cell indices of the open list, ordered by priority_
+	std::vector<int> heap_position_;				// position of each open cell in heap_
+
+	// prepares the search context for a map with the given number of cells and starts a new generation
+	void prepareContext(const int number_cells);
 
-	std::string pathFind(const int& xStart, const int& yStart, const int& xFinish, const int& yFinish, const cv::Mat& map);
+	void heapPush(const int cell);
+	int heapPop();
+	void heapSiftUp(int position);
+	void heapSiftDown(int position);
+
+	// A* search from (xStart, yStart) to (xFinish, yFinish) on map (cells with value 255 are accessible)
+	// returns true and writes the cells from start to goal into route if a path was found
+	bool pathFind(const int& xStart, const int& yStart, const int& xFinish, const int& yFinish, const cv::Mat& map, std::vector<cv::Point>& route);
+
+	// Jump Point Search with octile heuristic on the same grid and with the same step costs as pathFind, diagonal moves past
+	// obstacle corners are allowed like in pathFind, the route contains all cells from start to goal
+	bool jumpPointSearch(const int& xStart, const int& yStart, const int& xFinish, const int& yFinish, const cv::Mat& map, std::vector<cv::Point>& route);
+
+	// scans from (x,y) into direction (dx,dy) and returns true with the next jump point in (jump_x,jump_y) if one exists
+	bool jump(int x, int y, const int dx, const int dy, const int xFinish, const int yFinish, const cv::Mat& map, int& jump_x, int& jump_y);
+
+	inline bool isAccessible(const int x, const int y, const cv::Mat& map) const
+	{
+		return (x >= 0 && x < n && y >= 0 && y < m && map.at<unsigned char>(y, x) == 255);
+	}
 
 public:
 	AStarPlanner();
 
-	void drawRoute(cv::Mat& map, const cv::Point start_point, const std::string& route, double step_length);
+	// selects the search algorithm used by planPath, see AStarSearchModes, default: ASTAR_STANDARD
+	void setSearchMode(const int search_mode)
+	{
+		search_mode_ = search_mode;
+	}
+
+	int getSearchMode() const
+	{
+		return search_mode_;
+	}
+
+	void drawRoute(cv::Mat& map, const cv::Point start_point, const std::vector<cv::Point>& route, double step_length);
 
-	void getRoute(const cv::Point start_point, const std::string& route, double step_length, std::vector<cv::Point>& route_points);
+	void getRoute(const cv::Point start_point, const std::vector<cv::Point>& route, double step_length, std::vector<cv::Point>& route_points);
 
 	// computes the path length between start point and end point
 	double planPath(const cv::Mat& map, const cv::Point& start_point, const cv::Point& end_point,
@@ -58,5 +121,8 @@ public:
 			const double robot_radius, const double map_resolution, const int end_point_valid_neighborhood_radius=0, cv::Mat* draw_path_map=NULL,
 			std::vector<cv::Point>* route=NULL);
 
-	void downsampleMap(const cv::Mat& map, cv::Mat& downsampled_map, const double downsampling_factor, const double robot_radius, const double map_resolution);
+	// erodes the map by the robot radius and downsamples it, the result is copied from map_context if the context belongs to map and
+	// the parameters, downsampled_map never shares its data with map or map_context
+	void downsampleMap(const cv::Mat& map, cv::Mat& downsampled_map, const double downsampling_factor, const double robot_radius, const double map_resolution,
+			const MapContext* map_context=NULL);
 };
@@ -17,18 +17,17 @@
 
 #include <ipa_building_navigation/A_star_pathplanner.h>
 #include <ipa_building_navigation/distance_matrix.h>
+#include <ipa_building_navigation/local_search_TSP.h>
+#include <boost/atomic.hpp>
 
 #pragma once //make sure this header gets included only one time when multiple classes need it in the same project
 //regarding to https://en.wikipedia.org/wiki/Pragma_once this is more efficient than #define
 
-//This class applies an object to solve a given TSP problem using the concorde TSP solver. This solver can be downloaded at:
-//		http://www.math.uwaterloo.ca/tsp/concorde.html
-//A short explanation on how to build the solver is given at:
-//		http://www.math.uwaterloo.ca/tsp/concorde/DOC/README.html
-//If you have build the solver navigate to the./TSP folder and type " ./concorde -h " to see how to use this solver. This class
-//uses the concorde solver by using a systemcall.
-//Make sure you have a "/common/files/TSP_order.txt" and a "/common/files/TSPlib_file.txt" file. These files are used to tell
-//concorde the current problem and save the output of it.
+//This class applies an object to solve a given TSP problem with the heuristic LocalSearchTSPSolver, which replaces the concorde
+//TSP solver (http://www.math.uwaterloo.ca/tsp/concorde.html) that this class used to call. The local search improves a nearest
+//neighbor tour with 2-opt and Or-opt moves (neighbor lists and don't-look bits) and iterates with double-bridge kicks. Only
+//problems with up to 8 nodes are solved exactly, larger tours are near-optimal without a guarantee. The computation stops when
+//the time budget (default 1 s) is used up and can be cancelled with abortComputation(), the best tour found so far is returned.
 //
 //It needs a symmetrical matrix of pathlenghts between the nodes and the starting-point index in this matrix.
 //If the path from one node to another doesn't exist or the path is from one node to itself, the entry in the matrix must
@@ -49,18 +48,17 @@ protected:
 	//Astar pathplanner to find the pathlengths from cv::Point to cv::Point
 	AStarPlanner pathplanner_;
 
-	//Function to create neccessary TSPlib file to tell concorde what the problem is.
-	void writeToFile(const cv::Mat& pathlength_matrix, const std::string& tsp_lib_filename, const std::string& tsp_order_filename);
+	//settings of the distance matrices that the solver computes from a map
+	DistanceMatrixSettings distance_matrix_settings_;
 
-	//Function to read the saved TSP order.
-	std::vector<int> readFromFile(const std::string& tsp_order_filename);
+	//in-process solver that computes the tours
+	LocalSearchTSPSolver local_search_solver_;
 
 	void distance_matrix_thread(DistanceMatrix& distance_matrix_computation, cv::Mat& distance_matrix,
 			const cv::Mat& original_map, const std::vector<cv::Point>& points, double downsampling_factor,
 			double robot_radius, double map_resolution, AStarPlanner& path_planner);
 
-	bool abort_computation_;
-	std::string unique_file_identifier_;
+	boost::atomic<bool> abort_computation_;	// set by abortComputation from another thread
 
 public:
 	//Constructor
@@ -68,8 +66,14 @@ public:
 
 	void abortComputation();
 
+	//maximum computation time of one tour in [s], the best tour found so far is used afterwards, <= 0 means no limit
+	void setTimeBudget(const double time_budget);
+
+	//sets the settings of the distance matrices that the solver computes from a map and the search mode of its path planner, see DistanceMatrixSettings
+	void setDistanceMatrixSettings(const DistanceMatrixSettings& settings);
+
 	//Functions to solve the TSP. It needs a distance matrix, that shows the pathlengths between two nodes of the problem.
-	//This matrix has to be symmetrical or else the TSPlib must be changed. The int shows the index in the Matrix.
+	//This matrix has to be symmetrical. The int shows the index in the Matrix.
 	//There are two functions for different cases:
 	//		1. The distance matrix already exists
 	//		2. The distance matrix has to be computed and maybe returned
@@ -88,5 +92,5 @@ public:
 
 	// compute TSP with pre-computed cleaned distance matrix (does not contain any infinity paths)
 	std::vector<int> solveConcordeTSPWithCleanedDistanceMatrix(const cv::Mat& distance_matrix,
-			const std::map<int,int>& cleaned_index_to_original_index_mapping, const int start_node);
+			const std::vector<int>& cleaned_index_to_original_index_mapping, const int start_node);
 };
@@ -3,32 +3,438 @@
 #pragma once
 
 #include <vector>
+#include <deque>
+#include <map>
 #include <opencv2/opencv.hpp>
+#include <boost/thread.hpp>
+#include <boost/bind.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/atomic.hpp>
 #include <ipa_building_navigation/A_star_pathplanner.h>
+#include <ipa_building_navigation/wavefront_planner.h>
+#include <ipa_building_navigation/room_graph_planner.h>
+#include <ipa_building_navigation/distance_matrix_cache.h>
+#include <ipa_building_navigation/line_of_sight.h>
+#include <ipa_building_navigation/tsp_solver_defines.h>
+#include <ipa_building_navigation/instrumentation.h>
 
 #include <ipa_building_navigation/timer.h>
 
+// Settings of the distance matrix computation. They are chosen by the top-level caller of a request and handed to the DistanceMatrix
+// objects and TSP solvers that work on this request. Callers that already run in one of several parallel threads should keep
+// number_of_threads at 1.
+struct DistanceMatrixSettings
+{
+	int number_of_threads;	// number of worker threads that compute the rows, 1 = serial computation (default), values < 1 use the number of available cores
+	int backend;	// method for computing the path lengths of pairs without direct line of sight, see DistanceMatrixBackends (default: DISTANCE_MATRIX_ASTAR)
+	int astar_search_mode;	// search mode of the A* planners of the TSP solvers, see AStarSearchModes (default: ASTAR_STANDARD), the DistanceMatrix itself uses the mode of the planner it is given
+	boost::shared_ptr<const RoomGraphPlanner> room_graph;	// room graph of the map of the request for DISTANCE_MATRIX_ROOM_GRAPH, it is only used for maps and parameters it has been built for (default: none)
+	boost::shared_ptr<const MapContext> map_context;	// preprocessed versions of the map of the request, only used for the map it has been created for (default: none)
+
+	DistanceMatrixSettings()
+	: number_of_threads(1), backend(DISTANCE_MATRIX_ASTAR), astar_search_mode(ASTAR_STANDARD)
+	{
+	}
+};
+
 class DistanceMatrix
 {
 protected:
 
-	bool abort_computation_;
+	boost::atomic<bool> abort_computation_;	// set by abortComputation from another thread
+
+	int number_of_threads_;		// number of worker threads used for the distance matrix computation, 1 = serial computation
+
+	int backend_;		// method for computing the path lengths of pairs without direct line of sight, see DistanceMatrixBackends
+
+	boost::shared_ptr<const RoomGraphPlanner> room_graph_;	// room graph of the current map, used by DISTANCE_MATRIX_ROOM_GRAPH
+
+	boost::shared_ptr<const MapContext> map_context_;	// provides the downsampled map if it belongs to the map of the computation
+
+	// hash of original_map for the cache keys, taken from the map context if it belongs to the map, so that it is computed once per request
+	boost::uint64_t getMapHash(const cv::Mat& original_map) const
+	{
+		if (map_context_ && map_context_->isValidFor(original_map) == true)
+			return map_context_->getMapHash();
+		return DistanceMatrixCache::computeMapHash(original_map);
+	}
+
+	// computes the distance matrix with the room graph, pairs with direct line of sight get their straight line length and
+	// pairs that are not connected on the downsampled map are planned with A* on the original map, like in AStarPlanner::planPath
+	// returns false if the computation was aborted
+	bool computeRoomGraphDistanceMatrix(cv::Mat& distance_matrix, const cv::Mat& original_map, const std::vector<cv::Point>& points,
+			const double map_resolution, AStarPlanner& path_planner)
+	{
+		room_graph_->computeDistanceMatrix(points, distance_matrix);
+		long raycasts = 0;
+		for (int i = 0; i < points.size(); i++)
+		{
+			for (int j = i+1; j < points.size(); j++)
+			{
+				if (abort_computation_==true)
+					return false;
+
+				const bool direct_connection = LineOfSight::isFree(original_map, points[i], points[j], 250);
+				++raycasts;
+				double length = distance_matrix.at<double>(i, j);
+				if (direct_connection == true)
+					length = cv::norm(points[i]-points[j]);
+				else if (length > 1e90)
+					length = path_planner.planPath(original_map, points[i], points[j], 1., 0., map_resolution);
+				distance_matrix.at<double>(i, j) = length;
+				distance_matrix.at<double>(j, i) = length;
+			}
+		}
+		Instrumentation::addCount("raycasts", raycasts);
+		return true;
+	}
+
+	// shared state of the worker threads of the parallel distance matrix computation
+	// each thread owns a double-ended queue of rows, it takes rows from the front of its own queue and steals rows from the back
+	// of the other queues once its own queue has run empty
+	struct RowScheduler
+	{
+		std::vector<std::deque<int> > row_queues;
+		boost::mutex mutex;
+		int finished_rows;
+		int number_rows;
+
+		// input and output data of the computation
+		cv::Mat* distance_matrix;
+		const cv::Mat* original_map;
+		const cv::Mat* downsampled_map;
+		const std::vector<cv::Point>* points;
+		double downsampling_factor;
+		double map_resolution;
+		int first_column;
+		std::vector<std::vector<std::vector<cv::Point> > >* paths;
+		int search_mode;	// search mode of the planner of the caller, used by the planners of all workers
+	};
+
+	// computes the upper triangle entries (i,j) with j>i and j>=first_column of row i and mirrors them to (j,i)
+	// pairs without direct line of sight are either planned with one A* search each (DISTANCE_MATRIX_ASTAR) or with one common
+	// wavefront expansion from point i on downsampled_map (DISTANCE_MATRIX_WAVEFRONT)
+	// returns false if the computation was aborted
+	bool computeDistanceMatrixRow(const int i, const int first_column, cv::Mat& distance_matrix, const cv::Mat& original_map,
+			const cv::Mat& downsampled_map, const std::vector<cv::Point>& points, const double downsampling_factor, const double map_resolution,
+			AStarPlanner& path_planner, WavefrontPlanner& wavefront_planner, std::vector<std::vector<std::vector<cv::Point> > >* paths)
+	{
+		distance_matrix.at<double>(i, i) = 0;
+		const int first_j = std::max(i+1, first_column);		//only compute upper right triangle of matrix, rest is symmetrically added
+		if (first_j >= (int)points.size())
+			return true;
+
+		// try first with direct connecting lines (often sufficient and a significant speedup over A*), all lines of the row are
+		// checked in one batch, a pixel in between that is not accessible prevents the direct connection
+		std::vector<cv::Point> goals(points.begin()+first_j, points.end());
+		std::vector<bool> direct_connections;
+		LineOfSight::checkVisibility(original_map, points[i], goals, direct_connections, 250);
+
+		std::vector<int> wavefront_targets;		// indices j that still need to be planned with the wavefront
+		for (int j = first_j; j < points.size(); j++)
+		{
+			if (abort_computation_==true)
+				return false;
+
+			if (direct_connections[j-first_j] == true)
+			{
+				// compute distance
+				const double length = cv::norm(points[i]-points[j]);
+				distance_matrix.at<double>(i, j) = length;
+				distance_matrix.at<double>(j, i) = length; //symmetrical-Matrix --> saves half the computation time
+				if (paths!=NULL)
+				{
+					// store path
+					std::vector<cv::Point> current_path;
+					LineOfSight::getLine(original_map, points[i], points[j], current_path);
+					paths->at(i).at(j) = current_path;
+					paths->at(j).at(i) = current_path;
+				}
+			}
+			else if (backend_ == DISTANCE_MATRIX_WAVEFRONT)
+			{
+				wavefront_targets.push_back(j);
+			}
+			else
+			{
+				// A* path planner
+				if(paths!=NULL)
+				{
+					std::vector<cv::Point> current_path;
+					double length = path_planner.planPath(original_map, downsampled_map, points[i], points[j], downsampling_factor, 0., map_resolution, 0, NULL, &current_path);
+					distance_matrix.at<double>(i, j) = length;
+					distance_matrix.at<double>(j, i) = length; //symmetrical-Matrix --> saves half the computation time
+
+					// remap path points to original map size
+					for(std::vector<cv::Point>::iterator point=current_path.begin(); point!=current_path.end(); ++point)
+					{
+						point->x = point->x/downsampling_factor;
+						point->y = point->y/downsampling_factor;
+					}
+
+					paths->at(i).at(j) = current_path;
+					paths->at(j).at(i) = current_path;
+				}
+				else
+				{
+					double length = path_planner.planPath(original_map, downsampled_map, points[i], points[j], downsampling_factor, 0., map_resolution);
+					distance_matrix.at<double>(i, j) = length;
+					distance_matrix.at<double>(j, i) = length; //symmetrical-Matrix --> saves half the computation time
+				}
+			}
+		}
+
+		if (wavefront_targets.size() == 0)
+			return true;
+		if (abort_computation_==true)
+			return false;
+
+		// one wavefront expansion from point i on the downsampled map provides the lengths to all remaining targets
+		const cv::Point start_cell = downsampling_factor*points[i];
+		std::vector<cv::Point> target_cells(wavefront_targets.size());
+		for (size_t t=0; t<wavefront_targets.size(); ++t)
+			target_cells[t] = downsampling_factor*points[wavefront_targets[t]];
+		wavefront_planner.computeWavefront(downsampled_map, start_cell, &target_cells);
+		const double step_length = 1./downsampling_factor;
+		for (size_t t=0; t<wavefront_targets.size(); ++t)
+		{
+			if (abort_computation_==true)
+				return false;
+
+			const int j = wavefront_targets[t];
+			double length = 0.;
+			std::vector<cv::Point> current_path;
+			if (target_cells[t] == start_cell)
+			{
+				length = 0.;	// both points fall into the same cell, like in AStarPlanner::planPath
+			}
+			else if (wavefront_planner.isReachable(target_cells[t]) == true)
+			{
+				length = step_length * wavefront_planner.getPathLength(target_cells[t]);
+				if (paths!=NULL)
+				{
+					// remap path points to original map size
+					wavefront_planner.getPath(target_cells[t], current_path);
+					for(std::vector<cv::Point>::iterator point=current_path.begin(); point!=current_path.end(); ++point)
+					{
+						point->x = point->x/downsampling_factor;
+						point->y = point->y/downsampling_factor;
+					}
+				}
+			}
+			else
+			{
+				// if no path can be found on the downsampled map try with the original map, like in AStarPlanner::planPath
+				length = path_planner.planPath(original_map, points[i], points[j], 1., 0., map_resolution, 0, (paths!=NULL ? &current_path : NULL));
+			}
+			distance_matrix.at<double>(i, j) = length;
+			distance_matrix.at<double>(j, i) = length; //symmetrical-Matrix --> saves half the computation time
+			if (paths!=NULL)
+			{
+				paths->at(i).at(j) = current_path;
+				paths->at(j).at(i) = current_path;
+			}
+		}
+		return true;
+	}
+
+	// worker function of the parallel distance matrix computation, every thread uses its own planner object
+	// different rows write to disjoint matrix entries, so no locking is necessary for distance_matrix and paths
+	void distanceMatrixWorker(const int thread_index, RowScheduler& scheduler)
+	{
+		AStarPlanner path_planner;
+		path_planner.setSearchMode(scheduler.search_mode);
+		WavefrontPlanner wavefront_planner;
+		while (true)
+		{
+			// get the next row: first from the own queue, then try to steal from the other threads
+			int row = -1;
+			{
+				boost::mutex::scoped_lock lock(scheduler.mutex);
+				if (scheduler.row_queues[thread_index].empty() == false)
+				{
+					row = scheduler.row_queues[thread_index].front();
+					scheduler.row_queues[thread_index].pop_front();
+				}
+				else
+				{
+					for (size_t k=1; k<scheduler.row_queues.size() && row==-1; ++k)
+					{
+						std::deque<int>& victim = scheduler.row_queues[(thread_index+k)%scheduler.row_queues.size()];
+						if (victim.empty() == false)
+						{
+							row = victim.back();
+							victim.pop_back();
+						}
+					}
+				}
+			}
+			if (row == -1)
+				return;
+
+			if (computeDistanceMatrixRow(row, scheduler.first_column, *scheduler.distance_matrix, *scheduler.original_map, *scheduler.downsampled_map, *scheduler.points,
+					scheduler.downsampling_factor, scheduler.map_resolution, path_planner, wavefront_planner, scheduler.paths) == false)
+				return;
+
+			// progress display
+			if (scheduler.number_rows>500)
+			{
+				boost::mutex::scoped_lock lock(scheduler.mutex);
+				scheduler.finished_rows++;
+				if (scheduler.finished_rows%(std::max(1,scheduler.number_rows/100))==0)
+					std::cout << "." << std::flush;
+			}
+		}
+	}
+
+	// computes all rows of distance_matrix, see computeDistanceMatrixRow, either serially with path_planner or distributed over
+	// number_of_threads_ worker threads, returns false if the computation was aborted
+	bool computeDistanceMatrixRows(cv::Mat& distance_matrix, const cv::Mat& original_map, const cv::Mat& downsampled_map,
+			const std::vector<cv::Point>& points, const double downsampling_factor, const double map_resolution, AStarPlanner& path_planner,
+			std::vector<std::vector<std::vector<cv::Point> > >* paths, const int first_column)
+	{
+		if (points.size()>500)
+			std::cout << "0         10        20        30        40        50        60        70        80        90        100" << std::endl;
+
+		const int number_of_threads = std::min(number_of_threads_, std::max(1, (int)points.size()-1));
+		if (number_of_threads <= 1)
+		{
+			WavefrontPlanner wavefront_planner;
+			for (int i = 0; i < points.size(); i++)
+			{
+				if (points.size()>500 && i%(std::max(1,(int)points.size()/100))==0)
+					std::cout << "." << std::flush;
+				if (computeDistanceMatrixRow(i, first_column, distance_matrix, original_map, downsampled_map, points, downsampling_factor, map_resolution, path_planner, wavefront_planner, paths) == false)
+					return false;
+			}
+		}
+		else
+		{
+			// distribute the rows in a zig-zag manner, row i contains N-1-i entries, so that every queue starts with a similar amount of work
+			RowScheduler scheduler;
+			scheduler.row_queues.resize(number_of_threads);
+			scheduler.finished_rows = 0;
+			scheduler.number_rows = (int)points.size();
+			scheduler.distance_matrix = &distance_matrix;
+			scheduler.original_map = &original_map;
+			scheduler.downsampled_map = &downsampled_map;
+			scheduler.points = &points;
+			scheduler.downsampling_factor = downsampling_factor;
+			scheduler.map_resolution = map_resolution;
+			scheduler.first_column = first_column;
+			scheduler.paths = paths;
+			scheduler.search_mode = path_planner.getSearchMode();
+			for (int i = 0; i < points.size(); i++)
+			{
+				const int round = i / number_of_threads;
+				const int position = i % number_of_threads;
+				scheduler.row_queues[(round%2==0 ? position : number_of_threads-1-position)].push_back(i);
+			}
+
+			boost::thread_group workers;
+			for (int t = 0; t < number_of_threads; ++t)
+				workers.create_thread(boost::bind(&DistanceMatrix::distanceMatrixWorker, this, t, boost::ref(scheduler)));
+			workers.join_all();
+		}
+		return (abort_computation_==false);
+	}
 
 public:
 
 	DistanceMatrix()
-	: abort_computation_(false)
+	: abort_computation_(false), number_of_threads_(1), backend_(DISTANCE_MATRIX_ASTAR)
 	{
 	}
 
+	DistanceMatrix(const DistanceMatrixSettings& settings)
+	: abort_computation_(false), number_of_threads_(1), backend_(DISTANCE_MATRIX_ASTAR)
+	{
+		setSettings(settings);
+	}
+
+	void setSettings(const DistanceMatrixSettings& settings)
+	{
+		setNumberOfThreads(settings.number_of_threads);
+		setBackend(settings.backend);
+		setRoomGraph(settings.room_graph);
+		setMapContext(settings.map_context);
+	}
+
 	void abortComputation()
 	{
 		abort_computation_ = true;
 	}
 
+	// sets the number of threads used by constructDistanceMatrix, values < 1 select the number of hardware threads, default: 1
+	void setNumberOfThreads(const int number_of_threads)
+	{
+		number_of_threads_ = (number_of_threads < 1 ? std::max(1, (int)boost::thread::hardware_concurrency()) : number_of_threads);
+	}
+
+	int getNumberOfThreads() const
+	{
+		return number_of_threads_;
+	}
+
+	// selects the backend for pairs without direct line of sight, see DistanceMatrixBackends
+	void setBackend(const int backend)
+	{
+		backend_ = backend;
+	}
+
+	int getBackend() const
+	{
+		return backend_;
+	}
+
+	// sets the room graph for DISTANCE_MATRIX_ROOM_GRAPH, it is only used for maps and parameters it has been built for
+	void setRoomGraph(const boost::shared_ptr<const RoomGraphPlanner>& room_graph)
+	{
+		room_graph_ = room_graph;
+	}
+
+	// sets the map context that provides the eroded and downsampled map, it is only used for the map it has been created for
+	void setMapContext(const boost::shared_ptr<const MapContext>& map_context)
+	{
+		map_context_ = map_context;
+	}
+
+	//Computes the path lengths from start_point to all target_points with one wavefront expansion on downsampled_map (see
+	//AStarPlanner::downsampleMap), which stops once all targets are settled. Like AStarPlanner::planPath, targets that cannot be
+	//reached on downsampled_map are planned with A* on the original map, unreachable targets get a length of 1e100.
+	void computePathLengthsFromPoint(std::vector<double>& path_lengths, const cv::Mat& original_map, const cv::Mat& downsampled_map,
+			const cv::Point& start_point, const std::vector<cv::Point>& target_points, const double downsampling_factor,
+			const double map_resolution, AStarPlanner& path_planner)
+	{
+		path_lengths.assign(target_points.size(), 1e100);
+		if (target_points.size() == 0)
+			return;
+
+		const cv::Point start_cell = downsampling_factor*start_point;
+		std::vector<cv::Point> target_cells(target_points.size());
+		for (size_t t=0; t<target_points.size(); ++t)
+			target_cells[t] = downsampling_factor*target_points[t];
+		WavefrontPlanner wavefront_planner;
+		wavefront_planner.computeWavefront(downsampled_map, start_cell, &target_cells);
+		const double step_length = 1./downsampling_factor;
+		for (size_t t=0; t<target_points.size(); ++t)
+		{
+			if (target_cells[t] == start_cell)
+				path_lengths[t] = 0.;	// both points fall into the same cell, like in AStarPlanner::planPath
+			else if (wavefront_planner.isReachable(target_cells[t]) == true)
+				path_lengths[t] = step_length * wavefront_planner.getPathLength(target_cells[t]);
+			else
+				path_lengths[t] = path_planner.planPath(original_map, start_point, target_points[t], 1., 0., map_resolution);
+		}
+	}
+
 	//Function to construct the symmetrical distance matrix from the given points. The rows show from which node to start and
 	//the columns to which node to go. If the path between nodes doesn't exist or the node to go to is the same as the one to
 	//start from, the entry of the matrix is 0.
+	//The rows are distributed over number_of_threads_ worker threads which steal work from each other when they run out of rows.
+	//Each worker uses an own AStarPlanner, the result is identical to the serial computation (number_of_threads_=1), which uses path_planner.
+	//If the DistanceMatrixCache is enabled, a matrix computed earlier for identical inputs is returned without planning (not if paths are requested).
+	//With DISTANCE_MATRIX_ROOM_GRAPH the room graph is used if it matches the inputs and no paths are requested, otherwise A* is used.
 	// REMARK:	paths is a pointer that points to a 3D vector that has dimensionality NxN in the outer vectors to store
 	//			the paths in a matrix manner
 	void constructDistanceMatrix(cv::Mat& distance_matrix, const cv::Mat& original_map, const std::vector<cv::Point>& points,
@@ -36,109 +442,184 @@ public:
 			std::vector<std::vector<std::vector<cv::Point> > >* paths=NULL)
 	{
 		std::cout << "DistanceMatrix::constructDistanceMatrix: Constructing distance matrix..." << std::endl;
+		ScopedSpan span("distance_matrix");
 		Timer tim;
 
 		//create the distance matrix with the right size
 		distance_matrix.create((int)points.size(), (int)points.size(), CV_64F);
 
+		const bool use_room_graph = (backend_==DISTANCE_MATRIX_ROOM_GRAPH && paths==NULL && room_graph_
+				&& room_graph_->isValidFor(getMapHash(original_map), downsampling_factor, robot_radius, map_resolution)==true);
+
+		// reuse a previously computed matrix for the same inputs
+		DistanceMatrixCache& cache = DistanceMatrixCache::getInstance();
+		const bool use_cache = (paths==NULL && cache.isEnabled()==true);
+		boost::uint64_t cache_key = 0;
+		if (use_cache == true)
+		{
+			cache_key = DistanceMatrixCache::computeKey(getMapHash(original_map), points, downsampling_factor, robot_radius, map_resolution, (backend_==DISTANCE_MATRIX_ROOM_GRAPH && use_room_graph==false ? DISTANCE_MATRIX_ASTAR : backend_));
+			if (use_room_graph == true)
+				cache_key ^= room_graph_->getKey();	// the lengths depend on the segmentation
+			if (cache.lookup(cache_key, distance_matrix) == true)
+			{
+				std::cout << "Distance matrix loaded from cache in " << tim.getElapsedTimeInMilliSec() << " ms" << std::endl;
+				return;
+			}
+		}
+
+		if (use_room_graph == true)
+		{
+			if (computeRoomGraphDistanceMatrix(distance_matrix, original_map, points, map_resolution, path_planner) == false)
+				return;
+			if (use_cache == true)
+				cache.store(cache_key, distance_matrix);
+			std::cout << "Distance matrix created with the room graph in " << tim.getElapsedTimeInMilliSec() << " ms" << std::endl;
+			return;
+		}
+
 		// hack: speed up trick
 		if (points.size()>500)
 			downsampling_factor *= 0.5;
 
 		// reduce image size already here to avoid resizing in the planner each time
-		const double one_by_downsampling_factor = 1./downsampling_factor;
 		cv::Mat downsampled_map;
-		path_planner.downsampleMap(original_map, downsampled_map, downsampling_factor, robot_radius, map_resolution);
+		path_planner.downsampleMap(original_map, downsampled_map, downsampling_factor, robot_radius, map_resolution, map_context_.get());
 
-		if (points.size()>500)
-			std::cout << "0         10        20        30        40        50        60        70        80        90        100" << std::endl;
-//		int a=0, b=0;
-		for (int i = 0; i < points.size(); i++)
+		if (computeDistanceMatrixRows(distance_matrix, original_map, downsampled_map, points, downsampling_factor, map_resolution, path_planner, paths, 0) == false)
+			return;
+
+		if (use_cache == true)
+			cache.store(cache_key, distance_matrix);
+
+		std::cout << "\nDistance matrix created in " << tim.getElapsedTimeInMilliSec() << " ms" << std::endl;// "\nDistance matrix:\n" << distance_matrix << std::endl;
+	}
+
+	//Adds new_points to the end of points and extends the distance matrix of points accordingly. Only the entries between the new
+	//points and all other points are planned, i.e. adding m points to N points costs N*m path searches instead of (N+m)^2/2.
+	//The entries are identical to a complete computation with constructDistanceMatrix for the extended point list. If the room
+	//graph is used or the speed up trick for more than 500 points is switched on or off by the new points, the whole matrix is
+	//recomputed with constructDistanceMatrix. Paths are not supported. If the computation is aborted, both inputs remain unchanged.
+	void addPoints(cv::Mat& distance_matrix, std::vector<cv::Point>& points, const std::vector<cv::Point>& new_points,
+			const cv::Mat& original_map, double downsampling_factor, double robot_radius, double map_resolution, AStarPlanner& path_planner)
+	{
+		std::cout << "DistanceMatrix::addPoints: Adding " << new_points.size() << " points to the distance matrix of " << points.size() << " points..." << std::endl;
+		ScopedSpan span("distance_matrix_add_points");
+		Timer tim;
+
+		const int old_size = (int)points.size();
+		std::vector<cv::Point> extended_points = points;
+		extended_points.insert(extended_points.end(), new_points.begin(), new_points.end());
+		const bool use_room_graph = (backend_==DISTANCE_MATRIX_ROOM_GRAPH && room_graph_
+				&& room_graph_->isValidFor(getMapHash(original_map), downsampling_factor, robot_radius, map_resolution)==true);
+		if (distance_matrix.rows!=old_size || distance_matrix.cols!=old_size || use_room_graph==true || (old_size>500)!=(extended_points.size()>500))
+		{
+			cv::Mat extended_distance_matrix;
+			constructDistanceMatrix(extended_distance_matrix, original_map, extended_points, downsampling_factor, robot_radius, map_resolution, path_planner);
+			if (abort_computation_==true)
+				return;
+			distance_matrix = extended_distance_matrix;
+			points.swap(extended_points);
+			return;
+		}
+		if (new_points.size() == 0)
+			return;
+
+		// the extended point list may have been computed before
+		DistanceMatrixCache& cache = DistanceMatrixCache::getInstance();
+		const bool use_cache = cache.isEnabled();
+		boost::uint64_t cache_key = 0;
+		cv::Mat extended_distance_matrix;
+		if (use_cache == true)
 		{
-			//std::cout << "  a=" << a << "   b=" << b << std::endl;
-			if (points.size()>500 && i%(std::max(1,(int)points.size()/100))==0)
-				std::cout << "." << std::flush;
-			//cv::Point current_center = downsampling_factor * points[i];
-			for (int j = 0; j < points.size(); j++)
+			cache_key = DistanceMatrixCache::computeKey(getMapHash(original_map), extended_points, downsampling_factor, robot_radius, map_resolution, (backend_==DISTANCE_MATRIX_ROOM_GRAPH ? DISTANCE_MATRIX_ASTAR : backend_));
+			if (cache.lookup(cache_key, extended_distance_matrix) == true)
 			{
-				if (j != i)
-				{
-					if (j > i) //only compute upper right triangle of matrix, rest is symmetrically added
-					{
-						if (abort_computation_==true)
-							return;
-
-						// try first with direct connecting line (often sufficient and a significant speedup over A*)
-						cv::LineIterator it(original_map, points[i], points[j]);
-						bool direct_connection = true;
-						for (int k=0; k<it.count && direct_connection==true; k++, ++it)
-							if (**it < 250)
-								direct_connection = false;		// if a pixel in between is not accessible, direct connection is not possible
-						if (direct_connection == true)
-						{
-							// compute distance
-							const double length = cv::norm(points[i]-points[j]);
-							distance_matrix.at<double>(i, j) = length;
-							distance_matrix.at<double>(j, i) = length; //symmetrical-Matrix --> saves half the computation time
-							if (paths!=NULL)
-							{
-								// store path
-								cv::LineIterator it2(original_map, points[i], points[j]);
-								std::vector<cv::Point> current_path(it2.count);
-								for (int k=0; k<it2.count; k++, ++it2)
-									current_path[k] = it2.pos();
-								paths->at(i).at(j) = current_path;
-								paths->at(j).at(i) = current_path;
-							}
-//							++a;
-						}
-						else
-						{
-							// A* path planner
-							if(paths!=NULL)
-							{
-								std::vector<cv::Point> current_path;
-								double length = path_planner.planPath(original_map, downsampled_map, points[i], points[j], downsampling_factor, 0., map_resolution, 0, NULL, &current_path);
-								distance_matrix.at<double>(i, j) = length;
-								distance_matrix.at<double>(j, i) = length; //symmetrical-Matrix --> saves half the computation time
-
-								// remap path points to original map size
-								for(std::vector<cv::Point>::iterator point=current_path.begin(); point!=current_path.end(); ++point)
-								{
-									point->x = point->x/downsampling_factor;
-									point->y = point->y/downsampling_factor;
-								}
-
-								paths->at(i).at(j) = current_path;
-								paths->at(j).at(i) = current_path;
-							}
-							else
-							{
-								double length = path_planner.planPath(original_map, downsampled_map, points[i], points[j], downsampling_factor, 0., map_resolution);
-								distance_matrix.at<double>(i, j) = length;
-								distance_matrix.at<double>(j, i) = length; //symmetrical-Matrix --> saves half the computation time
-
-							}
-//							++b;
-						}
-					}
-				}
-				else
-				{
-					distance_matrix.at<double>(i, j) = 0;
-				}
+				distance_matrix = extended_distance_matrix;
+				points.swap(extended_points);
+				std::cout << "Distance matrix loaded from cache in " << tim.getElapsedTimeInMilliSec() << " ms" << std::endl;
+				return;
 			}
 		}
 
-		std::cout << "\nDistance matrix created in " << tim.getElapsedTimeInMilliSec() << " ms" << std::endl;// "\nDistance matrix:\n" << distance_matrix << std::endl;
+		// copy the known entries and plan the new columns of every row
+		extended_distance_matrix.create((int)extended_points.size(), (int)extended_points.size(), CV_64F);
+		distance_matrix.copyTo(extended_distance_matrix(cv::Rect(0, 0, old_size, old_size)));
+
+		// same downsampled map as in constructDistanceMatrix
+		if (extended_points.size()>500)
+			downsampling_factor *= 0.5;
+		cv::Mat downsampled_map;
+		path_planner.downsampleMap(original_map, downsampled_map, downsampling_factor, robot_radius, map_resolution, map_context_.get());
+
+		if (computeDistanceMatrixRows(extended_distance_matrix, original_map, downsampled_map, extended_points, downsampling_factor, map_resolution, path_planner, NULL, old_size) == false)
+			return;
+
+		if (use_cache == true)
+			cache.store(cache_key, extended_distance_matrix);
+
+		distance_matrix = extended_distance_matrix;
+		points.swap(extended_points);
+		std::cout << "\nDistance matrix extended in " << tim.getElapsedTimeInMilliSec() << " ms" << std::endl;
+	}
+
+	//Removes the points with the given indices from points and the respective rows and columns from the distance matrix, no path
+	//is planned. The remaining points keep their order. The entries are kept even if the speed up trick for more than 500 points
+	//would be switched off for the remaining points.
+	void removePoints(cv::Mat& distance_matrix, std::vector<cv::Point>& points, const std::vector<int>& removed_indices)
+	{
+		std::vector<bool> remove_entry(points.size(), false);
+		for (size_t k=0; k<removed_indices.size(); ++k)
+			if (removed_indices[k]>=0 && removed_indices[k]<(int)points.size())
+				remove_entry[removed_indices[k]] = true;
+		std::vector<int> kept_indices;
+		for (size_t i=0; i<remove_entry.size(); ++i)
+			if (remove_entry[i] == false)
+				kept_indices.push_back((int)i);
+		if (kept_indices.size() == points.size())
+			return;
+
+		cv::Mat reduced_distance_matrix((int)kept_indices.size(), (int)kept_indices.size(), CV_64F);
+		std::vector<cv::Point> reduced_points(kept_indices.size());
+		for (size_t i=0; i<kept_indices.size(); ++i)
+		{
+			reduced_points[i] = points[kept_indices[i]];
+			const double* row = distance_matrix.ptr<double>(kept_indices[i]);
+			double* reduced_row = reduced_distance_matrix.ptr<double>((int)i);
+			for (size_t j=0; j<kept_indices.size(); ++j)
+				reduced_row[j] = row[kept_indices[j]];
+		}
+		distance_matrix = reduced_distance_matrix;
+		points.swap(reduced_points);
+	}
+
+	// versions of addPoints and removePoints that also update the cleaned distance matrix and cleaned_index_to_original_index_mapping,
+	// which then maps to the indices of the updated distance_matrix (see cleanDistanceMatrix), the cleaning itself plans no paths
+	void addPoints(cv::Mat& distance_matrix, std::vector<cv::Point>& points, const std::vector<cv::Point>& new_points,
+			const cv::Mat& original_map, double downsampling_factor, double robot_radius, double map_resolution, AStarPlanner& path_planner,
+			cv::Mat& distance_matrix_cleaned, std::vector<int>& cleaned_index_to_original_index_mapping)
+	{
+		addPoints(distance_matrix, points, new_points, original_map, downsampling_factor, robot_radius, map_resolution, path_planner);
+		cleanDistanceMatrix(distance_matrix, distance_matrix_cleaned, cleaned_index_to_original_index_mapping);
+	}
+
+	void removePoints(cv::Mat& distance_matrix, std::vector<cv::Point>& points, const std::vector<int>& removed_indices,
+			cv::Mat& distance_matrix_cleaned, std::vector<int>& cleaned_index_to_original_index_mapping)
+	{
+		removePoints(distance_matrix, points, removed_indices);
+		cleanDistanceMatrix(distance_matrix, distance_matrix_cleaned, cleaned_index_to_original_index_mapping);
 	}
 
 	// check whether distance matrix contains infinite path lengths and if this is true, create a new distance matrix with maximum size clique of reachable points
 	// cleaned_index_to_original_index_mapping --> maps the indices of the cleaned distance_matrix to the original indices of the original distance_matrix
-	void cleanDistanceMatrix(const cv::Mat& distance_matrix, cv::Mat& distance_matrix_cleaned, std::map<int,int>& cleaned_index_to_original_index_mapping)
+	// The points are grouped into the connected components of the graph of finite path lengths and the largest component is kept (on
+	// equal size the one whose largest index is smallest). Since reachability is transitive, the entries within this component are
+	// finite, which yields the same result as removing the point with the most infinite entries one at a time. Should the matrix
+	// still contain infinite entries within the component (e.g. a path that was not found on the downsampled map), these points are
+	// removed in exactly that manner, with incrementally updated counts. Both steps need O(N^2) time.
+	void cleanDistanceMatrix(const cv::Mat& distance_matrix, cv::Mat& distance_matrix_cleaned, std::vector<int>& cleaned_index_to_original_index_mapping)
 	{
 		// standard: use a 1:1 mapping (input = output)
-		cleaned_index_to_original_index_mapping.clear();
+		cleaned_index_to_original_index_mapping.resize(distance_matrix.rows);
 		for (int i=0; i<distance_matrix.rows; ++i)
 			cleaned_index_to_original_index_mapping[i] = i;
 		distance_matrix_cleaned = distance_matrix.clone();
@@ -147,51 +628,80 @@ public:
 			return;
 
 		const double max_length = 1e90;
-
-		std::vector<bool> remove_entry(distance_matrix.rows, false);	// keeps track on which entries of distance_matrix need to be removed
-
-		// loop until all lines are marked, which need to be removed
-		cv::Mat distance_matrix_temp = distance_matrix.clone();
-		while (true)
+		const int number_points = distance_matrix.rows;
+
+		// connected components of the finite path lengths with a depth-first search
+		std::vector<int> component(number_points, -1);
+		std::vector<int> component_size;
+		std::vector<int> component_max_index;
+		std::vector<int> stack;
+		for (int s=0; s<number_points; ++s)
 		{
-			// count infinite entries in each row of distance matrix
-			std::vector<int> infinite_length_entries(distance_matrix_temp.rows, 0);
-			for (int i=0; i<distance_matrix_temp.rows; ++i)
-				for (int j=0; j<distance_matrix_temp.cols; ++j)
-					if (distance_matrix_temp.at<double>(i,j)>max_length)
-						infinite_length_entries[i]++;
-
-			// sort rows by their number of infinite entries
-			std::multimap<int, int> number_infinite_entries_to_row_index_mapping;	// maps number of infinite entries to the corresponding row index
-			for (size_t i=0; i<infinite_length_entries.size(); ++i)
-				number_infinite_entries_to_row_index_mapping.insert(std::pair<int,int>(infinite_length_entries[i], (int)i));
-
-			// if any row has at least one infinite entry, mark the row with most infinity entries for deletion
-			bool mark_line = false;
-			int mark_index = -1;
-			std::multimap<int, int>::reverse_iterator number_infinite_entries_to_row_index_mapping_last = number_infinite_entries_to_row_index_mapping.rbegin();
-			if (number_infinite_entries_to_row_index_mapping_last->first > 0)
-			{
-				mark_line = true;
-				mark_index = number_infinite_entries_to_row_index_mapping_last->second;
-				remove_entry[mark_index] = true;
-			}
-			if (mark_line == true)
+			if (component[s] != -1)
+				continue;
+			const int label = (int)component_size.size();
+			component_size.push_back(0);
+			component_max_index.push_back(s);
+			component[s] = label;
+			stack.push_back(s);
+			while (stack.empty() == false)
 			{
-				for (int j=0; j<distance_matrix_temp.cols; ++j)			// mark row: mark_index
-					distance_matrix_temp.at<double>(mark_index, j) = -1.;
-				for (int i=0; i<distance_matrix_temp.rows; ++i)			// mark col: mark_index
-					distance_matrix_temp.at<double>(i, mark_index) = -1.;
+				const int a = stack.back();
+				stack.pop_back();
+				component_size[label]++;
+				component_max_index[label] = std::max(component_max_index[label], a);
+				const double* row = distance_matrix.ptr<double>(a);
+				for (int b=0; b<number_points; ++b)
+				{
+					if (component[b] == -1 && row[b] <= max_length)
+					{
+						component[b] = label;
+						stack.push_back(b);
+					}
+				}
 			}
-			else
+		}
+		int kept_component = 0;
+		for (int c=1; c<(int)component_size.size(); ++c)
+			if (component_size[c] > component_size[kept_component] ||
+					(component_size[c] == component_size[kept_component] && component_max_index[c] < component_max_index[kept_component]))
+				kept_component = c;
+		std::vector<bool> keep_entry(number_points, false);	// keeps track on which entries of distance_matrix are kept
+		for (int i=0; i<number_points; ++i)
+			keep_entry[i] = (component[i] == kept_component);
+
+		// remove remaining infinite entries within the component: repeatedly remove the point with most infinite entries (the highest
+		// index on equal counts)
+		std::vector<int> infinite_length_entries(number_points, 0);
+		for (int i=0; i<number_points; ++i)
+		{
+			if (keep_entry[i] == false)
+				continue;
+			const double* row = distance_matrix.ptr<double>(i);
+			for (int j=0; j<number_points; ++j)
+				if (keep_entry[j] == true && row[j] > max_length)
+					infinite_length_entries[i]++;
+		}
+		while (true)
+		{
+			int mark_index = -1;
+			for (int i=0; i<number_points; ++i)
+				if (keep_entry[i] == true && infinite_length_entries[i] > 0 && (mark_index == -1 || infinite_length_entries[i] >= infinite_length_entries[mark_index]))
+					mark_index = i;
+			if (mark_index == -1)
 				break;
+			keep_entry[mark_index] = false;
+			for (int i=0; i<number_points; ++i)
+				if (keep_entry[i] == true && distance_matrix.at<double>(i, mark_index) > max_length)
+					infinite_length_entries[i]--;
 		}
 
-		// count entries to remove
-		int number_entries_to_be_removed = 0;
-		for (size_t i=0; i<remove_entry.size(); ++i)
-			if (remove_entry[i] == true)
-				number_entries_to_be_removed++;
+		// collect the kept entries
+		std::vector<int> kept_indices;
+		for (int i=0; i<number_points; ++i)
+			if (keep_entry[i] == true)
+				kept_indices.push_back(i);
+		const int number_entries_to_be_removed = number_points - (int)kept_indices.size();
 
 		// remove elements from distance matrix if necessary
 		if (number_entries_to_be_removed > 0)
@@ -199,49 +709,43 @@ public:
 			std::cout << "  DistanceMatrix::cleanDistanceMatrix: Need to remove " << number_entries_to_be_removed << " elements out of " << distance_matrix.rows << " elements from the distance matrix." << std::endl;
 
 			// setup new distance_matrix
-			const int new_size = distance_matrix.rows - number_entries_to_be_removed;
+			const int new_size = (int)kept_indices.size();
 			if (new_size == 0)
 			{
 				std::cout << "  DistanceMatrix::cleanDistanceMatrix: Warning: Would need to remove all elements of distance_matrix. Aborting." << std::endl;
 				return;
 			}
 			distance_matrix_cleaned.create(new_size, new_size, CV_64F);
-			cleaned_index_to_original_index_mapping.clear();
+			cleaned_index_to_original_index_mapping = kept_indices;
 
 			// fill new distance_matrix
-			int new_index = 0;
-			for (size_t i=0; i<remove_entry.size(); ++i)
+			for (int new_index=0; new_index<new_size; ++new_index)
 			{
-				if (remove_entry[i] == false)
-				{
-					// mapping from new to old indices
-					cleaned_index_to_original_index_mapping[new_index] = (int)i;
-
-					// copy values
-					int new_j = 0;
-					for (size_t j=0; j<remove_entry.size(); ++j)
-					{
-						if (remove_entry[j] == false)
-						{
-							distance_matrix_cleaned.at<double>(new_index, new_j) = distance_matrix.at<double>(i,j);
-							new_j++;
-						}
-					}
-					new_index++;
-				}
+				const double* row = distance_matrix.ptr<double>(kept_indices[new_index]);
+				double* cleaned_row = distance_matrix_cleaned.ptr<double>(new_index);
+				for (int new_j=0; new_j<new_size; ++new_j)
+					cleaned_row[new_j] = row[kept_indices[new_j]];
 			}
-			if (new_index != new_size)
-				std::cout << "##################################################\nDistanceMatrix::cleanDistanceMatrix: Warning: new_index != new_size.\n##################################################" << std::endl;
 		}
 	}
 
+	// version with the former std::map mapping from cleaned to original indices, kept for compatibility
+	void cleanDistanceMatrix(const cv::Mat& distance_matrix, cv::Mat& distance_matrix_cleaned, std::map<int,int>& cleaned_index_to_original_index_mapping)
+	{
+		std::vector<int> mapping;
+		cleanDistanceMatrix(distance_matrix, distance_matrix_cleaned, mapping);
+		cleaned_index_to_original_index_mapping.clear();
+		for (size_t i=0; i<mapping.size(); ++i)
+			cleaned_index_to_original_index_mapping[(int)i] = mapping[i];
+	}
+
 	// calculate the distance matrix and check whether distance matrix contains infinite path lengths and if this is true,
 	// create a new distance matrix with maximum size clique of reachable points
 	// start_node --> provide the original start node to the function, it writes the new start node mapped to the new coordinates into it
 	// cleaned_index_to_original_index_mapping --> maps the indices of the cleaned distance_matrix to the original indices of the original distance_matrix
 	void computeCleanedDistanceMatrix(const cv::Mat& original_map, const std::vector<cv::Point>& points,
 			double downsampling_factor, double robot_radius, double map_resolution, AStarPlanner& path_planner,
-			cv::Mat& distance_matrix, std::map<int,int>& cleaned_index_to_original_index_mapping, int& start_node)
+			cv::Mat& distance_matrix, std::vector<int>& cleaned_index_to_original_index_mapping, int& start_node)
 	{
 		std::cout << "DistanceMatrix::computeCleanedDistanceMatrix: Constructing distance matrix..." << std::endl;
 		// calculate the distance matrix
@@ -253,9 +757,9 @@ public:
 
 		// re-assign the start node to cleaned indices (use 0 if the original start node was removed from distance_matrix_cleaned)
 		int new_start_node = 0;
-		for (std::map<int,int>::iterator it=cleaned_index_to_original_index_mapping.begin(); it!=cleaned_index_to_original_index_mapping.end(); ++it)
-			if (it->second == start_node)
-				new_start_node = it->first;
+		for (size_t i=0; i<cleaned_index_to_original_index_mapping.size(); ++i)
+			if (cleaned_index_to_original_index_mapping[i] == start_node)
+				new_start_node = (int)i;
 		start_node = new_start_node;
 	}
 };
@@ -0,0 +1,138 @@
+/*!
+ *****************************************************************
+ * \file
+ *
+ * \note
+ * Copyright (c) 2026 \n
+ * Fraunhofer Institute for Manufacturing Engineering
+ * and Automation (IPA) \n\n
+ *
+ *****************************************************************
+ *
+ * \note
+ * Project name: Care-O-bot
+ * \note
+ * ROS stack name: autopnp
+ * \note
+ * ROS package name: ipa_building_navigation
+ *
+ * \author
+ * Author: Richard Bormann
+ * \author
+ * Supervised by: Richard Bormann
+ *
+ * \date Date of creation: 10.2026
+ *
+ * \brief
+ *
+ *
+ *****************************************************************
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer. \n
+ * - Redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution. \n
+ * - Neither the name of the Fraunhofer Institute for Manufacturing
+ * Engineering and Automation (IPA) nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission. \n
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License LGPL as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License LGPL for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License LGPL along with this program.
+ * If not, see <http://www.gnu.org/licenses/>.
+ *
+ ****************************************************************/
+
+#pragma once
+
+#include <vector>
+#include <list>
+#include <map>
+#include <string>
+
+#include <opencv2/opencv.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/cstdint.hpp>
+
+// This class stores computed distance matrices under a hash key of all inputs that determine them (map content, downsampling factor,
+// robot radius, map resolution, point list and path length backend). Repeated planning requests on an unchanged building can thus reuse the
+// distance matrix of an earlier request instead of running the path planner again.
+// The matrices are held in memory with a least-recently-used replacement policy. Optionally, they are also written to a directory on disk
+// (one file per key) which is read with memory mapping, so that the cache survives restarts of the servers.
+//
+// There is one process-wide instance (getInstance()), which is used by DistanceMatrix::constructDistanceMatrix. The cache is disabled
+// until configure() is called with a capacity greater than 0 or a disk directory. All functions are thread-safe.
+class DistanceMatrixCache
+{
+protected:
+
+	typedef std::list<std::pair<boost::uint64_t, cv::Mat> > EntryList;
+
+	EntryList entries_;		// cached matrices, the most recently used entry at the front
+	std::map<boost::uint64_t, EntryList::iterator> entry_index_;	// maps the keys to the entries in entries_
+	size_t capacity_;		// maximum number of matrices kept in memory
+	std::string directory_;	// directory of the on-disk store, empty if disabled
+	boost::mutex mutex_;
+
+	DistanceMatrixCache();
+
+	// moves the entry to the front of the list and removes entries exceeding the capacity from the back, mutex_ must be locked
+	void insertInMemory(const boost::uint64_t key, const cv::Mat& matrix);
+
+	std::string getFileName(const boost::uint64_t key) const;
+
+	bool readFromDisk(const boost::uint64_t key, cv::Mat& matrix) const;
+
+	void writeToDisk(const boost::uint64_t key, const cv::Mat& matrix) const;
+
+public:
+
+	// version of the path length computation and of the file format, it is part of every key and file header, so that matrices
+	// stored by an older version are not used anymore. Increase it whenever the planners produce different lengths for the same
+	// inputs or the file layout changes.
+	static const boost::int32_t format_version = 1;
+
+	static DistanceMatrixCache& getInstance();
+
+	// capacity: maximum number of matrices in memory, 0 disables the in-memory cache
+	// directory: directory for the on-disk store, an empty string disables the on-disk store
+	void configure(const size_t capacity, const std::string& directory);
+
+	bool isEnabled();
+
+	// computes the hash of the map content and format_version, which is the first part of every key, so that a map has to be hashed only
+	// once per request (see MapContext::getMapHash)
+	static boost::uint64_t computeMapHash(const cv::Mat& map);
+
+	// computes the key of a distance matrix from the hash of computeMapHash and all other inputs of the computation, tag distinguishes
+	// different kinds of matrices (e.g. the backend or whether only the distances from a single start point are stored)
+	static boost::uint64_t computeKey(const boost::uint64_t map_hash, const std::vector<cv::Point>& points, const double downsampling_factor,
+			const double robot_radius, const double map_resolution, const int tag);
+
+	// same as above, hashes the map on every call
+	static boost::uint64_t computeKey(const cv::Mat& map, const std::vector<cv::Point>& points, const double downsampling_factor,
+			const double robot_radius, const double map_resolution, const int tag);
+
+	// returns true and a copy of the stored matrix if the key is known, the matrix is written into the existing data of
+	// matrix if it already has the right size and type
+	bool lookup(const boost::uint64_t key, cv::Mat& matrix);
+
+	// stores a copy of matrix (CV_64F) under the given key
+	void store(const boost::uint64_t key, const cv::Mat& matrix);
+
+	void clear();
+};
@@ -15,6 +15,10 @@
 #include <ipa_building_navigation/nearest_neighbor_TSP.h>
 #include <ipa_building_navigation/A_star_pathplanner.h>
 #include <ipa_building_navigation/distance_matrix.h>
+#include <ipa_building_navigation/timer.h>
+
+#include <boost/thread/barrier.hpp>
+#include <boost/atomic.hpp>
 
 #pragma once //make sure this header gets included only one time when multiple classes need it in the same project
 			 //regarding to https://en.wikipedia.org/wiki/Pragma_once this is more efficient than #define
@@ -31,6 +35,13 @@
 //		| 5.8 3.3  7.7  0.0  0.0 |
 //		| 1.2 9.0  88.0 0.0  0.0 |
 //		---					   ---
+//
+//In every generation the parent path creates number_children_ children by a random number of node switches or by the
+//inversion of a random interval. The children are not copied: each one is stored as its list of moves and its length is
+//evaluated incrementally with O(1) per move on a working copy of the parent. The children can be evaluated by several threads,
+//each with its own working copy and random number generator. The best child replaces the parent if it is shorter.
+//The evolution stops after min_generations_ generations once the parent has not changed for stagnation_limit_ generations, or
+//when max_generations_ or the time budget is reached.
 
 class GeneticTSPSolver
 {
@@ -39,20 +50,70 @@ protected:
 	//Astar pathplanner to find the pathlengths from cv::Point to cv::Point
 	AStarPlanner pathplanner_;
 
-	//function to get the length of a given path
-	double getPathLength(const cv::Mat& path_length_Matrix, std::vector<int> given_path);
-
-	//function to mutate (randomly change) a given Parent-path
-	std::vector<int> mutatePath(const std::vector<int>& parent_path);
+	//settings of the distance matrices that the solver computes from a map
+	DistanceMatrixSettings distance_matrix_settings_;
 
-	//function that selects the best path from the given paths
-	std::vector<int> getBestPath(const std::vector<std::vector<int> > paths, const cv::Mat& pathlength_Matrix, bool& changed);
+	//function to get the length of a given path
+	double getPathLength(const cv::Mat& path_length_Matrix, const std::vector<int>& given_path);
+
+	// mutation types of the children
+	enum MutationTypes {MUTATION_SWITCH=0, MUTATION_INVERSION=1};
+
+	// parameters of the evolution
+	int number_children_;		// number of children per generation
+	int min_generations_;		// minimal number of generations
+	int stagnation_limit_;		// the evolution stops after this number of generations without improvement (after min_generations_)
+	int max_generations_;		// maximal number of generations, 0 = unlimited
+	double time_budget_;		// maximal computation time in [s], 0 = unlimited
+	int number_of_threads_;		// number of threads that evaluate the children
+
+	// state of the evolution, all paths have path_size_ = number of nodes + 1 entries and start and end at the start node
+	int number_nodes_;
+	int path_size_;
+	std::vector<double> distances_;		// row-major copy of the distance matrix
+	std::vector<int> working_paths_;	// one copy of the parent path per thread, path of thread t starts at t*path_size_
+	std::vector<unsigned int> random_states_;	// random number generator state of each thread
+	std::vector<int> child_mutation_types_;	// MutationTypes of each child
+	std::vector<int> child_move_counts_;	// number of moves of each child
+	std::vector<int> child_moves_;		// position pairs of the moves of all children, moves of child c start at 2*c*max_moves_
+	std::vector<double> child_length_changes_;	// length of each child minus the length of the parent
+	std::vector<int> selected_moves_;	// moves of the child that replaces the parent in this generation
+	int selected_mutation_type_;		// mutation type of this child, -1 if the parent stays
+	int max_moves_;
+	double parent_length_;
+	int number_of_generations_;
+	int stagnation_counter_;
+	bool continue_evolution_;
+	Timer timer_;
+
+	double distance(const int a, const int b) const
+	{
+		return distances_[a*number_nodes_ + b];
+	}
+
+	int randomNumber(unsigned int& state, const int max_value);
+
+	// length changes when switching the nodes at positions i<j or when inverting the interval [i,j] (symmetric matrix)
+	double switchLengthChange(const int* path, const int i, const int j) const;
+	double inversionLengthChange(const int* path, const int i, const int j) const;
+
+	// creates the moves of a child of the parent stored in the working path of the thread and evaluates its length
+	void createChild(const int thread_index, const int child);
+
+	// applies the given moves to path
+	void applyMoves(int* path, const int mutation_type, const int* moves, const int number_moves) const;
+
+	// selects the best child of the generation and decides whether the evolution continues, called by thread 0 only
+	void selectChild();
+
+	// evolution loop of one thread, the threads are synchronized with barrier after the evaluation and after the selection
+	void evolutionWorker(const int thread_index, boost::barrier* barrier);
 
 	void distance_matrix_thread(DistanceMatrix& distance_matrix_computation, cv::Mat& distance_matrix,
 			const cv::Mat& original_map, const std::vector<cv::Point>& points, double downsampling_factor,
 			double robot_radius, double map_resolution, AStarPlanner& path_planner);
 
-	bool abort_computation_;
+	boost::atomic<bool> abort_computation_;	// set by abortComputation from another thread
 
 public:
 	//constructor
@@ -60,6 +121,22 @@ public:
 
 	void abortComputation();
 
+	//number of children per generation (default 8)
+	void setNumberOfChildren(const int number_children);
+
+	//generation budget: the evolution runs at least min_generations generations (default 2300) and stops once the path has not
+	//changed for stagnation_limit generations (default 100) or when max_generations is reached (default 0 = unlimited)
+	void setGenerationBudget(const int min_generations, const int stagnation_limit, const int max_generations);
+
+	//maximal computation time of the evolution in [s], the best path found so far is returned afterwards, <= 0 means no limit
+	void setTimeBudget(const double time_budget);
+
+	//number of threads that evaluate the children of a generation (default 1), pays off only for large problems with many children
+	void setNumberOfThreads(const int number_of_threads);
+
+	//sets the settings of the distance matrices that the solver computes from a map and the search mode of its path planner, see DistanceMatrixSettings
+	void setDistanceMatrixSettings(const DistanceMatrixSettings& settings);
+
 	//Solving-algorithms for the given TSP. It returns a vector of int, which is the order from this solution. The int shows
 	//the index in the Matrix. There are two functions for different cases:
 	//		1. The distance matrix already exists
@@ -80,5 +157,5 @@ public:
 
 	// compute TSP with pre-computed cleaned distance matrix (does not contain any infinity paths)
 	std::vector<int> solveGeneticTSPWithCleanedDistanceMatrix(const cv::Mat& distance_matrix,
-			const std::map<int,int>& cleaned_index_to_original_index_mapping, const int start_node);
+			const std::vector<int>& cleaned_index_to_original_index_mapping, const int start_node);
 };
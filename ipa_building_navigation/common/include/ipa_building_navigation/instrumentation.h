@@ -0,0 +1,319 @@
+/*!
+ *****************************************************************
+ * \file
+ *
+ * \note
+ * Copyright (c) 2026 \n
+ * Fraunhofer Institute for Manufacturing Engineering
+ * and Automation (IPA) \n\n
+ *
+ *****************************************************************
+ *
+ * \note
+ * Project name: Care-O-bot
+ * \note
+ * ROS stack name: autopnp
+ * \note
+ * ROS package name: ipa_building_navigation
+ *
+ * \author
+ * Author: Richard Bormann
+ * \author
+ * Supervised by: Richard Bormann
+ *
+ * \date Date of creation: 10.2026
+ *
+ * \brief
+ *
+ *
+ *****************************************************************
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer. \n
+ * - Redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution. \n
+ * - Neither the name of the Fraunhofer Institute for Manufacturing
+ * Engineering and Automation (IPA) nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission. \n
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License LGPL as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License LGPL for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License LGPL along with this program.
+ * If not, see <http://www.gnu.org/licenses/>.
+ *
+ ****************************************************************/
+
+#pragma once
+
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+#include <map>
+#include <string>
+#include <vector>
+
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/thread.hpp>
+#include <boost/chrono.hpp>
+
+// This class collects timing spans and counters of the planning stages of one process, e.g. segmentation, room center computation,
+// accessibility check, set cover, trolley positions, distance matrix, TSP, cell decomposition and FOV mapping, or the number of A*
+// expansions, raycasts and LP variables.
+// For every stage the number of spans, the total, minimum and maximum duration and a histogram of the durations are kept, and the
+// single spans are recorded for a Chrome trace (chrome://tracing, Perfetto) that can be written with writeChromeTrace.
+//
+// The instrumentation is disabled by default. Then ScopedSpan and addCount only check a flag and neither read the clock nor
+// lock a mutex, so the spans and counters can stay in the code. The servers enable it with a parameter and publish the statistics
+// of each action call with the InstrumentationPublisher (ros/include). All functions are thread-safe.
+//
+// The class is header-only, so that packages like ipa_room_segmentation can use it without linking the libraries of this package.
+// The state is kept in function-local statics, which exist once per process.
+class Instrumentation
+{
+public:
+
+	// statistics of all spans of one stage, durations in [ms]
+	struct StageStatistics
+	{
+		std::string name;
+		long count;
+		double total_duration;
+		double min_duration;
+		double max_duration;
+		std::vector<long> histogram;	// number of spans per bin, see getHistogramBinLimits
+	};
+
+	static void setEnabled(const bool enabled)
+	{
+		enabledFlag() = enabled;
+	}
+
+	static bool isEnabled()
+	{
+		return enabledFlag();
+	}
+
+	// returns the time since the first use of the instrumentation in [us] from a monotonic clock
+	static double now()
+	{
+		return boost::chrono::duration<double, boost::micro>(boost::chrono::steady_clock::now() - getState().start_time).count();
+	}
+
+	// records one span of stage that started at start_time and took duration, both in [us]
+	static void recordSpan(const std::string& stage, const double start_time, const double duration)
+	{
+		const double duration_ms = 0.001*duration;
+		const std::vector<double>& bin_limits = getHistogramBinLimits();
+		const size_t bin = std::upper_bound(bin_limits.begin(), bin_limits.end(), duration_ms) - bin_limits.begin();
+
+		State& state = getState();
+		boost::mutex::scoped_lock lock(state.mutex);
+		std::map<std::string, StageStatistics>::iterator it = state.stages.find(stage);
+		if (it == state.stages.end())
+		{
+			StageStatistics statistics;
+			statistics.name = stage;
+			statistics.count = 0;
+			statistics.total_duration = 0.;
+			statistics.min_duration = duration_ms;
+			statistics.max_duration = duration_ms;
+			statistics.histogram.resize(bin_limits.size()+1, 0);
+			it = state.stages.insert(std::make_pair(stage, statistics)).first;
+		}
+		StageStatistics& statistics = it->second;
+		statistics.count++;
+		statistics.total_duration += duration_ms;
+		statistics.min_duration = std::min(statistics.min_duration, duration_ms);
+		statistics.max_duration = std::max(statistics.max_duration, duration_ms);
+		statistics.histogram[bin]++;
+
+		if (state.trace_events.size() < max_trace_events)
+		{
+			std::map<boost::thread::id, int>::iterator thread_it = state.thread_indices.find(boost::this_thread::get_id());
+			if (thread_it == state.thread_indices.end())
+				thread_it = state.thread_indices.insert(std::make_pair(boost::this_thread::get_id(), (int)state.thread_indices.size())).first;
+			TraceEvent event;
+			event.name = stage;
+			event.thread = thread_it->second;
+			event.start_time = start_time;
+			event.duration = duration;
+			state.trace_events.push_back(event);
+		}
+	}
+
+	// adds value to counter, the name is only converted into a string if the instrumentation is enabled
+	static void addCount(const char* counter, const long value)
+	{
+		if (isEnabled() == true)
+		{
+			State& state = getState();
+			boost::mutex::scoped_lock lock(state.mutex);
+			state.counters[counter] += value;
+		}
+	}
+
+	// removes all recorded spans and counters, e.g. at the start of an action call
+	static void reset()
+	{
+		State& state = getState();
+		boost::mutex::scoped_lock lock(state.mutex);
+		state.stages.clear();
+		state.counters.clear();
+		state.trace_events.clear();
+	}
+
+	// upper limits of the histogram bins in [ms], the last bin collects all longer spans
+	static const std::vector<double>& getHistogramBinLimits()
+	{
+		// logarithmic bins from 1 ms to 100 s
+		static const double limits[] = {1., 3., 10., 30., 100., 300., 1000., 3000., 10000., 30000., 100000.};
+		static const std::vector<double> bin_limits(limits, limits + sizeof(limits)/sizeof(double));
+		return bin_limits;
+	}
+
+	// returns the statistics of all stages, ordered by the stage name
+	static void getStageStatistics(std::vector<StageStatistics>& statistics)
+	{
+		State& state = getState();
+		boost::mutex::scoped_lock lock(state.mutex);
+		statistics.clear();
+		for (std::map<std::string, StageStatistics>::const_iterator it=state.stages.begin(); it!=state.stages.end(); ++it)
+			statistics.push_back(it->second);
+	}
+
+	// returns the values of all counters
+	static void getCounters(std::map<std::string, long>& counters)
+	{
+		State& state = getState();
+		boost::mutex::scoped_lock lock(state.mutex);
+		counters = state.counters;
+	}
+
+	// writes the recorded spans and the final counter values as Chrome trace event JSON file, returns false if the file cannot be written
+	static bool writeChromeTrace(const std::string& filename)
+	{
+		std::ofstream file(filename.c_str());
+		if (file.is_open() == false)
+			return false;
+
+		State& state = getState();
+		boost::mutex::scoped_lock lock(state.mutex);
+		file << std::fixed << std::setprecision(3);
+		file << "{\"traceEvents\":[";
+		double end_time = 0.;
+		for (size_t i=0; i<state.trace_events.size(); ++i)
+		{
+			const TraceEvent& event = state.trace_events[i];
+			file << (i>0 ? ",\n" : "\n") << "{\"name\":\"" << escapeJson(event.name) << "\",\"cat\":\"stage\",\"ph\":\"X\",\"pid\":1,\"tid\":" << event.thread
+					<< ",\"ts\":" << event.start_time << ",\"dur\":" << event.duration << "}";
+			end_time = std::max(end_time, event.start_time + event.duration);
+		}
+		// the counters are shown with their final values at the end of the trace
+		for (std::map<std::string, long>::const_iterator it=state.counters.begin(); it!=state.counters.end(); ++it)
+		{
+			file << (state.trace_events.size()>0 || it!=state.counters.begin() ? ",\n" : "\n") << "{\"name\":\"" << escapeJson(it->first)
+					<< "\",\"cat\":\"counter\",\"ph\":\"C\",\"pid\":1,\"tid\":0,\"ts\":" << end_time << ",\"args\":{\"value\":" << it->second << "}}";
+		}
+		file << "\n],\"displayTimeUnit\":\"ms\"}" << std::endl;
+		return file.good();
+	}
+
+protected:
+
+	struct TraceEvent
+	{
+		std::string name;
+		int thread;
+		double start_time;	// [us]
+		double duration;	// [us]
+	};
+
+	// recorded data of the process
+	struct State
+	{
+		boost::mutex mutex;
+		std::map<std::string, StageStatistics> stages;
+		std::map<std::string, long> counters;
+		std::vector<TraceEvent> trace_events;
+		std::map<boost::thread::id, int> thread_indices;	// maps the threads to small numbers for the trace
+		boost::chrono::steady_clock::time_point start_time;	// reference point of the trace time stamps
+
+		State()
+		: start_time(boost::chrono::steady_clock::now())
+		{
+		}
+	};
+
+	static const size_t max_trace_events = 1000000;	// further spans only enter the statistics, not the trace
+
+	static volatile bool& enabledFlag()
+	{
+		static volatile bool enabled = false;
+		return enabled;
+	}
+
+	static State& getState()
+	{
+		static State state;
+		return state;
+	}
+
+	// escapes a name for a JSON string
+	static std::string escapeJson(const std::string& name)
+	{
+		std::string escaped;
+		for (size_t i=0; i<name.size(); ++i)
+		{
+			if (name[i] == '"' || name[i] == '\\')
+				escaped += '\\';
+			escaped += name[i];
+		}
+		return escaped;
+	}
+};
+
+// measures the duration of a stage from its construction to its destruction or the call of stop()
+// if the instrumentation is disabled at construction, the span does nothing
+class ScopedSpan
+{
+protected:
+
+	const char* stage_;		// NULL if the span does not record
+	double start_time_;		// [us]
+
+public:
+
+	explicit ScopedSpan(const char* stage)
+	: stage_(Instrumentation::isEnabled() ? stage : NULL), start_time_(0.)
+	{
+		if (stage_ != NULL)
+			start_time_ = Instrumentation::now();
+	}
+
+	~ScopedSpan()
+	{
+		stop();
+	}
+
+	// ends the span before the end of the scope
+	void stop()
+	{
+		if (stage_ != NULL)
+			Instrumentation::recordSpan(stage_, start_time_, Instrumentation::now() - start_time_);
+		stage_ = NULL;
+	}
+};
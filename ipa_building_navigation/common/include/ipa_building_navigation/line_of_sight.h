@@ -0,0 +1,97 @@
+/*!
+ *****************************************************************
+ * \file
+ *
+ * \note
+ * Copyright (c) 2026 \n
+ * Fraunhofer Institute for Manufacturing Engineering
+ * and Automation (IPA) \n\n
+ *
+ *****************************************************************
+ *
+ * \note
+ * Project name: Care-O-bot
+ * \note
+ * ROS stack name: autopnp
+ * \note
+ * ROS package name: ipa_building_navigation
+ *
+ * \author
+ * Author: Richard Bormann
+ * \author
+ * Supervised by: Richard Bormann
+ *
+ * \date Date of creation: 10.2026
+ *
+ * \brief
+ *
+ *
+ *****************************************************************
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer. \n
+ * - Redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution. \n
+ * - Neither the name of the Fraunhofer Institute for Manufacturing
+ * Engineering and Automation (IPA) nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission. \n
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License LGPL as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License LGPL for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License LGPL along with this program.
+ * If not, see <http://www.gnu.org/licenses/>.
+ *
+ ****************************************************************/
+
+#pragma once
+
+#include <vector>
+
+#include <opencv2/opencv.hpp>
+
+// This class checks the direct line of sight between pixels of an occupancy grid map (CV_8UC1). A line is free if all of its pixels
+// have a value of at least free_threshold. The lines contain the same pixels as an 8-connected cv::LineIterator from start to goal,
+// including the clipping at the image borders, but they are traversed with a branch-free integer Bresenham step directly on the
+// pixel buffer and the traversal stops at the first blocked pixel.
+//
+// Optionally a distance field (see computeDistanceField) can be provided, which stores the distance of each pixel to the closest
+// blocked pixel. The traversal then jumps over all line pixels that lie within this distance, which makes long lines through open
+// space much cheaper. The result is identical with and without distance field.
+//
+// checkVisibility adds its number of lines to the "raycasts" counter of the Instrumentation once per call. isFree does not count, so
+// that it does not lock the instrumentation mutex per line, callers add the number of their lines once after a loop.
+class LineOfSight
+{
+public:
+
+	// computes the distance field for map (CV_32FC1, exact L2 distance in [pixel] of each pixel to the closest pixel below
+	// free_threshold, 0 for blocked pixels)
+	static void computeDistanceField(const cv::Mat& map, cv::Mat& distance_field, const uchar free_threshold=1);
+
+	// returns true if all pixels of the line from start to goal have a value >= free_threshold
+	// distance_field has to be computed with the same free_threshold from map, or be NULL
+	static bool isFree(const cv::Mat& map, const cv::Point& start, const cv::Point& goal, const uchar free_threshold=1,
+			const cv::Mat* distance_field=NULL);
+
+	// checks the lines from start to each of the goals, visible[g] is true if the line to goals[g] is free
+	// if start itself is blocked, no line is traversed
+	static void checkVisibility(const cv::Mat& map, const cv::Point& start, const std::vector<cv::Point>& goals,
+			std::vector<bool>& visible, const uchar free_threshold=1, const cv::Mat* distance_field=NULL);
+
+	// writes the pixels of the line from start to goal into line_pixels, in the same order as cv::LineIterator
+	static void getLine(const cv::Mat& map, const cv::Point& start, const cv::Point& goal, std::vector<cv::Point>& line_pixels);
+};
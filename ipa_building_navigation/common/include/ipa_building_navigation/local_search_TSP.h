@@ -0,0 +1,178 @@
+/*!
+ *****************************************************************
+ * \file
+ *
+ * \note
+ * Copyright (c) 2026 \n
+ * Fraunhofer Institute for Manufacturing Engineering
+ * and Automation (IPA) \n\n
+ *
+ *****************************************************************
+ *
+ * \note
+ * Project name: Care-O-bot
+ * \note
+ * ROS stack name: autopnp
+ * \note
+ * ROS package name: ipa_building_navigation
+ *
+ * \author
+ * Author: Richard Bormann
+ * \author
+ * Supervised by: Richard Bormann
+ *
+ * \date Date of creation: 10.2026
+ *
+ * \brief
+ *
+ *
+ *****************************************************************
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer. \n
+ * - Redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution. \n
+ * - Neither the name of the Fraunhofer Institute for Manufacturing
+ * Engineering and Automation (IPA) nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission. \n
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License LGPL as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License LGPL for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License LGPL along with this program.
+ * If not, see <http://www.gnu.org/licenses/>.
+ *
+ ****************************************************************/
+
+
+#pragma once
+
+#include <vector>
+#include <opencv2/opencv.hpp>
+#include <boost/atomic.hpp>
+
+#include <ipa_building_navigation/timer.h>
+#include <ipa_building_navigation/sparse_distance_matrix.h>
+
+// This class solves a symmetric TSP in-process with local search on a given distance matrix (CV_64F).
+// Starting from a nearest neighbor tour or a given tour, the tour is improved with 2-opt and Or-opt moves (segments of up to three nodes, inserted
+// in both orientations). Only moves towards the nearest neighbors of each node are evaluated and don't-look bits restrict the search
+// to nodes whose surrounding has changed. Local optima are left with local double-bridge kicks (iterated local search, as in chained
+// Lin-Kernighan), which improves the tour further until the time budget or the maximum number of kicks is used up.
+// Problems with up to 8 nodes are solved exactly.
+//
+// The solver also accepts a SparseDistanceMatrix, then the neighbor lists are taken from the stored neighbors and path lengths of
+// other pairs are requested from it on demand, so that the memory stays linear in the number of nodes.
+//
+// The result is a closed tour, i.e. the returned order ends with the node before start_node.
+class LocalSearchTSPSolver
+{
+protected:
+
+	int number_nodes_;
+	std::vector<double> distances_;		// row-major copy of the distance matrix
+	const SparseDistanceMatrix* sparse_distances_;	// sparse distance matrix, replaces distances_ if not NULL
+	std::vector<std::vector<int> > neighbors_;	// nearest neighbors of each node, sorted by distance
+	std::vector<int> tour_;			// current tour
+	std::vector<int> position_;		// position of each node in tour_
+	std::vector<bool> dont_look_;		// don't-look bit of each node
+	std::vector<int> active_nodes_;		// nodes whose don't-look bit has been reset
+	double tour_length_;			// length of tour_
+	unsigned int random_state_;
+	Timer timer_;
+
+	boost::atomic<bool> abort_computation_;	// set by abortComputation from another thread
+	double time_budget_;		// [s]
+	int max_kicks_per_node_;
+	int number_neighbors_;
+
+	double distance(const int a, const int b) const
+	{
+		if (sparse_distances_ != NULL)
+			return sparse_distances_->getDistance(a, b);
+		return distances_[a*number_nodes_ + b];
+	}
+
+	int next(const int node) const
+	{
+		return tour_[(position_[node]+1 == number_nodes_ ? 0 : position_[node]+1)];
+	}
+
+	int previous(const int node) const
+	{
+		return tour_[(position_[node] == 0 ? number_nodes_-1 : position_[node]-1)];
+	}
+
+	int randomNumber(const int max_value);
+
+	double tourLength() const;
+
+	bool isBudgetExceeded();
+
+	void computeNeighborLists();
+
+	void computeNearestNeighborTour(const int start_node);
+
+	void activateNode(const int node);
+
+	// reverses the tour between the nodes from and to (in tour direction), the shorter side of the tour is reversed
+	void reversePath(const int from, const int to);
+
+	// tries to find an improving 2-opt move starting at node, applies it and returns true if successful
+	bool improveTwoOpt(const int node);
+
+	// tries to find an improving Or-opt move of a segment that starts or ends at node, applies it and returns true if successful
+	bool improveOrOpt(const int node);
+
+	// moves the segment from segment_first to segment_last between the neighboring nodes insert_after and next(insert_after)
+	void moveSegment(const int segment_first, const int segment_last, const int insert_after, const bool reversed);
+
+	// runs the local search until no more improving moves exist for the active nodes, returns false if aborted
+	bool localSearch();
+
+	// applies a random double-bridge move to a part of the tour
+	void kick();
+
+	// computes the tour on the distances that have been set up by the solve functions, starts the local search from initial_tour
+	// if it is not NULL and from the nearest neighbor tour otherwise
+	std::vector<int> solve(const int start_node, const std::vector<int>* initial_tour=NULL);
+
+public:
+
+	LocalSearchTSPSolver();
+
+	void abortComputation();
+
+	// maximum computation time in [s], the best tour found so far is returned when it has been used up, <= 0 means no limit
+	void setTimeBudget(const double time_budget);
+
+	// the iterated local search stops after max_kicks_per_node*number of nodes kicks
+	void setMaxKicksPerNode(const int max_kicks_per_node);
+
+	// number of nearest neighbors of each node considered by the moves
+	void setNumberOfNeighbors(const int number_neighbors);
+
+	// solves the TSP on the symmetric distance matrix and returns the order of the nodes starting with start_node,
+	// returns an empty order if the computation has been aborted
+	std::vector<int> solveLocalSearchTSP(const cv::Mat& path_length_matrix, const int start_node);
+
+	// improves the given tour through all nodes of the distance matrix, the returned order starts with initial_tour[0] and is never
+	// longer than initial_tour, returns an empty order if initial_tour does not visit every node once or the computation has been aborted
+	std::vector<int> solveLocalSearchTSP(const cv::Mat& path_length_matrix, const std::vector<int>& initial_tour);
+
+	// solves the TSP on a sparse distance matrix, see SparseDistanceMatrix
+	std::vector<int> solveLocalSearchTSP(const SparseDistanceMatrix& distance_matrix, const int start_node);
+};
@@ -0,0 +1,122 @@
+/*!
+ *****************************************************************
+ * \file
+ *
+ * \note
+ * Copyright (c) 2026 \n
+ * Fraunhofer Institute for Manufacturing Engineering
+ * and Automation (IPA) \n\n
+ *
+ *****************************************************************
+ *
+ * \note
+ * Project name: Care-O-bot
+ * \note
+ * ROS stack name: autopnp
+ * \note
+ * ROS package name: ipa_building_navigation
+ *
+ * \author
+ * Author: Richard Bormann
+ * \author
+ * Supervised by: Richard Bormann
+ *
+ * \date Date of creation: 10.2026
+ *
+ * \brief
+ *
+ *
+ *****************************************************************
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer. \n
+ * - Redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution. \n
+ * - Neither the name of the Fraunhofer Institute for Manufacturing
+ * Engineering and Automation (IPA) nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission. \n
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License LGPL as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License LGPL for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License LGPL along with this program.
+ * If not, see <http://www.gnu.org/licenses/>.
+ *
+ ****************************************************************/
+
+#pragma once
+
+#include <map>
+
+#include <opencv2/opencv.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/cstdint.hpp>
+
+// This class holds the preprocessed versions of one floor plan that the planners of an action call need: eroded maps, the eroded and
+// downsampled maps of AStarPlanner::downsampleMap and a distance transform. Each version is computed on its first request and then
+// shared read-only, so that the full-map morphology is done once per action call instead of once per planner call.
+//
+// The servers create a context for the floor plan of each request and pass it explicitly to the planners of this request, e.g. with
+// DistanceMatrixSettings::map_context, AStarPlanner::downsampleMap or TrolleyPositionFinder::setMapContext. The planners only use the
+// context for maps that share their pixel buffer with the context's map (see isValidFor). The returned maps are shared read-only
+// and must not be modified, AStarPlanner::downsampleMap hands out copies. The map must not be modified while the context is in use.
+// All functions are thread-safe.
+class MapContext
+{
+protected:
+
+	cv::Mat map_;					// original map (CV_8UC1, 255 = accessible), shares the data with the map of the request
+	double robot_radius_;			// [m]
+	double map_resolution_;			// [m/pixel]
+
+	mutable boost::mutex mutex_;
+	mutable std::map<int, cv::Mat> eroded_maps_;			// maps the number of 3x3 erosions to the eroded map
+	mutable std::map<double, cv::Mat> downsampled_maps_;	// maps the downsampling factor to the eroded and downsampled map
+	mutable cv::Mat distance_map_;
+	mutable bool map_hash_computed_;
+	mutable boost::uint64_t map_hash_;
+
+	// computes or looks up the eroded map, mutex_ has to be locked
+	const cv::Mat& erodedMap(const int iterations) const;
+
+public:
+
+	MapContext(const cv::Mat& map, const double robot_radius, const double map_resolution);
+
+	// checks whether map shares its pixel buffer with the map of this context
+	bool isValidFor(const cv::Mat& map) const;
+
+	// checks additionally whether the robot radius and map resolution match, as required by getDownsampledMap
+	bool isValidFor(const cv::Mat& map, const double robot_radius, const double map_resolution) const;
+
+	const cv::Mat& getMap() const
+	{
+		return map_;
+	}
+
+	// returns the map eroded iterations times with a 3x3 kernel, like cv::erode(map, eroded_map, cv::Mat(), cv::Point(-1,-1), iterations)
+	const cv::Mat& getErodedMap(const int iterations) const;
+
+	// returns the map eroded by the robot radius and downsampled with downsampling_factor, identical to AStarPlanner::downsampleMap
+	const cv::Mat& getDownsampledMap(const double downsampling_factor) const;
+
+	// returns the distance transform (CV_32FC1, L2) of the map eroded once, i.e. the distance of each pixel to the closest obstacle
+	const cv::Mat& getDistanceMap() const;
+
+	// returns DistanceMatrixCache::computeMapHash of the map, so that the cache keys of a request do not hash the map again
+	boost::uint64_t getMapHash() const;
+};
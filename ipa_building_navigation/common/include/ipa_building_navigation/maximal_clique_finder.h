@@ -6,6 +6,7 @@
 #include <ctime>
 #include <cstdlib>
 #include <stdio.h>
+#include <algorithm>
 
 #include <opencv2/opencv.hpp>
 #include <opencv2/highgui/highgui.hpp>
@@ -14,15 +15,13 @@
 
 #include <ipa_building_navigation/contains.h>
 
-#include <boost/graph/graph_traits.hpp>
-#include <boost/graph/undirected_graph.hpp>
-#include <boost/graph/bron_kerbosch_all_cliques.hpp>
+#include <boost/dynamic_bitset.hpp>
 
 #pragma once //make sure this header gets included only one time when multiple classes need it in the same project
 			 //regarding to https://en.wikipedia.org/wiki/Pragma_once this is more efficient than #define
 
-//This algorithm provides a class that finds all maximal cliques in a given graph. It uses the Bron-Kerbosch Implementation
-//in Boost to do this. As input a symmetrical distance-Matrix is needed that shows the pathlenghts from one node to another.
+//This algorithm provides a class that finds all maximal cliques in a given graph. It uses the Bron-Kerbosch algorithm with
+//pivoting on a bitset adjacency representation of the graph to do this. As input a symmetrical distance-Matrix is needed that shows the pathlenghts from one node to another.
 //If the path from one node to another doesn't exist, the entry in the matrix must be 0 or smaller. so the format for this
 //Matrix is:
 // row: node to start from, column: node to go to
@@ -51,16 +50,14 @@
 class cliqueFinder
 {
 protected:
-	//function that allows to add a Vertex with a name to a boost::Graph. See boosts helper.hpp ( http://www.boost.org/doc/libs/1_47_0/libs/graph/example/helper.hpp ) for explanation
-	template<typename Graph, typename NameMap, typename VertexMap>
-	typename boost::graph_traits<Graph>::vertex_descriptor addNamedVertex(Graph& g, NameMap nm, const std::string& name, VertexMap& vm);
+	//function to create the adjacency of the graph out of the given distance matrix, two nodes are connected if their pathlength
+	//is greater than 0 and not greater than maxval
+	void createAdjacency(const cv::Mat& distance_matrix, double maxval, std::vector<boost::dynamic_bitset<> >& adjacency);
 
-	//function to create a graph out of the given distanceMatrix
-	template<typename Graph>
-	void createGraph(Graph& graph, cv::Mat& distance_Matrix);
-
-	//function to set too long paths in the distance_matrix to zero
-	void cutTooLongEdges(cv::Mat& complete_distance_matrix, double maxval);
+	//recursive Bron-Kerbosch step with Tomita pivoting: clique contains the current clique, candidates the nodes that can extend it
+	//and excluded the nodes that have already been tried, every found maximal clique is added to cliques
+	void expandClique(std::vector<int>& clique, boost::dynamic_bitset<> candidates, boost::dynamic_bitset<> excluded,
+			const std::vector<boost::dynamic_bitset<> >& adjacency, std::vector<std::vector<int> >& cliques);
 
 public:
 	cliqueFinder();
@@ -14,6 +14,7 @@
 #include <ipa_building_navigation/contains.h>
 #include <ipa_building_navigation/A_star_pathplanner.h>
 #include <ipa_building_navigation/distance_matrix.h>
+#include <ipa_building_navigation/sparse_distance_matrix.h>
 
 #pragma once //make sure this header gets included only one time when multiple classes need it in the same project
 			 //regarding to https://en.wikipedia.org/wiki/Pragma_once this is more efficient than #define
@@ -38,6 +39,9 @@ protected:
 	//Astar pathplanner to find the pathlengths from cv::Point to cv::Point
 	AStarPlanner pathplanner_;
 
+	//settings of the distance matrices that the solver computes from a map
+	DistanceMatrixSettings distance_matrix_settings_;
+
 //	//Function to construct the distance matrix, showing the pathlength from node to node
 //	void NearestNeighborTSPSolver::constructDistanceMatrix(cv::Mat& distance_matrix, const cv::Mat& original_map,
 //			const std::vector<cv::Point>& points, double downsampling_factor, double robot_radius, double map_resolution);
@@ -46,6 +50,9 @@ public:
 	//constructor
 	NearestNeighborTSPSolver();
 
+	//sets the settings of the distance matrices that the solver computes from a map and the search mode of its path planner, see DistanceMatrixSettings
+	void setDistanceMatrixSettings(const DistanceMatrixSettings& settings);
+
 	//Solving-algorithms for the given TSP. It returns a vector of int, which is the order from this solution. The int shows
 	//the index in the Matrix. There are two functions for different cases:
 	//		1. The distance matrix already exists
@@ -54,6 +61,9 @@ public:
 	//with given distance matrix
 	std::vector<int> solveNearestTSP(const cv::Mat& path_length_matrix, const int start_node); //with given distance matrix
 
+	//with given sparse distance matrix, the next node is taken from the stored neighbors of the current node (see SparseDistanceMatrix)
+	std::vector<int> solveNearestTSP(const SparseDistanceMatrix& distance_matrix, const int start_node);
+
 	// compute TSP and distance matrix without cleaning it
 	// this version does not exclude infinite paths from the TSP ordering
 	std::vector<int> solveNearestTSP(const cv::Mat& original_map, const std::vector<cv::Point>& points, double downsampling_factor,
@@ -65,5 +75,5 @@ public:
 
 	// compute TSP with pre-computed cleaned distance matrix (does not contain any infinity paths)
 	std::vector<int> solveNearestTSPWithCleanedDistanceMatrix(const cv::Mat& distance_matrix,
-			const std::map<int,int>& cleaned_index_to_original_index_mapping, const int start_node);
+			const std::vector<int>& cleaned_index_to_original_index_mapping, const int start_node);
 };
@@ -0,0 +1,152 @@
+/*!
+ *****************************************************************
+ * \file
+ *
+ * \note
+ * Copyright (c) 2026 \n
+ * Fraunhofer Institute for Manufacturing Engineering
+ * and Automation (IPA) \n\n
+ *
+ *****************************************************************
+ *
+ * \note
+ * Project name: Care-O-bot
+ * \note
+ * ROS stack name: autopnp
+ * \note
+ * ROS package name: ipa_building_navigation
+ *
+ * \author
+ * Author: Richard Bormann
+ * \author
+ * Supervised by: Richard Bormann
+ *
+ * \date Date of creation: 10.2026
+ *
+ * \brief
+ *
+ *
+ *****************************************************************
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer. \n
+ * - Redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution. \n
+ * - Neither the name of the Fraunhofer Institute for Manufacturing
+ * Engineering and Automation (IPA) nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission. \n
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License LGPL as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License LGPL for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License LGPL along with this program.
+ * If not, see <http://www.gnu.org/licenses/>.
+ *
+ ****************************************************************/
+
+#pragma once
+
+#include <vector>
+
+#include <opencv2/opencv.hpp>
+#include <boost/cstdint.hpp>
+
+#include <ipa_building_navigation/A_star_pathplanner.h>
+#include <ipa_building_navigation/wavefront_planner.h>
+
+// This class provides a hierarchical path planner (in the spirit of HPA*) on top of a room segmentation of the map.
+// The accessible cells of the eroded and downsampled map are divided into regions, which are the connected parts of the rooms of the
+// segmented map (cells without room label form regions of their own). Wherever two regions touch, a door is created that consists of
+// one node on each side. Within each region the path lengths between all of its door nodes are precomputed with region-restricted
+// wavefronts, which yields a small abstract graph of the building.
+// A path length query between two points then only needs a local search inside the start and goal rooms and a Dijkstra search on the
+// abstract graph. Since paths are forced through the door nodes, the lengths can be slightly longer than the A* path lengths.
+//
+// All lengths are measured in pixels of the original map, like the results of AStarPlanner::planPath. Unreachable pairs get 1e100.
+class RoomGraphPlanner
+{
+protected:
+
+	cv::Mat downsampled_map_;	// eroded and downsampled map, accessible cells = 255
+	cv::Mat region_map_;		// region index of each cell of downsampled_map_ (CV_32SC1), -1 for inaccessible cells
+	int number_regions_;
+
+	std::vector<cv::Point> node_cells_;		// cell of each door node in downsampled_map_
+	std::vector<int> node_regions_;			// region of each door node
+	std::vector<std::vector<int> > region_nodes_;	// door nodes of each region
+	std::vector<std::vector<std::pair<int, double> > > adjacency_;	// edges of the abstract graph (neighbor node, length in [cells])
+
+	// parameters of the map the graph has been built for
+	double downsampling_factor_;
+	double robot_radius_;
+	double map_resolution_;
+	boost::uint64_t map_key_;	// hash of the map, see DistanceMatrixCache::computeMapHash
+	boost::uint64_t graph_key_;	// hash of the map and the segmentation
+
+	// divides the accessible cells into regions of equal room label
+	void computeRegions(const cv::Mat& downsampled_segmented_map);
+
+	// creates the door nodes at the region boundaries
+	void computeDoors();
+
+	// computes the door to door path lengths within each region
+	void computeIntraRegionEdges();
+
+	// runs a wavefront from cell inside its region and returns the lengths to the door nodes of that region and to the target cells
+	void searchRegion(WavefrontPlanner& wavefront_planner, const cv::Point& cell, const int region, const std::vector<cv::Point>& target_cells,
+			std::vector<double>& node_lengths, std::vector<double>& target_lengths) const;
+
+	// Dijkstra search on the abstract graph, node_lengths contains the initial lengths and receives the shortest lengths to all nodes
+	void searchGraph(std::vector<double>& node_lengths) const;
+
+	cv::Point toCell(const cv::Point& point) const;
+
+public:
+
+	RoomGraphPlanner();
+
+	// builds the abstract graph from the map (CV_8UC1, 255 = accessible) and its room segmentation (CV_32SC1, rooms labeled 1..N)
+	// the parameters have the same meaning as in AStarPlanner::downsampleMap, map_context provides the map hash if it belongs to map and
+	// may be NULL
+	void buildGraph(const cv::Mat& map, const cv::Mat& segmented_map, const double downsampling_factor, const double robot_radius,
+			const double map_resolution, const MapContext* map_context=NULL);
+
+	// checks whether the graph has been built for the map with this hash (DistanceMatrixCache::computeMapHash, e.g. from
+	// MapContext::getMapHash) and these parameters, the map is not hashed again
+	bool isValidFor(const boost::uint64_t map_hash, const double downsampling_factor, const double robot_radius, const double map_resolution) const;
+
+	// hash of the map and segmentation the graph has been built from
+	boost::uint64_t getKey() const
+	{
+		return graph_key_;
+	}
+
+	int getNumberOfRegions() const
+	{
+		return number_regions_;
+	}
+
+	int getNumberOfNodes() const
+	{
+		return (int)node_cells_.size();
+	}
+
+	// computes the symmetric matrix (CV_64F) of path lengths between all points (coordinates in the original map)
+	void computeDistanceMatrix(const std::vector<cv::Point>& points, cv::Mat& distance_matrix) const;
+
+	// computes the path length between two points (coordinates in the original map)
+	double computeDistance(const cv::Point& start_point, const cv::Point& end_point) const;
+};
@@ -7,12 +7,16 @@
 #include <cstdlib>
 #include <stdio.h>
 #include <algorithm>
+#include <map>
+#include <set>
 
 #include <opencv2/opencv.hpp>
 #include <opencv2/highgui/highgui.hpp>
 
 #include <fstream>
 
+#include <boost/dynamic_bitset.hpp>
+
 #include <ipa_building_navigation/contains.h>
 #include <ipa_building_navigation/A_star_pathplanner.h>
 #include <ipa_building_navigation/maximal_clique_finder.h>
@@ -0,0 +1,165 @@
+/*!
+ *****************************************************************
+ * \file
+ *
+ * \note
+ * Copyright (c) 2026 \n
+ * Fraunhofer Institute for Manufacturing Engineering
+ * and Automation (IPA) \n\n
+ *
+ *****************************************************************
+ *
+ * \note
+ * Project name: Care-O-bot
+ * \note
+ * ROS stack name: autopnp
+ * \note
+ * ROS package name: ipa_building_navigation
+ *
+ * \author
+ * Author: Richard Bormann
+ * \author
+ * Supervised by: Richard Bormann
+ *
+ * \date Date of creation: 10.2026
+ *
+ * \brief
+ *
+ *
+ *****************************************************************
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer. \n
+ * - Redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution. \n
+ * - Neither the name of the Fraunhofer Institute for Manufacturing
+ * Engineering and Automation (IPA) nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission. \n
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License LGPL as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License LGPL for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License LGPL along with this program.
+ * If not, see <http://www.gnu.org/licenses/>.
+ *
+ ****************************************************************/
+
+#pragma once
+
+#include <vector>
+
+#include <opencv2/opencv.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/atomic.hpp>
+
+// This class stores the path lengths of a large point set sparsely, as a replacement of the dense NxN distance matrix of
+// DistanceMatrix, which needs 8*N^2 bytes. For each point only the path lengths to its number_neighbors Euclidean nearest points
+// (optionally only those within max_radius) are computed and kept in compressed sparse row (CSR) form as float. The neighbors of
+// each point are sorted by path length, so they can be used as candidate lists by the TSP solvers directly.
+// Path lengths are measured in [pixel] like in DistanceMatrix: pairs with direct line of sight get their straight line length, the
+// other neighbors of a point are planned with one wavefront expansion on the downsampled map, and pairs that are not connected on
+// the downsampled map are planned with A* on the original map. Unreachable neighbors get a length of 1e100.
+// Pairs that are not stored are computed on demand by getDistance, which costs one A* search unless the points are in line of sight.
+// The results are kept in a direct-mapped cache with cached_pairs_per_point entries per point, a pair that is evicted by another
+// pair with the same cache slot is planned again when it is requested the next time.
+//
+// The map passed to construct is referenced, not copied, and must not be modified while the object is used.
+// All const functions are thread-safe.
+class SparseDistanceMatrix
+{
+protected:
+
+	int number_points_;
+	std::vector<cv::Point> points_;
+	std::vector<int> row_offsets_;			// the neighbors of point i are stored at the indices row_offsets_[i] until row_offsets_[i+1]-1
+	std::vector<int> neighbor_indices_;		// index of each stored neighbor
+	std::vector<float> neighbor_distances_;	// path length to each stored neighbor, sorted ascending within each row
+
+	// data for computing missing pairs on demand
+	cv::Mat original_map_;
+	cv::Mat downsampled_map_;
+	double downsampling_factor_;
+	double map_resolution_;
+	mutable boost::mutex mutex_;
+	mutable std::vector<long long> cached_pairs_;		// key i*number_points_+j (i<j) of the pair in each cache slot, -1 = empty
+	mutable std::vector<float> cached_distances_;		// path length of the pair in each cache slot
+
+	int number_of_threads_;
+	int search_mode_;	// search mode of the A* planners, see AStarSearchModes
+	boost::atomic<bool> abort_computation_;	// set by abortComputation from another thread
+
+	// computes the neighbors of every number_of_threads-th point, starting with first_point
+	void constructRows(const int first_point, const int number_of_threads, const int number_neighbors, const double max_radius,
+			std::vector<std::vector<std::pair<float, int> > >& rows);
+
+	// looks up the distance in the stored neighbors of point i, returns false if j is not stored there
+	bool findStoredDistance(const int i, const int j, double& distance) const;
+
+public:
+
+	SparseDistanceMatrix();
+
+	void abortComputation();
+
+	// sets the number of threads used by construct, values < 1 select the number of hardware threads, default: 1
+	void setNumberOfThreads(const int number_of_threads);
+
+	// selects the search mode of the A* planners used by construct and getDistance, see AStarSearchModes, default: ASTAR_STANDARD
+	void setSearchMode(const int search_mode);
+
+	// computes the path lengths of each point to its number_neighbors Euclidean nearest points, if max_radius [pixel] is > 0 only
+	// points within this radius are considered, returns false if the computation was aborted
+	bool construct(const cv::Mat& original_map, const std::vector<cv::Point>& points, const double downsampling_factor,
+			const double robot_radius, const double map_resolution, const int number_neighbors, const double max_radius=0.);
+
+	int getNumberPoints() const
+	{
+		return number_points_;
+	}
+
+	const std::vector<cv::Point>& getPoints() const
+	{
+		return points_;
+	}
+
+	// number of stored neighbors of point i
+	int getNumberNeighbors(const int i) const
+	{
+		return row_offsets_[i+1] - row_offsets_[i];
+	}
+
+	// stored neighbors of point i, sorted by path length, with getNumberNeighbors(i) entries
+	const int* getNeighbors(const int i) const
+	{
+		return (neighbor_indices_.empty() ? NULL : &neighbor_indices_[0] + row_offsets_[i]);
+	}
+
+	// path lengths to the stored neighbors of point i, in the order of getNeighbors(i)
+	const float* getNeighborDistances(const int i) const
+	{
+		return (neighbor_distances_.empty() ? NULL : &neighbor_distances_[0] + row_offsets_[i]);
+	}
+
+	// returns the path length between points i and j, pairs that are not stored are planned and cached
+	double getDistance(const int i, const int j) const;
+
+	// returns the unvisited point closest to point i: the first unvisited stored neighbor or, if all of them have been visited,
+	// the unvisited point with the shortest straight line distance, returns -1 if all points have been visited
+	int findNearestUnvisited(const int i, const std::vector<bool>& visited) const;
+
+	// memory used by the stored path lengths and the cache in [byte]
+	size_t getMemoryUsage() const;
+};
@@ -15,6 +15,7 @@
 #include <ipa_building_navigation/contains.h>
 
 #include <ipa_building_navigation/A_star_pathplanner.h>
+#include <ipa_building_navigation/wavefront_planner.h>
 
 #pragma once //make sure this header gets included only one time when multiple classes need it in the same project
 			 //regarding to https://en.wikipedia.org/wiki/Pragma_once this is more efficient than #define
@@ -23,6 +24,8 @@
 //the Point where the trolley of a robot should be placed during the cleaning of the group. This is done by searching in the
 //bounding box of these points for the point which minimizes the pathlength to every group member. If the goup has only two
 //members the algorithm chooses a Point on the optimal path between these two Points that is in the middlest of this path.
+//The pathlengths are obtained with one wavefront expansion per group member on the downsampled map, which yields the pathlength
+//to every cell of the bounding box at once, so the sum of pathlengths is known for every free pixel and the minimum is exact.
 //This algorithm needs as input:
 //		1. The original occupancy gridmap to get the pathlength between two Points.
 //		2. A vector of found groups. This vector stores the group as integer that show the Position of the node in the
@@ -42,6 +45,16 @@ protected:
 
 	AStarPlanner path_planner_; //Object to plan a path from Point A to Point B in a given gridmap
 
+	int number_of_threads_; //number of threads that compute the wavefronts of the group members in parallel
+
+	boost::shared_ptr<const MapContext> map_context_; //preprocessed versions of the map, only used if it belongs to the given map
+
+	//Function that computes the pathlengths from every group member with index member_index = first_member + k*member_step to
+	//the cells of the bounding box, given by box_offset and the size of the matrices in pathlengths, on the downsampled map.
+	//Each call uses its own wavefront planner, so the group members can be distributed over several threads.
+	static void computeMemberPathLengths(const cv::Mat& downsampled_map, const std::vector<cv::Point>& member_cells, const std::vector<cv::Point>& box_cells,
+			const cv::Point& box_offset, const int first_member, const int member_step, std::vector<cv::Mat>& pathlengths);
+
 	//Function to find a trolley position for one group
 	cv::Point findOneTrolleyPosition(const std::vector<cv::Point> group_points, const cv::Mat& original_map,
 			const double downsampling_factor, const double robot_radius, const double map_resolution);
@@ -51,6 +64,13 @@ public:
 	//constructor
 	TrolleyPositionFinder();
 
+	//Function to set the number of threads for the wavefront expansions (default 1), values < 1 use the number of available cores
+	void setNumberOfThreads(const int number_of_threads);
+
+	//Function to set the map context that provides the eroded, downsampled and distance-transformed map, it is only used for the
+	//map it has been created for
+	void setMapContext(const boost::shared_ptr<const MapContext>& map_context);
+
 	//Function to find a trolley position for each group by using the findOneTrolleyPosition function
 	std::vector<cv::Point> findTrolleyPositions(const cv::Mat& original_map, const std::vector<std::vector<int> >& found_groups,
 			const std::vector<cv::Point>& room_centers, const double downsampling_factor, const double robot_radius,
@@ -61,3 +61,6 @@
 
 
 enum TSPSolvers {TSP_NEAREST_NEIGHBOR=1, TSP_GENETIC=2, TSP_CONCORDE=3};
+
+// backends for the computation of the path lengths in the distance matrix
+enum DistanceMatrixBackends {DISTANCE_MATRIX_ASTAR=1, DISTANCE_MATRIX_WAVEFRONT=2, DISTANCE_MATRIX_ROOM_GRAPH=3};
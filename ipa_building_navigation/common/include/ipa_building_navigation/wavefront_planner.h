@@ -0,0 +1,117 @@
+/*!
+ *****************************************************************
+ * \file
+ *
+ * \note
+ * Copyright (c) 2026 \n
+ * Fraunhofer Institute for Manufacturing Engineering
+ * and Automation (IPA) \n\n
+ *
+ *****************************************************************
+ *
+ * \note
+ * Project name: Care-O-bot
+ * \note
+ * ROS stack name: autopnp
+ * \note
+ * ROS package name: ipa_building_navigation
+ *
+ * \author
+ * Author: Richard Bormann
+ * \author
+ * Supervised by: Richard Bormann
+ *
+ * \date Date of creation: 10.2026
+ *
+ * \brief
+ *
+ *
+ *****************************************************************
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer. \n
+ * - Redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution. \n
+ * - Neither the name of the Fraunhofer Institute for Manufacturing
+ * Engineering and Automation (IPA) nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission. \n
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License LGPL as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License LGPL for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License LGPL along with this program.
+ * If not, see <http://www.gnu.org/licenses/>.
+ *
+ ****************************************************************/
+
+#pragma once
+
+#include <vector>
+#include <queue>
+#include <functional>
+#include <limits>
+
+#include <opencv2/opencv.hpp>
+
+// This class computes single-source shortest paths on an occupancy grid map with a Dijkstra wavefront. One expansion from a start
+// cell yields the path length to every reachable cell of the map, so a whole row of a distance matrix can be obtained with one search
+// instead of one A* search per target.
+// The grid uses the same 8-neighborhood and the same integer step costs as the AStarPlanner (10 for straight, 14 for diagonal moves),
+// accessible cells have the value 255. Path lengths are returned in cells, i.e. a straight step adds 1 and a diagonal step adds sqrt(2).
+// The paths can be reconstructed from the stored predecessor directions.
+// The expansion can be restricted to the cells of one region of a label map (e.g. a room), then its cost is proportional to the
+// size of that region: the buffers are allocated once per map size and cell entries are validated with generation stamps.
+//
+// A planner object keeps the state of the last expansion, so use one object per thread.
+class WavefrontPlanner
+{
+protected:
+
+	int rows_;
+	int cols_;
+	cv::Point start_point_;
+
+	unsigned int generation_;				// number of the current expansion, cell entries are only valid if their stamp equals generation_
+	std::vector<unsigned int> reached_generation_;	// generation in which the cell has been reached
+	std::vector<unsigned int> settled_generation_;	// generation in which the shortest path to the cell has become final
+	std::vector<unsigned int> target_generation_;	// generation in which the cell has been marked as target
+	std::vector<int> cost_;					// accumulated integer step costs of each cell
+	std::vector<double> path_length_;		// path length along the chosen predecessors of each cell, in [cells]
+	std::vector<signed char> predecessor_;	// direction index pointing to the predecessor of each cell, -1 for the start cell
+
+	// prepares the buffers for a map of the given size and starts a new generation
+	void prepareExpansion(const int rows, const int cols);
+
+public:
+
+	WavefrontPlanner();
+
+	// computes the shortest paths from start_point to all cells of map that are reachable
+	// if targets is provided, the expansion stops as soon as all accessible targets are settled, the other cells may not have final values then
+	// if region_map (CV_32SC1, same size as map) is provided, only cells with region_map value region are expanded
+	void computeWavefront(const cv::Mat& map, const cv::Point& start_point, const std::vector<cv::Point>* targets=NULL,
+			const cv::Mat* region_map=NULL, const int region=0);
+
+	// returns the path length from the start point of the last expansion to target_point in [cells], or 1e100 if it is not reachable
+	double getPathLength(const cv::Point& target_point) const;
+
+	// writes the cells of the path from the start point of the last expansion to target_point into path (start and target included)
+	// returns false if target_point is not reachable
+	bool getPath(const cv::Point& target_point, std::vector<cv::Point>& path) const;
+
+	// returns true if target_point has been reached by the last expansion
+	bool isReachable(const cv::Point& target_point) const;
+};
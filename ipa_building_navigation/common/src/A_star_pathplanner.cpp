@@ -1,6 +1,9 @@
 #include <ipa_building_navigation/A_star_pathplanner.h>
 
 #include <ipa_building_navigation/timer.h>
+#include <ipa_building_navigation/instrumentation.h>
+
+#include <algorithm>
 
 const int dir = 8; // number of possible directions to go at any position
 // if dir==4
@@ -12,38 +15,51 @@ static int dx[dir] =
 static int dy[dir] =
 { 0, 1, 1, 1, 0, -1, -1, -1 };
 
-static int expanding_counter = 0;
+// heuristic estimate of the remaining distance to the goal, identical to NodeAstar::estimate (Euclidean distance in cells)
+static inline int estimateRemainingCost(const int x, const int y, const int xDest, const int yDest)
+{
+	const int xd = xDest - x;
+	const int yd = yDest - y;
+	return static_cast<int>(sqrt(xd * xd + yd * yd));
+}
 
-// Determine priority (in the priority queue)
-bool operator<(const NodeAstar& a, const NodeAstar& b)
+// exact remaining cost on an obstacle-free 8-connected grid with step costs 10 (straight) and 14 (diagonal)
+static inline int octileDistance(const int x, const int y, const int xDest, const int yDest)
 {
-	return a.getPriority() > b.getPriority();
+	const int xd = abs(xDest - x);
+	const int yd = abs(yDest - y);
+	return 10*std::max(xd, yd) + 4*std::min(xd, yd);
+}
+
+static inline int sign(const int value)
+{
+	return (value > 0) - (value < 0);
 }
 
 AStarPlanner::AStarPlanner()
 {
 	n = 1;
 	m = 1;
+	expanding_counter_ = 0;
+	search_mode_ = ASTAR_STANDARD;
+	context_cells_ = 0;
+	generation_ = 0;
 }
 
-void AStarPlanner::drawRoute(cv::Mat& map, const cv::Point start_point, const std::string& route, double step_length)
+void AStarPlanner::drawRoute(cv::Mat& map, const cv::Point start_point, const std::vector<cv::Point>& route, double step_length)
 {
 	// follow the route on the map and update the path length
-	if (route.length() > 0)
+	if (route.size() > 1)
 	{
-		int j;
-		char c;
 		int x1 = start_point.x;
 		int y1 = start_point.y;
 		int x2,y2;
-		for (int i = 0; i < route.length(); i++)
+		for (size_t i = 1; i < route.size(); i++)
 		{
-			//get the next char of the string and make it an integer, which shows the direction
-			c = route.at(i);
-			j=c-'0';
-			x2 = x1 + dx[j]*step_length;
-			y2 = y1 + dy[j]*step_length;
-			const double progress = 0.2 + 0.6*(double)i/(double)route.length();
+			// the direction of the step is given by the difference of two consecutive cells
+			x2 = x1 + (route[i].x-route[i-1].x)*step_length;
+			y2 = y1 + (route[i].y-route[i-1].y)*step_length;
+			const double progress = 0.2 + 0.6*(double)(i-1)/(double)(route.size()-1);
 			cv::line(map, cv::Point(x1,y1), cv::Point(x2,y2), CV_RGB(0,progress*255,0), 1);
 			x1 = x2;
 			y1 = y2;
@@ -51,25 +67,21 @@ void AStarPlanner::drawRoute(cv::Mat& map, const cv::Point start_point, const st
 	}
 }
 
-void AStarPlanner::getRoute(const cv::Point start_point, const std::string& route,
+void AStarPlanner::getRoute(const cv::Point start_point, const std::vector<cv::Point>& route,
 		double step_length, std::vector<cv::Point>& route_points)
 {
 	// follow the route on the map and update the path length
-	if (route.length() > 0)
+	if (route.size() > 1)
 	{
-		int j;
-		char c;
 		int x1 = start_point.x;
 		int y1 = start_point.y;
 		route_points.push_back(cv::Point(x1, y1));
 		int x2,y2;
-		for (int i = 0; i < route.length(); i++)
+		for (size_t i = 1; i < route.size(); i++)
 		{
-			//get the next char of the string and make it an integer, which shows the direction
-			c = route.at(i);
-			j=c-'0';
-			x2 = x1 + dx[j]*step_length;
-			y2 = y1 + dy[j]*step_length;
+			// the direction of the step is given by the difference of two consecutive cells
+			x2 = x1 + (route[i].x-route[i-1].x)*step_length;
+			y2 = y1 + (route[i].y-route[i-1].y)*step_length;
 			route_points.push_back(cv::Point(x2, y2));
 			x1 = x2;
 			y1 = y2;
@@ -77,12 +89,25 @@ void AStarPlanner::getRoute(const cv::Point start_point, const std::string& rout
 	}
 }
 
-void AStarPlanner::downsampleMap(const cv::Mat& map, cv::Mat& downsampled_map, const double downsampling_factor, const double robot_radius, const double map_resolution)
+void AStarPlanner::downsampleMap(const cv::Mat& map, cv::Mat& downsampled_map, const double downsampling_factor, const double robot_radius, const double map_resolution,
+		const MapContext* map_context)
 {
+	//reuse the result of the map context if it has been computed for this map already
+	if (map_context != NULL && map_context->isValidFor(map, robot_radius, map_resolution) == true)
+	{
+		map_context->getDownsampledMap(downsampling_factor).copyTo(downsampled_map);
+		return;
+	}
+
 	//erode the map so the planner doesn't go near the walls
 	//	--> calculate the number of times for eroding from Robot Radius [m]
-	cv::Mat eroded_map;
 	int number_of_erosions = (robot_radius / map_resolution);
+	if (number_of_erosions == 0 && downsampling_factor == 1.)
+	{
+		map.copyTo(downsampled_map);
+		return;
+	}
+	cv::Mat eroded_map;
 	cv::erode(map, eroded_map, cv::Mat(), cv::Point(-1, -1), number_of_erosions);
 	//downsampling of the map to reduce calculation time
 	if (downsampling_factor != 1.)
@@ -91,155 +116,331 @@ void AStarPlanner::downsampleMap(const cv::Mat& map, cv::Mat& downsampled_map, c
 		downsampled_map = eroded_map;
 }
 
-// A-star algorithm.
-// The route returned is a string of direction digits.
-std::string AStarPlanner::pathFind(const int & xStart, const int & yStart, const int & xFinish, const int & yFinish, const cv::Mat& map)
+void AStarPlanner::prepareContext(const int number_cells)
 {
-	static std::priority_queue<NodeAstar> pq[2]; // list of open (not-yet-tried) nodes
-	static int pqi; // pq index
-	static NodeAstar* n0;
-	static NodeAstar* m0;
-	static int i, j, x, y, xdx, ydy;
-	static char c;
-	pqi = 0;
-
-	cv::Mat map_to_calculate_path(cv::Size(m, n), CV_32S);
-
-	// create map from the given eroded map
-	for (int y = 0; y < map.rows; y++)
+	if (number_cells != context_cells_)
 	{
-		for (int x = 0; x < map.cols; x++)
-		{
-			if (map.at<unsigned char>(y, x) == 255)
-			{
-				map_to_calculate_path.at<int>(x, y) = 0;
-			}
-			else
-			{
-				map_to_calculate_path.at<int>(x, y) = 1;
-			}
-		}
+		context_cells_ = number_cells;
+		visited_generation_.assign(number_cells, 0);
+		closed_generation_.assign(number_cells, 0);
+		cost_.resize(number_cells);
+		priority_.resize(number_cells);
+		parent_direction_.resize(number_cells);
+		parent_cell_.resize(number_cells);
+		heap_position_.resize(number_cells);
+		heap_.reserve(number_cells);
+		generation_ = 0;
 	}
+	heap_.clear();
 
-	cv::Mat closed_nodes_map(cv::Size(m, n), CV_32S); //map of already tried nodes
-	cv::Mat open_nodes_map(cv::Size(m, n), CV_32S); // map of open (not-yet-tried) nodes
-	cv::Mat dir_map(cv::Size(m, n), CV_32S); // map of directions
-
-	// initialize the node maps
-	for (y = 0; y < closed_nodes_map.rows; y++)
+	// start a new generation, all entries of older generations become invalid
+	++generation_;
+	if (generation_ == 0)
 	{
-		for (x = 0; x < closed_nodes_map.cols; x++)
-		{
-			closed_nodes_map.at<int>(y, x) = 0;
-			open_nodes_map.at<int>(y, x) = 0;
-		}
+		// overflow of the generation counter: clear the stamps once
+		std::fill(visited_generation_.begin(), visited_generation_.end(), 0);
+		std::fill(closed_generation_.begin(), closed_generation_.end(), 0);
+		generation_ = 1;
 	}
+}
 
-	// create the start node and push into list of open nodes
-	n0 = new NodeAstar(xStart, yStart, 0, 0);
-	n0->updatePriority(xFinish, yFinish);
-	pq[pqi].push(*n0);
-	open_nodes_map.at<int>(xStart, yStart) = n0->getPriority(); // mark it on the open nodes map
+void AStarPlanner::heapPush(const int cell)
+{
+	heap_position_[cell] = (int)heap_.size();
+	heap_.push_back(cell);
+	heapSiftUp((int)heap_.size()-1);
+}
 
-	//garbage collection
-	delete n0;
+int AStarPlanner::heapPop()
+{
+	const int top = heap_[0];
+	heap_[0] = heap_.back();
+	heap_position_[heap_[0]] = 0;
+	heap_.pop_back();
+	if (heap_.empty() == false)
+		heapSiftDown(0);
+	return top;
+}
 
-	// A* search
-	while (!pq[pqi].empty())
+void AStarPlanner::heapSiftUp(int position)
+{
+	const int cell = heap_[position];
+	while (position > 0)
 	{
-		// get the current node w/ the highest priority
-		// from the list of open nodes
-		n0 = new NodeAstar(pq[pqi].top().getxPos(), pq[pqi].top().getyPos(), pq[pqi].top().getLevel(), pq[pqi].top().getPriority());
+		const int parent = (position-1)/2;
+		if (priority_[heap_[parent]] <= priority_[cell])
+			break;
+		heap_[position] = heap_[parent];
+		heap_position_[heap_[position]] = position;
+		position = parent;
+	}
+	heap_[position] = cell;
+	heap_position_[cell] = position;
+}
+
+void AStarPlanner::heapSiftDown(int position)
+{
+	const int cell = heap_[position];
+	const int size = (int)heap_.size();
+	while (true)
+	{
+		int child = 2*position+1;
+		if (child >= size)
+			break;
+		if (child+1 < size && priority_[heap_[child+1]] < priority_[heap_[child]])
+			++child;
+		if (priority_[cell] <= priority_[heap_[child]])
+			break;
+		heap_[position] = heap_[child];
+		heap_position_[heap_[position]] = position;
+		position = child;
+	}
+	heap_[position] = cell;
+	heap_position_[cell] = position;
+}
+
+// A-star algorithm.
+// The route is returned as the sequence of visited cells from start to goal.
+// The search uses the preallocated context of this object, so no memory is allocated for queries on maps of the same size.
+bool AStarPlanner::pathFind(const int & xStart, const int & yStart, const int & xFinish, const int & yFinish, const cv::Mat& map, std::vector<cv::Point>& route)
+{
+	if (search_mode_ == ASTAR_JUMP_POINT_SEARCH)
+		return jumpPointSearch(xStart, yStart, xFinish, yFinish, map, route);
 
-		x = n0->getxPos();
-		y = n0->getyPos();
+	route.clear();
+	prepareContext(n*m);
+
+	// create the start node and push into list of open nodes
+	const int start_cell = yStart*n + xStart;
+	visited_generation_[start_cell] = generation_;
+	cost_[start_cell] = 0;
+	priority_[start_cell] = estimateRemainingCost(xStart, yStart, xFinish, yFinish);
+	parent_direction_[start_cell] = -1;
+	heapPush(start_cell);
 
-		pq[pqi].pop(); // remove the node from the open list
-		open_nodes_map.at<int>(x, y) = 0;
+	// A* search
+	while (heap_.empty() == false)
+	{
+		// get the current node w/ the highest priority from the list of open nodes
+		const int cell = heapPop();
+		const int x = cell % n;
+		const int y = cell / n;
 		// mark it on the closed nodes map
-		closed_nodes_map.at<int>(x, y) = 1;
+		closed_generation_[cell] = generation_;
 
 		// quit searching when the goal state is reached
-		//if((*n0).estimate(xFinish, yFinish) == 0)
 		if (x == xFinish && y == yFinish)
 		{
-			// generate the path from finish to start
-			// by following the directions
-			std::string path = "";
-			while (!(x == xStart && y == yStart))
+			// a goal that equals the start yields an empty route, which is treated as no route found (as before)
+			if (cell == start_cell)
+				return false;
+
+			// generate the path from finish to start by following the directions
+			int px = x, py = y;
+			route.push_back(cv::Point(px, py));
+			while (!(px == xStart && py == yStart))
 			{
-				j = dir_map.at<int>(x, y);
-				c = '0' + (j + dir / 2) % dir;
-				path = c + path;
-				x += dx[j];
-				y += dy[j];
+				const int j = parent_direction_[py*n + px];
+				px += dx[j];
+				py += dy[j];
+				route.push_back(cv::Point(px, py));
 			}
-
-			delete n0;// garbage collection
-			// empty the leftover nodes
-			while (!pq[pqi].empty())
-				pq[pqi].pop();
-			return path;
+			std::reverse(route.begin(), route.end());
+			return true;
 		}
 
 		// generate moves (child nodes) in all possible directions
-		for (i = 0; i < dir; i++)
+		for (int i = 0; i < dir; i++)
 		{
-			xdx = x + dx[i];
-			ydy = y + dy[i];
+			const int xdx = x + dx[i];
+			const int ydy = y + dy[i];
 
-			expanding_counter++;
+			expanding_counter_++;
 
-			if (!(xdx < 0 || xdx > n - 1 || ydy < 0 || ydy > m - 1 || map_to_calculate_path.at<int>(xdx, ydy) == 1 || closed_nodes_map.at<int>(xdx, ydy) == 1))
-			{
-				// generate a child node
-				m0 = new NodeAstar(xdx, ydy, n0->getLevel(), n0->getPriority());
-				m0->nextLevel(i);
-				m0->updatePriority(xFinish, yFinish);
+			if (xdx < 0 || xdx > n - 1 || ydy < 0 || ydy > m - 1 || map.at<unsigned char>(ydy, xdx) != 255)
+				continue;
+			const int child = ydy*n + xdx;
+			if (closed_generation_[child] == generation_)
+				continue;
 
+			// give better priority to going straight instead of diagonally
+			const int child_cost = cost_[cell] + (i % 2 == 0 ? 10 : 14);
+			const int child_priority = child_cost + estimateRemainingCost(xdx, ydy, xFinish, yFinish);
+			if (visited_generation_[child] != generation_)
+			{
 				// if it is not in the open list then add into that
-				if (open_nodes_map.at<int>(xdx, ydy) == 0)
+				visited_generation_[child] = generation_;
+				cost_[child] = child_cost;
+				priority_[child] = child_priority;
+				parent_direction_[child] = (i + dir / 2) % dir;
+				heapPush(child);
+			}
+			else if (priority_[child] > child_priority)
+			{
+				// update the priority and parent direction info of the open node
+				cost_[child] = child_cost;
+				priority_[child] = child_priority;
+				parent_direction_[child] = (i + dir / 2) % dir;
+				heapSiftUp(heap_position_[child]);
+			}
+		}
+	}
+	return false; // no route found
+}
+
+bool AStarPlanner::jump(int x, int y, const int dx, const int dy, const int xFinish, const int yFinish, const cv::Mat& map, int& jump_x, int& jump_y)
+{
+	while (true)
+	{
+		if (isAccessible(x, y, map) == false)
+			return false;
+		expanding_counter_++;
+
+		bool is_jump_point = (x == xFinish && y == yFinish);
+		if (is_jump_point == false)
+		{
+			if (dx != 0 && dy != 0)
+			{
+				// diagonal move: check for forced neighbors and for jump points in the straight directions
+				int tx, ty;
+				is_jump_point = (isAccessible(x-dx, y+dy, map) && !isAccessible(x-dx, y, map)) || (isAccessible(x+dx, y-dy, map) && !isAccessible(x, y-dy, map)) ||
+						jump(x+dx, y, dx, 0, xFinish, yFinish, map, tx, ty) || jump(x, y+dy, 0, dy, xFinish, yFinish, map, tx, ty);
+			}
+			else if (dx != 0)
+				is_jump_point = (isAccessible(x+dx, y+1, map) && !isAccessible(x, y+1, map)) || (isAccessible(x+dx, y-1, map) && !isAccessible(x, y-1, map));
+			else
+				is_jump_point = (isAccessible(x+1, y+dy, map) && !isAccessible(x+1, y, map)) || (isAccessible(x-1, y+dy, map) && !isAccessible(x-1, y, map));
+		}
+		if (is_jump_point == true)
+		{
+			jump_x = x;
+			jump_y = y;
+			return true;
+		}
+
+		x += dx;
+		y += dy;
+	}
+}
+
+// Jump Point Search (Harabor and Grastien, 2011), variant that allows diagonal moves past obstacle corners.
+bool AStarPlanner::jumpPointSearch(const int & xStart, const int & yStart, const int & xFinish, const int & yFinish, const cv::Mat& map, std::vector<cv::Point>& route)
+{
+	route.clear();
+	prepareContext(n*m);
+
+	const int start_cell = yStart*n + xStart;
+	visited_generation_[start_cell] = generation_;
+	cost_[start_cell] = 0;
+	priority_[start_cell] = octileDistance(xStart, yStart, xFinish, yFinish);
+	parent_cell_[start_cell] = -1;
+	heapPush(start_cell);
+
+	std::vector<cv::Point> directions;
+	directions.reserve(dir);
+	while (heap_.empty() == false)
+	{
+		const int cell = heapPop();
+		const int x = cell % n;
+		const int y = cell / n;
+		closed_generation_[cell] = generation_;
+
+		if (x == xFinish && y == yFinish)
+		{
+			// a goal that equals the start yields an empty route, which is treated as no route found (like in pathFind)
+			if (cell == start_cell)
+				return false;
+
+			// collect the jump points from finish to start and fill in the cells in between
+			std::vector<cv::Point> jump_points;
+			for (int c = cell; c != -1; c = parent_cell_[c])
+				jump_points.push_back(cv::Point(c % n, c / n));
+			std::reverse(jump_points.begin(), jump_points.end());
+			route.push_back(jump_points[0]);
+			for (size_t k = 1; k < jump_points.size(); ++k)
+			{
+				const int sx = sign(jump_points[k].x - jump_points[k-1].x);
+				const int sy = sign(jump_points[k].y - jump_points[k-1].y);
+				cv::Point current = jump_points[k-1];
+				while (current != jump_points[k])
 				{
-					open_nodes_map.at<int>(xdx, ydy) = m0->getPriority();
-					pq[pqi].push(*m0);
-					// mark its parent node direction
-					dir_map.at<int>(xdx, ydy) = (i + dir / 2) % dir;
+					current.x += sx;
+					current.y += sy;
+					route.push_back(current);
 				}
-				else if (open_nodes_map.at<int>(xdx, ydy) > m0->getPriority())
-				{
-					// update the priority info
-					open_nodes_map.at<int>(xdx, ydy) = m0->getPriority();
-					// update the parent direction info
-					dir_map.at<int>(xdx, ydy) = (i + dir / 2) % dir;
-
-					// replace the node
-					// by emptying one pq to the other one
-					// except the node to be replaced will be ignored
-					// and the new node will be pushed in instead
-					while (!(pq[pqi].top().getxPos() == xdx && pq[pqi].top().getyPos() == ydy))
-					{
-						pq[1 - pqi].push(pq[pqi].top());
-						pq[pqi].pop();
-					}
-					pq[pqi].pop(); // remove the wanted node
+			}
+			return true;
+		}
 
-					// empty the larger size pq to the smaller one
-					if (pq[pqi].size() > pq[1 - pqi].size())
-						pqi = 1 - pqi;
-					while (!pq[pqi].empty())
-					{
-						pq[1 - pqi].push(pq[pqi].top());
-						pq[pqi].pop();
-					}
-					pqi = 1 - pqi;
-					pq[pqi].push(*m0); // add the better node instead
-				}
-				delete m0; // garbage collection
+		// determine the directions to search from this node: all directions at the start, otherwise the natural and forced neighbors
+		directions.clear();
+		const int parent = parent_cell_[cell];
+		if (parent == -1)
+		{
+			for (int i = 0; i < dir; i++)
+				directions.push_back(cv::Point(dx[i], dy[i]));
+		}
+		else
+		{
+			const int pdx = sign(x - parent % n);
+			const int pdy = sign(y - parent / n);
+			if (pdx != 0 && pdy != 0)
+			{
+				directions.push_back(cv::Point(0, pdy));
+				directions.push_back(cv::Point(pdx, 0));
+				directions.push_back(cv::Point(pdx, pdy));
+				if (isAccessible(x-pdx, y, map) == false)
+					directions.push_back(cv::Point(-pdx, pdy));
+				if (isAccessible(x, y-pdy, map) == false)
+					directions.push_back(cv::Point(pdx, -pdy));
+			}
+			else if (pdx != 0)
+			{
+				directions.push_back(cv::Point(pdx, 0));
+				if (isAccessible(x, y+1, map) == false)
+					directions.push_back(cv::Point(pdx, 1));
+				if (isAccessible(x, y-1, map) == false)
+					directions.push_back(cv::Point(pdx, -1));
+			}
+			else
+			{
+				directions.push_back(cv::Point(0, pdy));
+				if (isAccessible(x+1, y, map) == false)
+					directions.push_back(cv::Point(1, pdy));
+				if (isAccessible(x-1, y, map) == false)
+					directions.push_back(cv::Point(-1, pdy));
+			}
+		}
+
+		for (size_t d = 0; d < directions.size(); ++d)
+		{
+			int jx, jy;
+			if (jump(x+directions[d].x, y+directions[d].y, directions[d].x, directions[d].y, xFinish, yFinish, map, jx, jy) == false)
+				continue;
+			const int successor = jy*n + jx;
+			if (closed_generation_[successor] == generation_)
+				continue;
+
+			const int successor_cost = cost_[cell] + octileDistance(x, y, jx, jy);
+			const int successor_priority = successor_cost + octileDistance(jx, jy, xFinish, yFinish);
+			if (visited_generation_[successor] != generation_)
+			{
+				visited_generation_[successor] = generation_;
+				cost_[successor] = successor_cost;
+				priority_[successor] = successor_priority;
+				parent_cell_[successor] = cell;
+				heapPush(successor);
+			}
+			else if (priority_[successor] > successor_priority)
+			{
+				cost_[successor] = successor_cost;
+				priority_[successor] = successor_priority;
+				parent_cell_[successor] = cell;
+				heapSiftUp(heap_position_[successor]);
 			}
 		}
-		delete n0; // garbage collection
 	}
-	return ""; // no route found
+	return false; // no route found
 }
 
 //This is the path planning algorithm for this class. It downsamples the map with the given factor (0 < factor < 1) so the
@@ -250,7 +451,7 @@ double AStarPlanner::planPath(const cv::Mat& map, const cv::Point& start_point,
 		const double downsampling_factor, const double robot_radius, const double map_resolution,
 		const int end_point_valid_neighborhood_radius, std::vector<cv::Point>* route)
 {
-	expanding_counter = 0;
+	expanding_counter_ = 0;
 	double step_length = 1./downsampling_factor;
 
 	//length of the planned path
@@ -268,8 +469,12 @@ double AStarPlanner::planPath(const cv::Mat& map, const cv::Point& start_point,
 		return 1e100;
 	}
 
-	cv::Mat downsampled_map;
-	downsampleMap(map, downsampled_map, downsampling_factor, robot_radius, map_resolution);
+	//the map is only read by the search, so it is used directly if it needs neither erosion nor downsampling
+	cv::Mat eroded_downsampled_map;
+	const bool use_map = (downsampling_factor == 1. && (int)(robot_radius / map_resolution) == 0);
+	if (use_map == false)
+		downsampleMap(map, eroded_downsampled_map, downsampling_factor, robot_radius, map_resolution);
+	const cv::Mat& downsampled_map = (use_map == true ? map : eroded_downsampled_map);
 
 	//transform the Pixel values to the downsampled ones
 	int start_x = downsampling_factor * start_point.x;
@@ -283,8 +488,9 @@ double AStarPlanner::planPath(const cv::Mat& map, const cv::Point& start_point,
 
 	// get the route
 //	clock_t start = clock();
-	route_ = pathFind(start_x, start_y, end_x, end_y, downsampled_map);
-	if (route_ == "")
+	bool route_found = pathFind(start_x, start_y, end_x, end_y, downsampled_map, route_);
+	Instrumentation::addCount("a_star_searches", 1);
+	if (route_found == false)
 	{
 		if (end_point_valid_neighborhood_radius > 0)
 		{
@@ -296,52 +502,41 @@ double AStarPlanner::planPath(const cv::Mat& map, const cv::Point& start_point,
 					{
 						if ((abs(dy)!=r && abs(dx)!=r) || end_x+dx<0 || end_x+dx>=n || end_y+dy<0 || end_y+dy>=m)
 							continue;
-						route_ = pathFind(start_x, start_y, end_x+dx, end_y+dy, downsampled_map);
-						if (route_ != "")
+						route_found = pathFind(start_x, start_y, end_x+dx, end_y+dy, downsampled_map, route_);
+						if (route_found == true)
 							break;
 					}
-					if (route_ != "")
+					if (route_found == true)
 						break;
 				}
-				if (route_ != "")
+				if (route_found == true)
 					break;
 			}
 		}
-		if (route_ == "")
+		if (route_found == false)
 		{
+			Instrumentation::addCount("a_star_expansions", expanding_counter_);
 //			std::cout << "No path from " << start_point << " to " << end_point << " found for map of size " << map.rows << "x" << map.cols << " and downsampling factor " << downsampling_factor << std::endl;
 			return 1e100; //return extremely large distance as path length if the rout could not be generated
 		}
 	}
 //	clock_t end = clock();
 //	double time_elapsed = double(end - start);
+	Instrumentation::addCount("a_star_expansions", expanding_counter_);
 
 	// follow the route on the map and update the path length
-	if (route_.length() > 0)
+	if (route_.size() > 1)
 	{
-		int j;
-		char c;
-		int x = start_x;
-		int y = start_y;
 		const double straight_step = (1. / downsampling_factor);
 		const double diagonal_step = (std::sqrt(2.) / downsampling_factor);
-		for (int i = 0; i < route_.length(); i++)
+		for (size_t i = 1; i < route_.size(); i++)
 		{
-			//get the next char of the string and make it an integer, which shows the direction
-			c = route_.at(i);
-			j=c-'0';
-			x = x + dx[j];
-			y = y + dy[j];
 			//Update the pathlength with the directions of the path. When the path goes vertical or horizontal add length 1.
 			//When it goes diagonal add sqrt(2)
-			if (j == 0 || j == 2 || j == 4 || j == 6)
-			{
+			if (route_[i].x == route_[i-1].x || route_[i].y == route_[i-1].y)
 				path_length += straight_step;
-			}
-			if (j == 1 || j == 3 || j == 5 || j == 7)
-			{
+			else
 				path_length += diagonal_step;
-			}
 		}
 	}
 
@@ -356,7 +551,7 @@ double AStarPlanner::planPath(const cv::Mat& map, const cv::Mat& downsampled_map
 		const double robot_radius, const double map_resolution, const int end_point_valid_neighborhood_radius, cv::Mat* draw_path_map,
 		std::vector<cv::Point>* route)
 {
-	route_ = "";
+	route_.clear();
 	double step_length = 1./downsampling_factor;
 //	cv::Mat debug = map.clone();
 //	cv::circle(debug, start_point, 2, cv::Scalar(127), CV_FILLED);
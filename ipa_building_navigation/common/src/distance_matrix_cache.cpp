@@ -0,0 +1,244 @@
+#include <ipa_building_navigation/distance_matrix_cache.h>
+
+#include <iostream>
+#include <sstream>
+#include <iomanip>
+#include <fstream>
+#include <cstdio>
+#include <cstring>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+// FNV-1a hash, 64 bit version
+static const boost::uint64_t fnv_offset_basis = 14695981039346656037ULL;
+static const boost::uint64_t fnv_prime = 1099511628211ULL;
+
+static inline void hashBytes(boost::uint64_t& hash, const void* data, const size_t length)
+{
+	const unsigned char* bytes = (const unsigned char*)data;
+	for (size_t i=0; i<length; ++i)
+	{
+		hash ^= bytes[i];
+		hash *= fnv_prime;
+	}
+}
+
+// layout of the files of the on-disk store: header followed by rows*cols doubles
+struct DistanceMatrixFileHeader
+{
+	char magic[8];
+	boost::uint64_t key;
+	boost::int32_t rows;
+	boost::int32_t cols;
+	boost::int32_t version;		// DistanceMatrixCache::format_version of the writer
+	boost::int32_t reserved;
+};
+static const char distance_matrix_file_magic[8] = {'I','P','A','D','M','A','T','2'};
+
+DistanceMatrixCache::DistanceMatrixCache()
+: capacity_(0)
+{
+}
+
+DistanceMatrixCache& DistanceMatrixCache::getInstance()
+{
+	static DistanceMatrixCache instance;
+	return instance;
+}
+
+void DistanceMatrixCache::configure(const size_t capacity, const std::string& directory)
+{
+	boost::mutex::scoped_lock lock(mutex_);
+	capacity_ = capacity;
+	directory_ = directory;
+	if (directory_.length() > 0)
+		mkdir(directory_.c_str(), 0755);
+	while (entries_.size() > capacity_)
+	{
+		entry_index_.erase(entries_.back().first);
+		entries_.pop_back();
+	}
+}
+
+bool DistanceMatrixCache::isEnabled()
+{
+	boost::mutex::scoped_lock lock(mutex_);
+	return (capacity_ > 0 || directory_.length() > 0);
+}
+
+boost::uint64_t DistanceMatrixCache::computeMapHash(const cv::Mat& map)
+{
+	boost::uint64_t hash = fnv_offset_basis;
+	const boost::int32_t header[4] = {format_version, map.rows, map.cols, map.type()};
+	hashBytes(hash, header, sizeof(header));
+	const size_t row_length = map.cols*map.elemSize();
+	for (int v=0; v<map.rows; ++v)
+		hashBytes(hash, map.ptr(v), row_length);
+	return hash;
+}
+
+boost::uint64_t DistanceMatrixCache::computeKey(const cv::Mat& map, const std::vector<cv::Point>& points, const double downsampling_factor,
+		const double robot_radius, const double map_resolution, const int tag)
+{
+	return computeKey(computeMapHash(map), points, downsampling_factor, robot_radius, map_resolution, tag);
+}
+
+boost::uint64_t DistanceMatrixCache::computeKey(const boost::uint64_t map_hash, const std::vector<cv::Point>& points, const double downsampling_factor,
+		const double robot_radius, const double map_resolution, const int tag)
+{
+	// continue the FNV-1a hash of the map with the remaining inputs
+	boost::uint64_t hash = map_hash;
+	const boost::int32_t int_tag = tag;
+	hashBytes(hash, &int_tag, sizeof(int_tag));
+	hashBytes(hash, &downsampling_factor, sizeof(double));
+	hashBytes(hash, &robot_radius, sizeof(double));
+	hashBytes(hash, &map_resolution, sizeof(double));
+	for (size_t i=0; i<points.size(); ++i)
+	{
+		const boost::int32_t point[2] = {points[i].x, points[i].y};
+		hashBytes(hash, point, sizeof(point));
+	}
+	return hash;
+}
+
+bool DistanceMatrixCache::lookup(const boost::uint64_t key, cv::Mat& matrix)
+{
+	boost::mutex::scoped_lock lock(mutex_);
+
+	std::map<boost::uint64_t, EntryList::iterator>::iterator it = entry_index_.find(key);
+	if (it != entry_index_.end())
+	{
+		// mark as most recently used
+		entries_.splice(entries_.begin(), entries_, it->second);
+		it->second->second.copyTo(matrix);
+		return true;
+	}
+
+	if (directory_.length() > 0)
+	{
+		cv::Mat loaded_matrix;
+		if (readFromDisk(key, loaded_matrix) == true)
+		{
+			if (capacity_ > 0)
+				insertInMemory(key, loaded_matrix);
+			loaded_matrix.copyTo(matrix);
+			return true;
+		}
+	}
+
+	return false;
+}
+
+void DistanceMatrixCache::store(const boost::uint64_t key, const cv::Mat& matrix)
+{
+	boost::mutex::scoped_lock lock(mutex_);
+	if (capacity_ > 0)
+		insertInMemory(key, matrix.clone());
+	if (directory_.length() > 0)
+		writeToDisk(key, matrix);
+}
+
+void DistanceMatrixCache::clear()
+{
+	boost::mutex::scoped_lock lock(mutex_);
+	entries_.clear();
+	entry_index_.clear();
+}
+
+void DistanceMatrixCache::insertInMemory(const boost::uint64_t key, const cv::Mat& matrix)
+{
+	std::map<boost::uint64_t, EntryList::iterator>::iterator it = entry_index_.find(key);
+	if (it != entry_index_.end())
+	{
+		it->second->second = matrix;
+		entries_.splice(entries_.begin(), entries_, it->second);
+		return;
+	}
+	entries_.push_front(std::pair<boost::uint64_t, cv::Mat>(key, matrix));
+	entry_index_[key] = entries_.begin();
+	while (entries_.size() > capacity_)
+	{
+		entry_index_.erase(entries_.back().first);
+		entries_.pop_back();
+	}
+}
+
+std::string DistanceMatrixCache::getFileName(const boost::uint64_t key) const
+{
+	std::stringstream ss;
+	ss << directory_ << "/distance_matrix_" << std::hex << std::setw(16) << std::setfill('0') << key << ".dmat";
+	return ss.str();
+}
+
+bool DistanceMatrixCache::readFromDisk(const boost::uint64_t key, cv::Mat& matrix) const
+{
+	const std::string filename = getFileName(key);
+	const int file_descriptor = open(filename.c_str(), O_RDONLY);
+	if (file_descriptor < 0)
+		return false;
+
+	struct stat file_status;
+	if (fstat(file_descriptor, &file_status) != 0 || file_status.st_size < (off_t)sizeof(DistanceMatrixFileHeader))
+	{
+		close(file_descriptor);
+		return false;
+	}
+	const size_t file_size = file_status.st_size;
+	void* mapped_file = mmap(NULL, file_size, PROT_READ, MAP_PRIVATE, file_descriptor, 0);
+	close(file_descriptor);
+	if (mapped_file == MAP_FAILED)
+		return false;
+
+	// check the header before copying the data
+	bool valid = false;
+	DistanceMatrixFileHeader header;
+	memcpy(&header, mapped_file, sizeof(header));
+	if (memcmp(header.magic, distance_matrix_file_magic, sizeof(header.magic)) == 0 && header.version == format_version && header.key == key &&
+			header.rows >= 0 && header.cols >= 0 && file_size == sizeof(header) + (size_t)header.rows*header.cols*sizeof(double))
+	{
+		cv::Mat mapped_matrix(header.rows, header.cols, CV_64F, (unsigned char*)mapped_file + sizeof(header));
+		mapped_matrix.copyTo(matrix);
+		valid = true;
+	}
+	else
+		std::cout << "DistanceMatrixCache::readFromDisk: Warning: invalid or outdated cache file " << filename << std::endl;
+
+	munmap(mapped_file, file_size);
+	return valid;
+}
+
+void DistanceMatrixCache::writeToDisk(const boost::uint64_t key, const cv::Mat& matrix) const
+{
+	if (matrix.type() != CV_64F)
+		return;
+
+	// write to a temporary file first, then rename, so that readers never see partially written files
+	const std::string filename = getFileName(key);
+	std::stringstream temp_filename;
+	temp_filename << filename << ".tmp" << getpid();
+	std::ofstream file(temp_filename.str().c_str(), std::ios::binary);
+	if (file.is_open() == false)
+	{
+		std::cout << "DistanceMatrixCache::writeToDisk: Error: could not open " << temp_filename.str() << std::endl;
+		return;
+	}
+	DistanceMatrixFileHeader header;
+	memcpy(header.magic, distance_matrix_file_magic, sizeof(header.magic));
+	header.key = key;
+	header.rows = matrix.rows;
+	header.cols = matrix.cols;
+	header.version = format_version;
+	header.reserved = 0;
+	file.write((const char*)&header, sizeof(header));
+	for (int v=0; v<matrix.rows; ++v)
+		file.write((const char*)matrix.ptr<double>(v), matrix.cols*sizeof(double));
+	file.close();
+	if (file.fail() == true || rename(temp_filename.str().c_str(), filename.c_str()) != 0)
+	{
+		std::cout << "DistanceMatrixCache::writeToDisk: Error: could not write " << filename << std::endl;
+		remove(temp_filename.str().c_str());
+	}
+}
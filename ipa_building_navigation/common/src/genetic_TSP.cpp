@@ -1,11 +1,14 @@
 #include <ipa_building_navigation/genetic_TSP.h>
+#include <ipa_building_navigation/instrumentation.h>
 
 #include <boost/thread.hpp>
 #include <boost/chrono.hpp>
 
 //Default constructor
 GeneticTSPSolver::GeneticTSPSolver()
-: abort_computation_(false)
+: number_children_(8), min_generations_(2300), stagnation_limit_(100), max_generations_(0), time_budget_(0.),
+  number_of_threads_(1), number_nodes_(0), path_size_(0), selected_mutation_type_(-1), max_moves_(0), parent_length_(0.),
+  number_of_generations_(0), stagnation_counter_(0), continue_evolution_(false), abort_computation_(false)
 {
 
 }
@@ -23,6 +26,34 @@ void GeneticTSPSolver::abortComputation()
 	abort_computation_ = true;
 }
 
+void GeneticTSPSolver::setNumberOfChildren(const int number_children)
+{
+	number_children_ = std::max(1, number_children);
+}
+
+void GeneticTSPSolver::setGenerationBudget(const int min_generations, const int stagnation_limit, const int max_generations)
+{
+	min_generations_ = std::max(0, min_generations);
+	stagnation_limit_ = std::max(1, stagnation_limit);
+	max_generations_ = std::max(0, max_generations);
+}
+
+void GeneticTSPSolver::setTimeBudget(const double time_budget)
+{
+	time_budget_ = std::max(0., time_budget);
+}
+
+void GeneticTSPSolver::setNumberOfThreads(const int number_of_threads)
+{
+	number_of_threads_ = (number_of_threads < 1 ? std::max(1, (int)boost::thread::hardware_concurrency()) : number_of_threads);
+}
+
+void GeneticTSPSolver::setDistanceMatrixSettings(const DistanceMatrixSettings& settings)
+{
+	distance_matrix_settings_ = settings;
+	pathplanner_.setSearchMode(settings.astar_search_mode);
+}
+
 ////Function to construct the distance matrix from the given points. See the definition at solveGeneticTSP for the style of this matrix.
 //void GeneticTSPSolver::constructDistanceMatrix(cv::Mat& distance_matrix, const cv::Mat& original_map, const int number_of_nodes,
 //        const std::vector<cv::Point>& points, double downsampling_factor, double robot_radius, double map_resolution)
@@ -61,11 +92,11 @@ void GeneticTSPSolver::abortComputation()
 //		1. The rows show from which Node the length is calculated.
 //		2. For the columns in a row the Matrix shows the distance to the Node in the column.
 //		3. From the node to itself the distance is 0.
-double GeneticTSPSolver::getPathLength(const cv::Mat& path_length_Matrix, std::vector<int> given_path)
+double GeneticTSPSolver::getPathLength(const cv::Mat& path_length_Matrix, const std::vector<int>& given_path)
 {
 	double length_of_given_path = 0;
 
-	for (int i = 0; i < given_path.size() - 1; i++)
+	for (int i = 0; i < (int)given_path.size() - 1; i++)
 	{
 		length_of_given_path += path_length_Matrix.at<double>(given_path[i], given_path[i + 1]);
 	}
@@ -73,117 +104,164 @@ double GeneticTSPSolver::getPathLength(const cv::Mat& path_length_Matrix, std::v
 	return length_of_given_path;
 }
 
-// This Function takes the given path and mutates it. A mutation is a random change of the path-order. For example random
-// nodes can be switched, or a random intervall of nodes can be inverted. Only the first and last Node can't be changed, because
-// they are given from the Main-function.
-std::vector<int> GeneticTSPSolver::mutatePath(const std::vector<int>& parent_path)
+// Each thread uses an own linear congruential generator, so that the threads neither share the state of rand() nor need to lock it.
+int GeneticTSPSolver::randomNumber(unsigned int& state, const int max_value)
 {
-	std::vector<int> mutated_path;
+	state = state*1103515245u + 12345u;
+	return (int)((state>>16) % (unsigned int)max_value);
+}
 
-	std::vector<int> temporary_path;
-	std::vector<int> saving_variable_path = parent_path; //saving-variable for the one time mutated path
+// Length change of the path when switching the nodes at the positions i<j. Only the edges adjacent to both positions change.
+double GeneticTSPSolver::switchLengthChange(const int* path, const int i, const int j) const
+{
+	const int a = path[i];
+	const int b = path[j];
+	if (j == i+1)
+		return distance(path[i-1], b) + distance(b, a) + distance(a, path[j+1])
+				- distance(path[i-1], a) - distance(a, b) - distance(b, path[j+1]);
+	return distance(path[i-1], b) + distance(b, path[i+1]) + distance(path[j-1], a) + distance(a, path[j+1])
+			- distance(path[i-1], a) - distance(a, path[i+1]) - distance(path[j-1], b) - distance(b, path[j+1]);
+}
 
-	//this variable sets which aspect should be changed:
-	//		0: random nodes should be switched
-	//		1: random intervall should be inverted:
-	int what_to_change = (rand() % 2);
+// Length change of the path when inverting the interval [i,j]. With a symmetrical matrix only the two edges at the ends of
+// the interval change.
+double GeneticTSPSolver::inversionLengthChange(const int* path, const int i, const int j) const
+{
+	return distance(path[i-1], path[j]) + distance(path[i], path[j+1]) - distance(path[i-1], path[i]) - distance(path[j], path[j+1]);
+}
 
-	if (what_to_change == 0) //random node-switching
+// This Function creates a mutated child of the parent path. A mutation is a random change of the path-order. For example random
+// nodes can be switched, or a random intervall of nodes can be inverted. Only the first and last Node can't be changed, because
+// they are given from the Main-function.
+// The child is stored as its list of moves. Switches depend on each other, so they are applied to the working path of the thread
+// for evaluating the length and undone afterwards.
+void GeneticTSPSolver::createChild(const int thread_index, const int child)
+{
+	int* path = &working_paths_[thread_index*path_size_];
+	unsigned int& random_state = random_states_[thread_index];
+	int* moves = &child_moves_[2*child*max_moves_];
+	double length_change = 0.;
+
+	// the nodes at the positions 1 .. number_nodes_-1 may be changed
+	const int mutation_type = randomNumber(random_state, 2);
+	int number_moves = 0;
+	if (mutation_type == MUTATION_SWITCH)
 	{
-		int number_of_switches = (rand() % (parent_path.size() - 3)) + 1; // Set the number of switches that should be done.
-		                                                                  // Because the first needs to be unchanged the number is limited.
-		                                                                  // Also at least one change should be done.
-		for (int change = 0; change < number_of_switches; change++)
+		number_moves = randomNumber(random_state, number_nodes_-2) + 1;	// at least one switch
+		for (int move=0; move<number_moves; ++move)
 		{
-			temporary_path.clear(); //reset the temporary path to fill it with new order
-			bool switched = false; //this variable makes sure that the switch has been done
-			do
+			int i=0, j=0;
+			while (i == j)
 			{
-				int node_one = (rand() % (saving_variable_path.size() - 2)) + 1; //this variables random choose which nodes should be changed
-				int node_two = (rand() % (saving_variable_path.size() - 2)) + 1; //The first and last one should be untouched
-				if (node_one != node_two) //node can't be switched with himself
-				{
-					for (int node = 0; node < saving_variable_path.size(); node++) //fill the mutated path with the information
-					{
-						if (node == node_one)
-						{
-							temporary_path.push_back(saving_variable_path[node_two]); //add the second node which should be switched
-						}
-						else if (node == node_two)
-						{
-							temporary_path.push_back(saving_variable_path[node_one]); //add the first node which should be switched
-						}
-						else
-						{
-							temporary_path.push_back(saving_variable_path[node]); //add the nodes as they are
-						}
-					}
-					switched = true;
-				}
-			} while (!switched);
-			saving_variable_path = temporary_path; //save the one time mutated path
+				i = randomNumber(random_state, number_nodes_-1) + 1;
+				j = randomNumber(random_state, number_nodes_-1) + 1;
+			}
+			if (i > j)
+				std::swap(i, j);
+			length_change += switchLengthChange(path, i, j);
+			std::swap(path[i], path[j]);
+			moves[2*move] = i;
+			moves[2*move+1] = j;
 		}
-		mutated_path = saving_variable_path; //save the finished mutated path
+		for (int move=number_moves-1; move>=0; --move)
+			std::swap(path[moves[2*move]], path[moves[2*move+1]]);
 	}
-	else if (what_to_change == 1) //random intervall-inverting (always from middle node on)
+	else
 	{
-		bool inverted = false;
-		do
+		int i=0, j=0;
+		while (i == j)
 		{
-			int node_one = (rand() % (saving_variable_path.size() - 2)) + 1; //this variables random choose which intervall
-			int node_two = (rand() % (saving_variable_path.size() - 2)) + 1; //The first and last one should be untouched
-			int inverting_counter = 0; //variable to choose the node based on distance to the node_two
-			if (node_one > node_two) //switch variables, if the node_one is bigger than the node_two (easier to work with here)
-			{
-				int tmp_node = node_one;
-				node_one = node_two;
-				node_two = tmp_node;
-			}
-			if (node_one != node_two)
-			{
-				for (int node = 0; node < parent_path.size(); node++)
-				{
-					if (node < node_one || node > node_two) //add the nodes as they are in the mutated path
-					{
-						mutated_path.push_back(parent_path[node]);
-					}
-					else //invert the intervall
-					{
-						mutated_path.push_back(parent_path[node_two - inverting_counter]);
-						inverting_counter++;
-					}
-				}
-				inverted = true;
-			}
-		} while (!inverted);
+			i = randomNumber(random_state, number_nodes_-1) + 1;
+			j = randomNumber(random_state, number_nodes_-1) + 1;
+		}
+		if (i > j)
+			std::swap(i, j);
+		length_change = inversionLengthChange(path, i, j);
+		moves[0] = i;
+		moves[1] = j;
+		number_moves = 1;
+	}
+
+	child_mutation_types_[child] = mutation_type;
+	child_move_counts_[child] = number_moves;
+	child_length_changes_[child] = length_change;
+}
+
+void GeneticTSPSolver::applyMoves(int* path, const int mutation_type, const int* moves, const int number_moves) const
+{
+	if (mutation_type == MUTATION_SWITCH)
+	{
+		for (int move=0; move<number_moves; ++move)
+			std::swap(path[moves[2*move]], path[moves[2*move+1]]);
 	}
 	else
 	{
-		ROS_INFO("Something was wrong in mutation-function.");
+		std::reverse(path+moves[0], path+moves[1]+1);
 	}
-
-	return mutated_path;
 }
 
-//This Function calculates the length of each given path and chooses the shortest one. It uses the getPathLength function.
-std::vector<int> GeneticTSPSolver::getBestPath(const std::vector<std::vector<int> > paths, const cv::Mat& pathlength_Matrix, bool& changed)
+// This function chooses the shortest of the parent and its children, like before the first child wins if several children have
+// the same length. It also checks the termination criteria.
+void GeneticTSPSolver::selectChild()
 {
-	std::vector<int> best_path = paths[0];
-
-	double best_distance = getPathLength(pathlength_Matrix, paths[0]); //saving-variable for the distance of the current best path
-
-	for (int current_path = 1; current_path < paths.size(); current_path++)
+	number_of_generations_++;
+	double best_length_change = 0.;
+	int best_child = -1;
+	for (int child=0; child<number_children_; ++child)
 	{
-		double current_distance = getPathLength(pathlength_Matrix, paths[current_path]); //get distance of current path
-		if (current_distance < best_distance)
+		if (child_length_changes_[child] < best_length_change)
 		{
-			best_distance = current_distance;
-			best_path = paths[current_path];
-			changed = true;
+			best_length_change = child_length_changes_[child];
+			best_child = child;
 		}
 	}
 
-	return best_path;
+	selected_mutation_type_ = -1;
+	if (best_child >= 0)
+	{
+		parent_length_ += best_length_change;
+		selected_mutation_type_ = child_mutation_types_[best_child];
+		selected_moves_.assign(child_moves_.begin()+2*best_child*max_moves_, child_moves_.begin()+2*(best_child*max_moves_+child_move_counts_[best_child]));
+	}
+
+	// when a specified amount of steps have been done the algorithm checks if the last paths didn't change
+	if (number_of_generations_ >= min_generations_)
+	{
+		if (best_child >= 0)
+			stagnation_counter_ = stagnation_limit_;
+		else
+			stagnation_counter_--;
+	}
+	continue_evolution_ = (stagnation_counter_ > 0 || number_of_generations_ < min_generations_);
+	if (max_generations_ > 0 && number_of_generations_ >= max_generations_)
+		continue_evolution_ = false;
+	if (time_budget_ > 0. && timer_.getElapsedTimeInSec() > time_budget_)
+		continue_evolution_ = false;
+	if (abort_computation_ == true)
+		continue_evolution_ = false;
+}
+
+// Thread t evaluates the children t, t+number_of_threads_, ... of each generation on its own working copy of the parent.
+void GeneticTSPSolver::evolutionWorker(const int thread_index, boost::barrier* barrier)
+{
+	int* path = &working_paths_[thread_index*path_size_];
+	while (true)
+	{
+		for (int child=thread_index; child<number_children_; child+=number_of_threads_)
+			createChild(thread_index, child);
+
+		if (barrier != NULL)
+			barrier->wait();
+		if (thread_index == 0)
+			selectChild();
+		if (barrier != NULL)
+			barrier->wait();
+
+		if (continue_evolution_ == false)
+			return;
+		if (selected_mutation_type_ >= 0)
+			applyMoves(path, selected_mutation_type_, &selected_moves_[0], (int)selected_moves_.size()/2);
+	}
 }
 
 //This is a solver for the TSP using a genetic algorithm. It calculates a initial path by using the nearest-neighbor
@@ -204,6 +282,8 @@ std::vector<int> GeneticTSPSolver::getBestPath(const std::vector<std::vector<int
 //don't compute distance matrix
 std::vector<int> GeneticTSPSolver::solveGeneticTSP(const cv::Mat& path_length_Matrix, const int start_Node)
 {
+	ScopedSpan span("tsp_genetic");
+	timer_.start();
 	std::vector<int> return_vector;
 	NearestNeighborTSPSolver nearest_neighbor_solver;
 
@@ -212,37 +292,56 @@ std::vector<int> GeneticTSPSolver::solveGeneticTSP(const cv::Mat& path_length_Ma
 
 	if(path_length_Matrix.rows > 2) //check if graph has at least three members, if not the algorithm won't work properly
 	{
-		bool changed_path = false; //this variable checks if the path has been changed in the mutation process
-		int changeing_counter = 100; //this variable is a counter for how many times a path has been the same
+		// set up the flat arrays of the evolution
+		number_nodes_ = path_length_Matrix.rows;
+		path_size_ = number_nodes_ + 1;
+		distances_.resize(number_nodes_*number_nodes_);
+		for (int i=0; i<number_nodes_; ++i)
+			for (int j=0; j<number_nodes_; ++j)
+				distances_[i*number_nodes_+j] = path_length_Matrix.at<double>(i,j);
+		const int number_of_threads = std::max(1, std::min(number_of_threads_, number_children_));
+		working_paths_.resize(number_of_threads*path_size_);
+		random_states_.resize(number_of_threads);
+		for (int t=0; t<number_of_threads; ++t)
+		{
+			std::copy(calculated_path.begin(), calculated_path.end(), working_paths_.begin()+t*path_size_);
+			random_states_[t] = 1 + 7919*t;
+		}
+		max_moves_ = std::max(1, number_nodes_-2);
+		child_mutation_types_.resize(number_children_);
+		child_move_counts_.resize(number_children_);
+		child_moves_.resize(2*number_children_*max_moves_);
+		child_length_changes_.resize(number_children_);
+		selected_moves_.reserve(2*max_moves_);
+		parent_length_ = getPathLength(path_length_Matrix, calculated_path);
+		number_of_generations_ = 0;
+		stagnation_counter_ = stagnation_limit_;
+		continue_evolution_ = true;
+
+		// run the evolution, the calling thread works as thread 0
+		const int saved_number_of_threads = number_of_threads_;
+		number_of_threads_ = number_of_threads;
+		if (number_of_threads > 1)
+		{
+			boost::barrier barrier(number_of_threads);
+			boost::thread_group workers;
+			for (int t=1; t<number_of_threads; ++t)
+				workers.create_thread(boost::bind(&GeneticTSPSolver::evolutionWorker, this, t, &barrier));
+			evolutionWorker(0, &barrier);
+			workers.join_all();
+		}
+		else
+		{
+			evolutionWorker(0, NULL);
+		}
+		number_of_threads_ = saved_number_of_threads;
 
-		int number_of_generations = 0;
+		if (abort_computation_==true)
+			return return_vector;
 
-		do
-		{
-			if (abort_computation_==true)
-				return return_vector;
-
-			number_of_generations++;
-			changed_path = false;
-			std::vector < std::vector<int> > current_generation_paths; //vector to save the current generation
-			current_generation_paths.push_back(calculated_path); //first path is always the parent --> important for checking if the path has changed in getBestPath!!
-			for (int child = 0; child < 8; child++) //get 8 children and add them to the vector
-			{
-				current_generation_paths.push_back(mutatePath(calculated_path));
-			}
-			calculated_path = getBestPath(current_generation_paths, path_length_Matrix, changed_path); //get the best path of this generation
-			if (number_of_generations >= 2300) //when a specified amount of steps have been done the algorithm checks if the last paths didn't change
-			{
-				if (changed_path)
-				{
-					changeing_counter = 100; //reset the counting-variable
-				}
-				else
-				{
-					changeing_counter -= 1; //decrease the counting-variable by 1
-				}
-			}
-		} while (changeing_counter > 0 || number_of_generations < 2300);
+		calculated_path.assign(working_paths_.begin(), working_paths_.begin()+path_size_);
+		std::cout << "GeneticTSPSolver::solveGeneticTSP: path length " << parent_length_ << " after " << number_of_generations_ << " generations in "
+				<< timer_.getElapsedTimeInMilliSec() << " ms" << std::endl;
 	}
 
 	//return the calculated path without the last node (same as start node)
@@ -264,7 +363,7 @@ std::vector<int> GeneticTSPSolver::solveGeneticTSP(const cv::Mat& original_map,
 	cv::Mat distance_matrix_ref;
 	if (distance_matrix != 0)
 		distance_matrix_ref = *distance_matrix;
-	DistanceMatrix distance_matrix_computation;
+	DistanceMatrix distance_matrix_computation(distance_matrix_settings_);
 	boost::thread t(boost::bind(&GeneticTSPSolver::distance_matrix_thread, this, boost::ref(distance_matrix_computation),
 			boost::ref(distance_matrix_ref), boost::cref(original_map), boost::cref(points), downsampling_factor,
 			robot_radius, map_resolution, boost::ref(pathplanner_)));
@@ -294,9 +393,9 @@ std::vector<int> GeneticTSPSolver::solveGeneticTSPClean(const cv::Mat& original_
 {
 	// compute a cleaned distance matrix
 	cv::Mat distance_matrix_cleaned;
-	std::map<int,int> cleaned_index_to_original_index_mapping;	// maps the indices of the cleaned distance_matrix to the original indices of the original distance_matrix
+	std::vector<int> cleaned_index_to_original_index_mapping;	// maps the indices of the cleaned distance_matrix to the original indices of the original distance_matrix
 	int new_start_node = start_node;
-	DistanceMatrix distance_matrix_computation;
+	DistanceMatrix distance_matrix_computation(distance_matrix_settings_);
 	distance_matrix_computation.computeCleanedDistanceMatrix(original_map, points, downsampling_factor, robot_radius, map_resolution, pathplanner_,
 			distance_matrix_cleaned, cleaned_index_to_original_index_mapping, new_start_node);
 
@@ -307,7 +406,7 @@ std::vector<int> GeneticTSPSolver::solveGeneticTSPClean(const cv::Mat& original_
 
 // compute TSP with pre-computed cleaned distance matrix (does not contain any infinity paths)
 std::vector<int> GeneticTSPSolver::solveGeneticTSPWithCleanedDistanceMatrix(const cv::Mat& distance_matrix,
-		const std::map<int,int>& cleaned_index_to_original_index_mapping, const int start_node)
+		const std::vector<int>& cleaned_index_to_original_index_mapping, const int start_node)
 {
 	// solve TSP and re-index points to original indices
 	std::vector<int> optimal_order = solveGeneticTSP(distance_matrix, start_node);
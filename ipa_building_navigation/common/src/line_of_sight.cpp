@@ -0,0 +1,150 @@
+#include <ipa_building_navigation/line_of_sight.h>
+#include <ipa_building_navigation/instrumentation.h>
+
+#include <algorithm>
+#include <cstdlib>
+
+// parameters of one line in the form of cv::LineIterator with connectivity 8: every step advances by one pixel along the major
+// axis and additionally by one pixel along the minor axis if the error term is negative
+struct LineParameters
+{
+	cv::Point start;
+	cv::Point major_step;	// unit step along the major axis
+	cv::Point minor_step;	// unit step along the minor axis
+	int major_length;		// absolute coordinate difference along the major axis
+	int minor_length;		// absolute coordinate difference along the minor axis
+	int count;				// number of pixels of the line
+};
+
+// computes the line parameters, returns false if the line does not touch the image
+static bool setupLine(const cv::Size& size, cv::Point start, cv::Point goal, LineParameters& line)
+{
+	// clip the line at the image borders like cv::LineIterator
+	if ((unsigned)start.x >= (unsigned)size.width || (unsigned)start.y >= (unsigned)size.height
+			|| (unsigned)goal.x >= (unsigned)size.width || (unsigned)goal.y >= (unsigned)size.height)
+	{
+		if (cv::clipLine(size, start, goal) == false)
+			return false;
+	}
+
+	const int dx = goal.x - start.x;
+	const int dy = goal.y - start.y;
+	const cv::Point x_step((dx < 0 ? -1 : 1), 0);
+	const cv::Point y_step(0, (dy < 0 ? -1 : 1));
+	line.start = start;
+	if (std::abs(dy) > std::abs(dx))
+	{
+		line.major_step = y_step;
+		line.minor_step = x_step;
+		line.major_length = std::abs(dy);
+		line.minor_length = std::abs(dx);
+	}
+	else
+	{
+		line.major_step = x_step;
+		line.minor_step = y_step;
+		line.major_length = std::abs(dx);
+		line.minor_length = std::abs(dy);
+	}
+	line.count = line.major_length + 1;
+	return true;
+}
+
+// returns the pixel after n steps, the number of minor steps taken so far follows in closed form from the error term of the
+// incremental traversal, which allows to jump to any pixel of the line
+static inline cv::Point linePixel(const LineParameters& line, const int n)
+{
+	const int m = (line.major_length == 0 ? 0 : (2*line.minor_length*n + line.major_length - 1) / (2*line.major_length));
+	return line.start + n*line.major_step + m*line.minor_step;
+}
+
+void LineOfSight::computeDistanceField(const cv::Mat& map, cv::Mat& distance_field, const uchar free_threshold)
+{
+	cv::Mat free_space = (map >= free_threshold);
+	cv::distanceTransform(free_space, distance_field, CV_DIST_L2, CV_DIST_MASK_PRECISE);
+}
+
+bool LineOfSight::isFree(const cv::Mat& map, const cv::Point& start, const cv::Point& goal, const uchar free_threshold,
+		const cv::Mat* distance_field)
+{
+	LineParameters line;
+	if (setupLine(map.size(), start, goal, line) == false)
+		return true;	// no pixel to check, like an empty cv::LineIterator
+
+	if (distance_field == NULL)
+	{
+		// incremental traversal on the pixel buffer with a branch-free error update
+		const int map_step = (int)map.step;
+		const int major_offset = line.major_step.x + line.major_step.y*map_step;
+		const int minor_offset = line.minor_step.x + line.minor_step.y*map_step;
+		const int plus_delta = 2*line.major_length;
+		const int minus_delta = -2*line.minor_length;
+		int error = line.major_length - 2*line.minor_length;
+		const uchar* pixel = map.ptr<uchar>(line.start.y) + line.start.x;
+		for (int n=0; n<line.count; ++n)
+		{
+			if (*pixel < free_threshold)
+				return false;
+			const int mask = (error < 0 ? -1 : 0);
+			error += minus_delta + (plus_delta & mask);
+			if (n+1 < line.count)
+				pixel += major_offset + (minor_offset & mask);
+		}
+		return true;
+	}
+
+	// traversal with skip-ahead: all pixels closer to the current pixel than its distance to the closest blocked pixel are free,
+	// and the pixel k steps further along the line is at most k*sqrt(2) away, so these pixels do not need to be read
+	int n = 0;
+	while (n < line.count)
+	{
+		const cv::Point pixel = linePixel(line, n);
+		if (map.at<uchar>(pixel) < free_threshold)
+			return false;
+		const int skip = (int)((distance_field->at<float>(pixel) - 0.5f) * 0.70710678f);
+		n += std::max(1, skip);
+	}
+	// the skip may jump over the goal, it is free then as well
+	return true;
+}
+
+void LineOfSight::checkVisibility(const cv::Mat& map, const cv::Point& start, const std::vector<cv::Point>& goals,
+		std::vector<bool>& visible, const uchar free_threshold, const cv::Mat* distance_field)
+{
+	visible.assign(goals.size(), false);
+
+	// every line inside the image starts at start, so a blocked start blocks all of them
+	const bool start_inside = (start.x >= 0 && start.x < map.cols && start.y >= 0 && start.y < map.rows);
+	if (start_inside == true && map.at<uchar>(start) < free_threshold)
+		return;
+
+	for (size_t g=0; g<goals.size(); ++g)
+		visible[g] = isFree(map, start, goals[g], free_threshold, distance_field);
+	Instrumentation::addCount("raycasts", (long)goals.size());
+}
+
+void LineOfSight::getLine(const cv::Mat& map, const cv::Point& start, const cv::Point& goal, std::vector<cv::Point>& line_pixels)
+{
+	line_pixels.clear();
+	LineParameters line;
+	if (setupLine(map.size(), start, goal, line) == false)
+		return;
+
+	line_pixels.resize(line.count);
+	cv::Point pixel = line.start;
+	int error = line.major_length - 2*line.minor_length;
+	for (int n=0; n<line.count; ++n)
+	{
+		line_pixels[n] = pixel;
+		if (error < 0)
+		{
+			error += 2*line.major_length - 2*line.minor_length;
+			pixel += line.major_step + line.minor_step;
+		}
+		else
+		{
+			error -= 2*line.minor_length;
+			pixel += line.major_step;
+		}
+	}
+}
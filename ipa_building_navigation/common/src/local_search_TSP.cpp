@@ -0,0 +1,472 @@
+#include <ipa_building_navigation/local_search_TSP.h>
+#include <ipa_building_navigation/instrumentation.h>
+
+#include <algorithm>
+#include <iostream>
+
+// minimal improvement of a move, avoids cycling due to rounding errors
+static const double min_gain = 1e-7;
+
+// problems up to this size are solved by enumeration
+static const int max_exact_nodes = 8;
+
+LocalSearchTSPSolver::LocalSearchTSPSolver()
+: number_nodes_(0), sparse_distances_(NULL), tour_length_(0.), random_state_(1), abort_computation_(false), time_budget_(1.), max_kicks_per_node_(50), number_neighbors_(10)
+{
+}
+
+void LocalSearchTSPSolver::abortComputation()
+{
+	abort_computation_ = true;
+}
+
+void LocalSearchTSPSolver::setTimeBudget(const double time_budget)
+{
+	time_budget_ = time_budget;
+}
+
+void LocalSearchTSPSolver::setMaxKicksPerNode(const int max_kicks_per_node)
+{
+	max_kicks_per_node_ = std::max(0, max_kicks_per_node);
+}
+
+void LocalSearchTSPSolver::setNumberOfNeighbors(const int number_neighbors)
+{
+	number_neighbors_ = std::max(1, number_neighbors);
+}
+
+int LocalSearchTSPSolver::randomNumber(const int max_value)
+{
+	// own linear congruential generator, so that concurrent solvers do not share the state of rand()
+	random_state_ = random_state_*1103515245u + 12345u;
+	return (int)((random_state_>>16) % (unsigned int)max_value);
+}
+
+double LocalSearchTSPSolver::tourLength() const
+{
+	double length = 0.;
+	for (int i=0; i<number_nodes_; ++i)
+		length += distance(tour_[i], tour_[(i+1)%number_nodes_]);
+	return length;
+}
+
+bool LocalSearchTSPSolver::isBudgetExceeded()
+{
+	return (time_budget_ > 0. && timer_.getElapsedTimeInSec() > time_budget_);
+}
+
+void LocalSearchTSPSolver::computeNeighborLists()
+{
+	const int number_neighbors = std::min(number_neighbors_, number_nodes_-1);
+	neighbors_.resize(number_nodes_);
+	if (sparse_distances_ != NULL)
+	{
+		// the stored neighbors are already sorted by distance
+		for (int a=0; a<number_nodes_; ++a)
+		{
+			const int* neighbors = sparse_distances_->getNeighbors(a);
+			neighbors_[a].assign(neighbors, neighbors+std::min(number_neighbors, sparse_distances_->getNumberNeighbors(a)));
+		}
+		return;
+	}
+	std::vector<std::pair<double, int> > candidates(number_nodes_-1);
+	for (int a=0; a<number_nodes_; ++a)
+	{
+		int k=0;
+		for (int b=0; b<number_nodes_; ++b)
+			if (b != a)
+				candidates[k++] = std::pair<double, int>(distance(a,b), b);
+		std::partial_sort(candidates.begin(), candidates.begin()+number_neighbors, candidates.end());
+		neighbors_[a].resize(number_neighbors);
+		for (int n=0; n<number_neighbors; ++n)
+			neighbors_[a][n] = candidates[n].second;
+	}
+}
+
+void LocalSearchTSPSolver::computeNearestNeighborTour(const int start_node)
+{
+	std::vector<bool> visited(number_nodes_, false);
+	tour_.resize(number_nodes_);
+	position_.resize(number_nodes_);
+	int current = start_node;
+	visited[current] = true;
+	tour_[0] = current;
+	for (int i=1; i<number_nodes_; ++i)
+	{
+		int best_node = -1;
+		if (sparse_distances_ != NULL)
+		{
+			best_node = sparse_distances_->findNearestUnvisited(current, visited);
+		}
+		else
+		{
+			double best_distance = 1e200;
+			for (int b=0; b<number_nodes_; ++b)
+			{
+				if (visited[b] == false && distance(current, b) < best_distance)
+				{
+					best_distance = distance(current, b);
+					best_node = b;
+				}
+			}
+		}
+		current = best_node;
+		visited[current] = true;
+		tour_[i] = current;
+	}
+	for (int i=0; i<number_nodes_; ++i)
+		position_[tour_[i]] = i;
+	tour_length_ = tourLength();
+}
+
+void LocalSearchTSPSolver::activateNode(const int node)
+{
+	if (dont_look_[node] == true)
+	{
+		dont_look_[node] = false;
+		active_nodes_.push_back(node);
+	}
+}
+
+void LocalSearchTSPSolver::reversePath(const int from, const int to)
+{
+	int i = position_[from];
+	int j = position_[to];
+	int length = (j-i+number_nodes_)%number_nodes_ + 1;
+	if (2*length > number_nodes_)
+	{
+		// reversing the rest of the tour yields the same cycle
+		i = (j+1)%number_nodes_;
+		j = (position_[from]-1+number_nodes_)%number_nodes_;
+		length = number_nodes_ - length;
+	}
+	for (int k=0; k<length/2; ++k)
+	{
+		std::swap(tour_[i], tour_[j]);
+		position_[tour_[i]] = i;
+		position_[tour_[j]] = j;
+		i = (i+1 == number_nodes_ ? 0 : i+1);
+		j = (j == 0 ? number_nodes_-1 : j-1);
+	}
+}
+
+bool LocalSearchTSPSolver::improveTwoOpt(const int a)
+{
+	// a -> b becomes a -> c, for b being the successor and the predecessor of a
+	for (int direction=0; direction<2; ++direction)
+	{
+		const int b = (direction==0 ? next(a) : previous(a));
+		const double distance_ab = distance(a,b);
+		for (size_t k=0; k<neighbors_[a].size(); ++k)
+		{
+			const int c = neighbors_[a][k];
+			const double partial_gain = distance_ab - distance(a,c);
+			if (partial_gain <= min_gain)
+				break;
+			const int d = (direction==0 ? next(c) : previous(c));
+			if (c == b || d == a)
+				continue;
+			const double gain = partial_gain + distance(c,d) - distance(b,d);
+			if (gain > min_gain)
+			{
+				if (direction == 0)
+					reversePath(b, c);	// a b ... c d -> a c ... b d
+				else
+					reversePath(a, d);	// b a ... d c -> b d ... a c
+				tour_length_ -= gain;
+				activateNode(a);
+				activateNode(b);
+				activateNode(c);
+				activateNode(d);
+				return true;
+			}
+		}
+	}
+	return false;
+}
+
+bool LocalSearchTSPSolver::improveOrOpt(const int node)
+{
+	for (int segment_length=1; segment_length<=3 && segment_length<number_nodes_-2; ++segment_length)
+	{
+		// segments starting and ending at node
+		for (int direction=0; direction<2; ++direction)
+		{
+			int first = node, last = node;
+			for (int k=1; k<segment_length; ++k)
+			{
+				if (direction == 0)
+					last = next(last);
+				else
+					first = previous(first);
+			}
+			const int before = previous(first);
+			const int after = next(last);
+			const double removal_gain = distance(before, first) + distance(last, after) - distance(before, after);
+			if (removal_gain <= min_gain)
+				continue;
+
+			// insert between the neighbors of the segment ends and their adjacent nodes
+			const int first_position = position_[first];
+			for (int end=0; end<2; ++end)
+			{
+				const int end_node = (end==0 ? first : last);
+				for (size_t k=0; k<neighbors_[end_node].size(); ++k)
+				{
+					const int c = neighbors_[end_node][k];
+					if (removal_gain - distance(end_node, c) <= min_gain)
+						break;
+					if ((position_[c]-first_position+number_nodes_)%number_nodes_ < segment_length)
+						continue;	// c belongs to the segment
+					for (int side=0; side<2; ++side)
+					{
+						const int u = (side==0 ? c : previous(c));
+						const int v = (side==0 ? next(c) : c);
+						if ((position_[u]-first_position+number_nodes_)%number_nodes_ < segment_length
+								|| (position_[v]-first_position+number_nodes_)%number_nodes_ < segment_length)
+							continue;
+						const double insertion_cost = distance(u, first) + distance(last, v) - distance(u, v);
+						const double reversed_insertion_cost = distance(u, last) + distance(first, v) - distance(u, v);
+						const bool reversed = (reversed_insertion_cost < insertion_cost);
+						const double gain = removal_gain - (reversed==true ? reversed_insertion_cost : insertion_cost);
+						if (gain > min_gain)
+						{
+							moveSegment(first, last, u, reversed);
+							tour_length_ -= gain;
+							activateNode(before);
+							activateNode(after);
+							activateNode(first);
+							activateNode(last);
+							activateNode(u);
+							activateNode(v);
+							return true;
+						}
+					}
+				}
+			}
+		}
+	}
+	return false;
+}
+
+void LocalSearchTSPSolver::moveSegment(const int segment_first, const int segment_last, const int insert_after, const bool reversed)
+{
+	std::vector<int> segment;
+	for (int node=segment_first; ; node=next(node))
+	{
+		segment.push_back(node);
+		if (node == segment_last)
+			break;
+	}
+	if (reversed == true)
+		std::reverse(segment.begin(), segment.end());
+
+	// walk the rest of the tour from the node after the segment to the node before it and insert the segment behind insert_after
+	const int before = previous(segment_first);
+	std::vector<int> new_tour;
+	new_tour.reserve(number_nodes_);
+	for (int node=next(segment_last); ; node=next(node))
+	{
+		new_tour.push_back(node);
+		if (node == insert_after)
+			new_tour.insert(new_tour.end(), segment.begin(), segment.end());
+		if (node == before)
+			break;
+	}
+	tour_.swap(new_tour);
+	for (int i=0; i<number_nodes_; ++i)
+		position_[tour_[i]] = i;
+}
+
+bool LocalSearchTSPSolver::localSearch()
+{
+	int iterations = 0;
+	while (active_nodes_.empty() == false)
+	{
+		if (abort_computation_ == true)
+			return false;
+		if (++iterations%64 == 0 && isBudgetExceeded() == true)
+			return false;
+
+		const int node = active_nodes_.back();
+		active_nodes_.pop_back();
+		dont_look_[node] = true;
+		if (improveTwoOpt(node) == false)
+			improveOrOpt(node);
+	}
+	return true;
+}
+
+void LocalSearchTSPSolver::kick()
+{
+	// exchange two neighboring segments x [B] [C] y -> x [C] [B] y, i.e. a double-bridge move restricted to a part of the tour
+	const int max_segment_length = std::max(1, std::min(50, (number_nodes_-2)/2));
+	const int length_b = 1 + randomNumber(max_segment_length);
+	const int length_c = 1 + randomNumber(max_segment_length);
+	const int start = randomNumber(number_nodes_);
+	const int x = tour_[start];
+	const int b_first = tour_[(start+1)%number_nodes_];
+	const int b_last = tour_[(start+length_b)%number_nodes_];
+	const int c_first = tour_[(start+length_b+1)%number_nodes_];
+	const int c_last = tour_[(start+length_b+length_c)%number_nodes_];
+	const int y = tour_[(start+length_b+length_c+1)%number_nodes_];
+	tour_length_ += distance(x, c_first) + distance(c_last, b_first) + distance(b_last, y)
+			- distance(x, b_first) - distance(b_last, c_first) - distance(c_last, y);
+
+	std::vector<int> window(length_b+length_c);
+	for (int k=0; k<length_c; ++k)
+		window[k] = tour_[(start+length_b+1+k)%number_nodes_];
+	for (int k=0; k<length_b; ++k)
+		window[length_c+k] = tour_[(start+1+k)%number_nodes_];
+	for (int k=0; k<(int)window.size(); ++k)
+	{
+		const int i = (start+1+k)%number_nodes_;
+		tour_[i] = window[k];
+		position_[window[k]] = i;
+	}
+
+	activateNode(x);
+	activateNode(b_first);
+	activateNode(b_last);
+	activateNode(c_first);
+	activateNode(c_last);
+	activateNode(y);
+}
+
+std::vector<int> LocalSearchTSPSolver::solveLocalSearchTSP(const cv::Mat& path_length_matrix, const int start_node)
+{
+	timer_.start();
+	number_nodes_ = path_length_matrix.rows;
+	if (number_nodes_ < 1 || start_node < 0 || start_node >= number_nodes_)
+		return std::vector<int>();
+
+	sparse_distances_ = NULL;
+	distances_.resize(number_nodes_*number_nodes_);
+	for (int i=0; i<number_nodes_; ++i)
+		for (int j=0; j<number_nodes_; ++j)
+			distances_[i*number_nodes_+j] = path_length_matrix.at<double>(i,j);
+
+	return solve(start_node);
+}
+
+std::vector<int> LocalSearchTSPSolver::solveLocalSearchTSP(const cv::Mat& path_length_matrix, const std::vector<int>& initial_tour)
+{
+	timer_.start();
+	number_nodes_ = path_length_matrix.rows;
+	if (number_nodes_ < 1 || (int)initial_tour.size() != number_nodes_)
+		return std::vector<int>();
+	std::vector<bool> visited(number_nodes_, false);
+	for (size_t i=0; i<initial_tour.size(); ++i)
+	{
+		if (initial_tour[i] < 0 || initial_tour[i] >= number_nodes_ || visited[initial_tour[i]] == true)
+			return std::vector<int>();
+		visited[initial_tour[i]] = true;
+	}
+
+	sparse_distances_ = NULL;
+	distances_.resize(number_nodes_*number_nodes_);
+	for (int i=0; i<number_nodes_; ++i)
+		for (int j=0; j<number_nodes_; ++j)
+			distances_[i*number_nodes_+j] = path_length_matrix.at<double>(i,j);
+
+	return solve(initial_tour[0], &initial_tour);
+}
+
+std::vector<int> LocalSearchTSPSolver::solveLocalSearchTSP(const SparseDistanceMatrix& distance_matrix, const int start_node)
+{
+	timer_.start();
+	number_nodes_ = distance_matrix.getNumberPoints();
+	if (number_nodes_ < 1 || start_node < 0 || start_node >= number_nodes_)
+		return std::vector<int>();
+
+	sparse_distances_ = &distance_matrix;
+	distances_.clear();
+	std::vector<int> order = solve(start_node);
+	sparse_distances_ = NULL;
+	return order;
+}
+
+std::vector<int> LocalSearchTSPSolver::solve(const int start_node, const std::vector<int>* initial_tour)
+{
+	ScopedSpan span("tsp_local_search");
+	std::vector<int> order;
+	if (number_nodes_ <= max_exact_nodes)
+	{
+		// small problems are solved exactly by enumerating all orders of the remaining nodes
+		tour_.clear();
+		tour_.push_back(start_node);
+		for (int i=0; i<number_nodes_; ++i)
+			if (i != start_node)
+				tour_.push_back(i);
+		order = tour_;
+		double best_length = tourLength();
+		while (std::next_permutation(tour_.begin()+1, tour_.end()) == true)
+		{
+			const double length = tourLength();
+			if (length < best_length)
+			{
+				best_length = length;
+				order = tour_;
+			}
+		}
+		return order;
+	}
+
+	computeNeighborLists();
+	if (initial_tour != NULL)
+	{
+		tour_ = *initial_tour;
+		position_.resize(number_nodes_);
+		for (int i=0; i<number_nodes_; ++i)
+			position_[tour_[i]] = i;
+		tour_length_ = tourLength();
+	}
+	else
+		computeNearestNeighborTour(start_node);
+	if (abort_computation_ == true)
+		return order;
+
+	// local search from the initial tour
+	dont_look_.assign(number_nodes_, false);
+	active_nodes_.assign(tour_.rbegin(), tour_.rend());
+	bool finished = localSearch();
+	std::vector<int> best_tour = tour_;
+	double best_length = tour_length_;
+
+	// iterated local search: kick the best tour and keep the result if it is shorter
+	const long max_kicks = (long)max_kicks_per_node_*number_nodes_;
+	long kicks = 0;
+	for (; kicks<max_kicks && finished==true; ++kicks)
+	{
+		if (abort_computation_ == true || isBudgetExceeded() == true)
+			break;
+		kick();
+		finished = localSearch();
+		if (tour_length_ < best_length - min_gain)
+		{
+			best_tour = tour_;
+			best_length = tour_length_;
+		}
+		else if (tour_length_ > best_length + min_gain || finished == false)
+		{
+			tour_ = best_tour;
+			for (int i=0; i<number_nodes_; ++i)
+				position_[tour_[i]] = i;
+			tour_length_ = best_length;
+			active_nodes_.clear();
+			dont_look_.assign(number_nodes_, true);
+		}
+	}
+	if (abort_computation_ == true)
+		return order;
+
+	std::cout << "LocalSearchTSPSolver::solveLocalSearchTSP: tour length " << best_length << " after " << kicks << " kicks in "
+			<< timer_.getElapsedTimeInMilliSec() << " ms" << std::endl;
+
+	// start the order at start_node
+	const int start_position = std::find(best_tour.begin(), best_tour.end(), start_node) - best_tour.begin();
+	order.resize(number_nodes_);
+	for (int i=0; i<number_nodes_; ++i)
+		order[i] = best_tour[(start_position+i)%number_nodes_];
+	return order;
+}
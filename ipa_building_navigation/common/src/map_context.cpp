@@ -0,0 +1,80 @@
+#include <ipa_building_navigation/map_context.h>
+#include <ipa_building_navigation/distance_matrix_cache.h>
+
+MapContext::MapContext(const cv::Mat& map, const double robot_radius, const double map_resolution)
+: map_(map), robot_radius_(robot_radius), map_resolution_(map_resolution), map_hash_computed_(false), map_hash_(0)
+{
+}
+
+bool MapContext::isValidFor(const cv::Mat& map) const
+{
+	return (map.data == map_.data && map.rows == map_.rows && map.cols == map_.cols && map.step == map_.step && map.type() == map_.type());
+}
+
+bool MapContext::isValidFor(const cv::Mat& map, const double robot_radius, const double map_resolution) const
+{
+	return (isValidFor(map) == true && robot_radius == robot_radius_ && map_resolution == map_resolution_);
+}
+
+const cv::Mat& MapContext::erodedMap(const int iterations) const
+{
+	std::map<int, cv::Mat>::iterator it = eroded_maps_.find(iterations);
+	if (it != eroded_maps_.end())
+		return it->second;
+
+	// continue from the most eroded map with fewer iterations, repeated erosions with a 3x3 kernel are equivalent to one erosion
+	// with the summed number of iterations
+	cv::Mat eroded_map;
+	std::map<int, cv::Mat>::iterator previous = eroded_maps_.lower_bound(iterations);
+	if (previous != eroded_maps_.begin())
+	{
+		--previous;
+		cv::erode(previous->second, eroded_map, cv::Mat(), cv::Point(-1, -1), iterations-previous->first);
+	}
+	else
+		cv::erode(map_, eroded_map, cv::Mat(), cv::Point(-1, -1), iterations);
+	return eroded_maps_[iterations] = eroded_map;
+}
+
+const cv::Mat& MapContext::getErodedMap(const int iterations) const
+{
+	boost::mutex::scoped_lock lock(mutex_);
+	return erodedMap(iterations);
+}
+
+const cv::Mat& MapContext::getDownsampledMap(const double downsampling_factor) const
+{
+	boost::mutex::scoped_lock lock(mutex_);
+	std::map<double, cv::Mat>::iterator it = downsampled_maps_.find(downsampling_factor);
+	if (it != downsampled_maps_.end())
+		return it->second;
+
+	// same steps as AStarPlanner::downsampleMap
+	const int number_of_erosions = (robot_radius_ / map_resolution_);
+	const cv::Mat& eroded_map = erodedMap(number_of_erosions);
+	cv::Mat downsampled_map;
+	if (downsampling_factor != 1.)
+		cv::resize(eroded_map, downsampled_map, cv::Size(0, 0), downsampling_factor, downsampling_factor, cv::INTER_NEAREST);
+	else
+		downsampled_map = eroded_map;
+	return downsampled_maps_[downsampling_factor] = downsampled_map;
+}
+
+const cv::Mat& MapContext::getDistanceMap() const
+{
+	boost::mutex::scoped_lock lock(mutex_);
+	if (distance_map_.empty() == true)
+		cv::distanceTransform(erodedMap(1), distance_map_, CV_DIST_L2, 5);
+	return distance_map_;
+}
+
+boost::uint64_t MapContext::getMapHash() const
+{
+	boost::mutex::scoped_lock lock(mutex_);
+	if (map_hash_computed_ == false)
+	{
+		map_hash_ = DistanceMatrixCache::computeMapHash(map_);
+		map_hash_computed_ = true;
+	}
+	return map_hash_;
+}
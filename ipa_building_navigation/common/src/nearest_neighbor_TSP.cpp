@@ -1,4 +1,5 @@
 #include <ipa_building_navigation/nearest_neighbor_TSP.h>
+#include <ipa_building_navigation/instrumentation.h>
 
 //Default Constructor
 NearestNeighborTSPSolver::NearestNeighborTSPSolver()
@@ -6,6 +7,12 @@ NearestNeighborTSPSolver::NearestNeighborTSPSolver()
 
 }
 
+void NearestNeighborTSPSolver::setDistanceMatrixSettings(const DistanceMatrixSettings& settings)
+{
+	distance_matrix_settings_ = settings;
+	pathplanner_.setSearchMode(settings.astar_search_mode);
+}
+
 //This function calculates the order of the TSP, using the nearest neighbor method. It uses a pathlength Matrix, which
 //should be calculated once. This Matrix should save the pathlengths with this logic:
 //		1. The rows show from which Node the length is calculated.
@@ -13,6 +20,7 @@ NearestNeighborTSPSolver::NearestNeighborTSPSolver()
 //		3. From the node to itself the distance is 0.
 std::vector<int> NearestNeighborTSPSolver::solveNearestTSP(const cv::Mat& path_length_matrix, const int start_node)
 {
+	ScopedSpan span("tsp_nearest_neighbor");
 	std::vector<int> calculated_order; //solution order
 
 	if(path_length_matrix.rows > 1) //check if clique has more than one member or else this algorithm produces a order of size=3
@@ -55,6 +63,30 @@ std::vector<int> NearestNeighborTSPSolver::solveNearestTSP(const cv::Mat& path_l
 	return calculated_order;
 }
 
+//This function calculates the nearest neighbor order on a sparse distance matrix. The nearest unvisited node is the first unvisited
+//node in the sorted neighbor list of the current node, only if all stored neighbors have been visited the remaining nodes are searched.
+std::vector<int> NearestNeighborTSPSolver::solveNearestTSP(const SparseDistanceMatrix& distance_matrix, const int start_node)
+{
+	ScopedSpan span("tsp_nearest_neighbor");
+	std::vector<int> calculated_order; //solution order
+	const int number_nodes = distance_matrix.getNumberPoints();
+	if (start_node < 0 || start_node >= number_nodes)
+		return calculated_order;
+
+	std::vector<bool> visited(number_nodes, false);
+	int current_node = start_node;
+	calculated_order.push_back(current_node);
+	visited[current_node] = true;
+	while ((int)calculated_order.size() < number_nodes)
+	{
+		current_node = distance_matrix.findNearestUnvisited(current_node, visited);
+		calculated_order.push_back(current_node);
+		visited[current_node] = true;
+	}
+
+	return calculated_order;
+}
+
 // compute TSP and distance matrix without cleaning it
 // this version does not exclude infinite paths from the TSP ordering
 std::vector<int> NearestNeighborTSPSolver::solveNearestTSP(const cv::Mat& original_map, const std::vector<cv::Point>& points,
@@ -65,7 +97,7 @@ std::vector<int> NearestNeighborTSPSolver::solveNearestTSP(const cv::Mat& origin
 	cv::Mat distance_matrix_ref;
 	if (distance_matrix != 0)
 		distance_matrix_ref = *distance_matrix;
-	DistanceMatrix distance_matrix_computation;
+	DistanceMatrix distance_matrix_computation(distance_matrix_settings_);
 	distance_matrix_computation.constructDistanceMatrix(distance_matrix_ref, original_map, points, downsampling_factor, robot_radius, map_resolution, pathplanner_);
 
 	return solveNearestTSP(distance_matrix_ref, start_node);
@@ -78,9 +110,9 @@ std::vector<int> NearestNeighborTSPSolver::solveNearestTSPClean(const cv::Mat& o
 {
 	// compute a cleaned distance matrix
 	cv::Mat distance_matrix_cleaned;
-	std::map<int,int> cleaned_index_to_original_index_mapping;	// maps the indices of the cleaned distance_matrix to the original indices of the original distance_matrix
+	std::vector<int> cleaned_index_to_original_index_mapping;	// maps the indices of the cleaned distance_matrix to the original indices of the original distance_matrix
 	int new_start_node = start_node;
-	DistanceMatrix distance_matrix_computation;
+	DistanceMatrix distance_matrix_computation(distance_matrix_settings_);
 	distance_matrix_computation.computeCleanedDistanceMatrix(original_map, points, downsampling_factor, robot_radius, map_resolution, pathplanner_,
 			distance_matrix_cleaned, cleaned_index_to_original_index_mapping, new_start_node);
 
@@ -91,7 +123,7 @@ std::vector<int> NearestNeighborTSPSolver::solveNearestTSPClean(const cv::Mat& o
 
 // compute TSP with pre-computed cleaned distance matrix (does not contain any infinity paths)
 std::vector<int> NearestNeighborTSPSolver::solveNearestTSPWithCleanedDistanceMatrix(const cv::Mat& distance_matrix,
-		const std::map<int,int>& cleaned_index_to_original_index_mapping, const int start_node)
+		const std::vector<int>& cleaned_index_to_original_index_mapping, const int start_node)
 {
 	// solve TSP and re-index points to original indices
 	std::vector<int> optimal_order = solveNearestTSP(distance_matrix, start_node);
@@ -44,9 +44,9 @@ void NodeAstar::nextLevel(const int& i) // i: direction
 //Uncomment the method to calculate the distance between this node and the goal you want to use. Eclidean is more precisly
 //but could take longer to get long paths.
 //
-const int& NodeAstar::estimate(const int& xDest, const int& yDest) const
+int NodeAstar::estimate(const int& xDest, const int& yDest) const
 {
-	static int xd, yd, d;
+	int xd, yd, d;
 	xd = xDest - xPos_;
 	yd = yDest - yPos_;
 
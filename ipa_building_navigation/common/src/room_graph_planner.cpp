@@ -0,0 +1,374 @@
+#include <ipa_building_navigation/room_graph_planner.h>
+#include <ipa_building_navigation/distance_matrix_cache.h>
+#include <ipa_building_navigation/timer.h>
+
+#include <map>
+#include <queue>
+#include <functional>
+#include <cmath>
+
+// maximum number of boundary cells that are represented by one door, wider openings are split into several doors
+static const size_t max_door_width = 4;
+
+RoomGraphPlanner::RoomGraphPlanner()
+: number_regions_(0), downsampling_factor_(0.), robot_radius_(0.), map_resolution_(0.), map_key_(0), graph_key_(0)
+{
+}
+
+void RoomGraphPlanner::buildGraph(const cv::Mat& map, const cv::Mat& segmented_map, const double downsampling_factor, const double robot_radius,
+		const double map_resolution, const MapContext* map_context)
+{
+	std::cout << "RoomGraphPlanner::buildGraph: Building room graph..." << std::endl;
+	Timer tim;
+
+	downsampling_factor_ = downsampling_factor;
+	robot_radius_ = robot_radius;
+	map_resolution_ = map_resolution;
+	const std::vector<cv::Point> no_points;
+	map_key_ = ((map_context != NULL && map_context->isValidFor(map) == true) ? map_context->getMapHash() : DistanceMatrixCache::computeMapHash(map));
+	graph_key_ = map_key_ ^ (DistanceMatrixCache::computeKey(segmented_map, no_points, downsampling_factor, robot_radius, map_resolution, 0) * 1099511628211ULL);
+
+	// same eroded and downsampled map as used by the A* planner
+	AStarPlanner path_planner;
+	path_planner.downsampleMap(map, downsampled_map_, downsampling_factor, robot_radius, map_resolution);
+	cv::Mat downsampled_segmented_map;
+	if (downsampling_factor != 1.)
+		cv::resize(segmented_map, downsampled_segmented_map, cv::Size(0, 0), downsampling_factor, downsampling_factor, cv::INTER_NEAREST);
+	else
+		downsampled_segmented_map = segmented_map;
+
+	computeRegions(downsampled_segmented_map);
+	computeDoors();
+	computeIntraRegionEdges();
+
+	std::cout << "RoomGraphPlanner::buildGraph: " << number_regions_ << " regions and " << node_cells_.size() << " door nodes created in "
+			<< tim.getElapsedTimeInMilliSec() << " ms" << std::endl;
+}
+
+bool RoomGraphPlanner::isValidFor(const boost::uint64_t map_hash, const double downsampling_factor, const double robot_radius, const double map_resolution) const
+{
+	// the hash covers the size and content of the map
+	return (map_hash == map_key_ && downsampling_factor == downsampling_factor_ && robot_radius == robot_radius_ && map_resolution == map_resolution_);
+}
+
+void RoomGraphPlanner::computeRegions(const cv::Mat& downsampled_segmented_map)
+{
+	region_map_ = cv::Mat(downsampled_map_.rows, downsampled_map_.cols, CV_32SC1, cv::Scalar(-1));
+	number_regions_ = 0;
+	std::vector<cv::Point> stack;
+	for (int v=0; v<downsampled_map_.rows; ++v)
+	{
+		for (int u=0; u<downsampled_map_.cols; ++u)
+		{
+			if (downsampled_map_.at<unsigned char>(v,u) != 255 || region_map_.at<int>(v,u) != -1)
+				continue;
+
+			// flood fill all accessible cells with the same label (8-neighborhood, like the planners)
+			const int label = downsampled_segmented_map.at<int>(v,u);
+			const int region = number_regions_++;
+			region_map_.at<int>(v,u) = region;
+			stack.push_back(cv::Point(u,v));
+			while (stack.empty() == false)
+			{
+				const cv::Point cell = stack.back();
+				stack.pop_back();
+				for (int dv=-1; dv<=1; ++dv)
+				{
+					for (int du=-1; du<=1; ++du)
+					{
+						const int nu = cell.x+du;
+						const int nv = cell.y+dv;
+						if (nu<0 || nu>=downsampled_map_.cols || nv<0 || nv>=downsampled_map_.rows)
+							continue;
+						if (downsampled_map_.at<unsigned char>(nv,nu) == 255 && region_map_.at<int>(nv,nu) == -1 && downsampled_segmented_map.at<int>(nv,nu) == label)
+						{
+							region_map_.at<int>(nv,nu) = region;
+							stack.push_back(cv::Point(nu,nv));
+						}
+					}
+				}
+			}
+		}
+	}
+}
+
+void RoomGraphPlanner::computeDoors()
+{
+	node_cells_.clear();
+	node_regions_.clear();
+	adjacency_.clear();
+	region_nodes_.assign(number_regions_, std::vector<int>());
+
+	// collect all pairs of neighboring cells of different regions, grouped by the pair of regions
+	typedef std::pair<cv::Point, cv::Point> CellPair;	// (cell of the lower region index, cell of the higher region index)
+	std::map<std::pair<int,int>, std::vector<CellPair> > boundaries;
+	const int du[4] = {1, 0, 1, -1};
+	const int dv[4] = {0, 1, 1, 1};
+	for (int v=0; v<region_map_.rows; ++v)
+	{
+		for (int u=0; u<region_map_.cols; ++u)
+		{
+			const int region = region_map_.at<int>(v,u);
+			if (region < 0)
+				continue;
+			for (int k=0; k<4; ++k)
+			{
+				const int nu = u+du[k];
+				const int nv = v+dv[k];
+				if (nu<0 || nu>=region_map_.cols || nv>=region_map_.rows)
+					continue;
+				const int neighbor_region = region_map_.at<int>(nv,nu);
+				if (neighbor_region < 0 || neighbor_region == region)
+					continue;
+				if (region < neighbor_region)
+					boundaries[std::pair<int,int>(region, neighbor_region)].push_back(CellPair(cv::Point(u,v), cv::Point(nu,nv)));
+				else
+					boundaries[std::pair<int,int>(neighbor_region, region)].push_back(CellPair(cv::Point(nu,nv), cv::Point(u,v)));
+			}
+		}
+	}
+
+	// split each boundary into connected openings and create one door (two nodes) per opening of at most max_door_width pairs
+	const double diagonal_step = std::sqrt(2.);
+	for (std::map<std::pair<int,int>, std::vector<CellPair> >::iterator boundary=boundaries.begin(); boundary!=boundaries.end(); ++boundary)
+	{
+		std::vector<CellPair>& pairs = boundary->second;
+		std::vector<bool> assigned(pairs.size(), false);
+		for (size_t seed=0; seed<pairs.size(); ++seed)
+		{
+			if (assigned[seed] == true)
+				continue;
+
+			// collect the opening in breadth-first order, so that consecutive pairs are spatially close
+			std::vector<size_t> opening(1, seed);
+			assigned[seed] = true;
+			for (size_t k=0; k<opening.size(); ++k)
+			{
+				const cv::Point& cell = pairs[opening[k]].first;
+				for (size_t l=0; l<pairs.size(); ++l)
+				{
+					if (assigned[l] == false && std::abs(pairs[l].first.x-cell.x) <= 1 && std::abs(pairs[l].first.y-cell.y) <= 1)
+					{
+						assigned[l] = true;
+						opening.push_back(l);
+					}
+				}
+			}
+
+			for (size_t start=0; start<opening.size(); start+=max_door_width)
+			{
+				// use the pair closest to the center of this part of the opening as door
+				const size_t end = std::min(opening.size(), start+max_door_width);
+				cv::Point2d center(0., 0.);
+				for (size_t k=start; k<end; ++k)
+				{
+					center.x += pairs[opening[k]].first.x;
+					center.y += pairs[opening[k]].first.y;
+				}
+				center.x /= (double)(end-start);
+				center.y /= (double)(end-start);
+				size_t door = opening[start];
+				double min_distance = 1e100;
+				for (size_t k=start; k<end; ++k)
+				{
+					const double distance = (pairs[opening[k]].first.x-center.x)*(pairs[opening[k]].first.x-center.x) + (pairs[opening[k]].first.y-center.y)*(pairs[opening[k]].first.y-center.y);
+					if (distance < min_distance)
+					{
+						min_distance = distance;
+						door = opening[k];
+					}
+				}
+
+				const int node_a = (int)node_cells_.size();
+				const int node_b = node_a+1;
+				node_cells_.push_back(pairs[door].first);
+				node_regions_.push_back(boundary->first.first);
+				node_cells_.push_back(pairs[door].second);
+				node_regions_.push_back(boundary->first.second);
+				region_nodes_[boundary->first.first].push_back(node_a);
+				region_nodes_[boundary->first.second].push_back(node_b);
+				const double length = (pairs[door].first.x==pairs[door].second.x || pairs[door].first.y==pairs[door].second.y ? 1. : diagonal_step);
+				adjacency_.push_back(std::vector<std::pair<int, double> >(1, std::pair<int, double>(node_b, length)));
+				adjacency_.push_back(std::vector<std::pair<int, double> >(1, std::pair<int, double>(node_a, length)));
+			}
+		}
+	}
+}
+
+void RoomGraphPlanner::computeIntraRegionEdges()
+{
+	WavefrontPlanner wavefront_planner;
+	for (int region=0; region<number_regions_; ++region)
+	{
+		const std::vector<int>& nodes = region_nodes_[region];
+		if (nodes.size() < 2)
+			continue;
+		std::vector<cv::Point> node_cells(nodes.size());
+		for (size_t k=0; k<nodes.size(); ++k)
+			node_cells[k] = node_cells_[nodes[k]];
+		for (size_t k=0; k<nodes.size(); ++k)
+		{
+			wavefront_planner.computeWavefront(downsampled_map_, node_cells[k], &node_cells, &region_map_, region);
+			for (size_t l=0; l<nodes.size(); ++l)
+			{
+				if (l == k || wavefront_planner.isReachable(node_cells[l]) == false)
+					continue;
+				adjacency_[nodes[k]].push_back(std::pair<int, double>(nodes[l], wavefront_planner.getPathLength(node_cells[l])));
+			}
+		}
+	}
+}
+
+cv::Point RoomGraphPlanner::toCell(const cv::Point& point) const
+{
+	// same conversion as in AStarPlanner::planPath
+	return downsampling_factor_*point;
+}
+
+void RoomGraphPlanner::searchRegion(WavefrontPlanner& wavefront_planner, const cv::Point& cell, const int region, const std::vector<cv::Point>& target_cells,
+		std::vector<double>& node_lengths, std::vector<double>& target_lengths) const
+{
+	const std::vector<int>& nodes = region_nodes_[region];
+	std::vector<cv::Point> search_targets(target_cells);
+	for (size_t k=0; k<nodes.size(); ++k)
+		search_targets.push_back(node_cells_[nodes[k]]);
+	wavefront_planner.computeWavefront(downsampled_map_, cell, &search_targets, &region_map_, region);
+
+	node_lengths.assign(node_cells_.size(), 1e100);
+	for (size_t k=0; k<nodes.size(); ++k)
+		node_lengths[nodes[k]] = wavefront_planner.getPathLength(node_cells_[nodes[k]]);
+	target_lengths.resize(target_cells.size());
+	for (size_t t=0; t<target_cells.size(); ++t)
+		target_lengths[t] = wavefront_planner.getPathLength(target_cells[t]);
+}
+
+void RoomGraphPlanner::searchGraph(std::vector<double>& node_lengths) const
+{
+	typedef std::pair<double, int> QueueEntry;
+	std::priority_queue<QueueEntry, std::vector<QueueEntry>, std::greater<QueueEntry> > queue;
+	for (size_t n=0; n<node_lengths.size(); ++n)
+		if (node_lengths[n] < 1e90)
+			queue.push(QueueEntry(node_lengths[n], (int)n));
+	while (queue.empty() == false)
+	{
+		const QueueEntry current = queue.top();
+		queue.pop();
+		if (current.first > node_lengths[current.second])
+			continue;
+		const std::vector<std::pair<int, double> >& edges = adjacency_[current.second];
+		for (size_t e=0; e<edges.size(); ++e)
+		{
+			const double length = current.first + edges[e].second;
+			if (length < node_lengths[edges[e].first])
+			{
+				node_lengths[edges[e].first] = length;
+				queue.push(QueueEntry(length, edges[e].first));
+			}
+		}
+	}
+}
+
+void RoomGraphPlanner::computeDistanceMatrix(const std::vector<cv::Point>& points, cv::Mat& distance_matrix) const
+{
+	const int number_points = (int)points.size();
+	distance_matrix.create(number_points, number_points, CV_64F);
+	const double step_length = 1./downsampling_factor_;
+
+	// cells and regions of all points
+	std::vector<cv::Point> cells(number_points);
+	std::vector<int> regions(number_points, -1);
+	for (int i=0; i<number_points; ++i)
+	{
+		cells[i] = toCell(points[i]);
+		if (cells[i].x>=0 && cells[i].x<region_map_.cols && cells[i].y>=0 && cells[i].y<region_map_.rows)
+			regions[i] = region_map_.at<int>(cells[i]);
+	}
+	std::vector<std::vector<int> > region_points(number_regions_);
+	for (int i=0; i<number_points; ++i)
+		if (regions[i] >= 0)
+			region_points[regions[i]].push_back(i);
+
+	// 1. local searches: lengths from each point to the doors of its region and to the other points in the same region
+	// like the planners, the search from point i to j>i may start on an inaccessible cell, which is then expanded into the regions
+	// of its accessible neighbors, whereas point j must lie on an accessible cell
+	WavefrontPlanner wavefront_planner;
+	const double diagonal_step = std::sqrt(2.);
+	std::vector<std::vector<double> > door_lengths(number_points, std::vector<double>(node_cells_.size(), 1e100));	// lengths from point i to all door nodes
+	std::map<std::pair<int,int>, double> local_lengths;		// direct lengths between points of the same region
+	std::vector<double> node_lengths, target_lengths;
+	for (int i=0; i<number_points; ++i)
+	{
+		if (cells[i].x<0 || cells[i].x>=region_map_.cols || cells[i].y<0 || cells[i].y>=region_map_.rows)
+			continue;
+		for (int dv=-1; dv<=1; ++dv)
+		{
+			for (int du=-1; du<=1; ++du)
+			{
+				// the point's own cell if accessible, otherwise each of its accessible neighbors
+				if ((regions[i]>=0) != (du==0 && dv==0))
+					continue;
+				const cv::Point cell(cells[i].x+du, cells[i].y+dv);
+				if (cell.x<0 || cell.x>=region_map_.cols || cell.y<0 || cell.y>=region_map_.rows || region_map_.at<int>(cell)<0)
+					continue;
+				const double offset = (du==0 && dv==0 ? 0. : (du==0 || dv==0 ? 1. : diagonal_step));
+				const int region = region_map_.at<int>(cell);
+				const std::vector<int>& same_region_points = region_points[region];
+				std::vector<cv::Point> target_cells(same_region_points.size());
+				for (size_t k=0; k<same_region_points.size(); ++k)
+					target_cells[k] = cells[same_region_points[k]];
+				searchRegion(wavefront_planner, cell, region, target_cells, node_lengths, target_lengths);
+				const std::vector<int>& nodes = region_nodes_[region];
+				for (size_t k=0; k<nodes.size(); ++k)
+					door_lengths[i][nodes[k]] = std::min(door_lengths[i][nodes[k]], offset + node_lengths[nodes[k]]);
+				for (size_t k=0; k<same_region_points.size(); ++k)
+				{
+					const std::pair<int,int> pair(i, same_region_points[k]);
+					const std::map<std::pair<int,int>, double>::iterator entry = local_lengths.find(pair);
+					if (entry == local_lengths.end())
+						local_lengths[pair] = offset + target_lengths[k];
+					else
+						entry->second = std::min(entry->second, offset + target_lengths[k]);
+				}
+			}
+		}
+	}
+
+	// 2. one search on the abstract graph per point yields the lengths to the doors of all other points
+	for (int i=0; i<number_points; ++i)
+	{
+		distance_matrix.at<double>(i,i) = 0.;
+		node_lengths = door_lengths[i];
+		searchGraph(node_lengths);
+		for (int j=i+1; j<number_points; ++j)
+		{
+			double length = 1e100;
+			if (cells[i] == cells[j])
+				length = 0.;
+			else if (regions[j] >= 0)
+			{
+				const std::map<std::pair<int,int>, double>::const_iterator entry = local_lengths.find(std::pair<int,int>(i,j));
+				if (entry != local_lengths.end())
+					length = entry->second;
+				const std::vector<int>& nodes = region_nodes_[regions[j]];
+				for (size_t k=0; k<nodes.size(); ++k)
+					length = std::min(length, node_lengths[nodes[k]] + door_lengths[j][nodes[k]]);
+				if (length < 1e90)
+					length *= step_length;
+				else
+					length = 1e100;
+			}
+			distance_matrix.at<double>(i,j) = length;
+			distance_matrix.at<double>(j,i) = length;
+		}
+	}
+}
+
+double RoomGraphPlanner::computeDistance(const cv::Point& start_point, const cv::Point& end_point) const
+{
+	std::vector<cv::Point> points(2);
+	points[0] = start_point;
+	points[1] = end_point;
+	cv::Mat distance_matrix;
+	computeDistanceMatrix(points, distance_matrix);
+	return distance_matrix.at<double>(0,1);
+}
@@ -45,60 +45,54 @@ SetCoverSolver::SetCoverSolver()
 //	distance_matrix = pathlengths.clone();
 //}
 
-//This function takes a vector of found nodes and merges them together, if they have at least one node in common.
+//This function takes a vector of found nodes and merges them together, if they have at least one node in common. Groups are
+//merged transitively with a union-find structure over the groups, so that no two merged groups share a node.
 std::vector<std::vector<int> > SetCoverSolver::mergeGroups(const std::vector<std::vector<int> >& found_groups)
 {
-	std::vector < std::vector<int> > merged_groups; //The merged groups.
-
-	std::vector<int> done_groups; //Vector to remember which groups has already been looked at
-
-	for (int current_group = 0; current_group < found_groups.size(); current_group++)
+	//union-find over the groups, each node links its groups to the first group it has been found in
+	std::vector<int> parent(found_groups.size());
+	for (size_t group = 0; group < found_groups.size(); group++)
+		parent[group] = (int)group;
+	std::map<int, int> first_group_of_node;
+	for (int group = 0; group < found_groups.size(); group++)
 	{
-		if (!contains(done_groups, current_group)) //If the group is in the done-vector don't look at it, because it has already been looked at.
+		for (size_t node = 0; node < found_groups[group].size(); node++)
 		{
-			done_groups.push_back(current_group); //add the current group to the done groups
-
-			std::vector<int> current_group_saver(found_groups[current_group]); //vector to save the current group
-
-			std::vector<int> merging_candidates; //vector to save the groups which should be merged with the current group
-
-			//check if the current group has at least one node in common with the other groups
-			for (int next_group = 0; next_group < found_groups.size(); next_group++)
-			{
-				bool merge = false; //variable to check if the room should be added to the current group
+			std::pair<std::map<int, int>::iterator, bool> inserted = first_group_of_node.insert(std::pair<int, int>(found_groups[group][node], group));
+			if (inserted.second == true)
+				continue;
 
-				//if it is the same group or has already been looked at it doesn't need to be checked
-				if (next_group != current_group && !contains(done_groups, next_group))
-				{
-					for (int node = 0; node < found_groups[next_group].size(); node++)
-					{
-						if (contains(found_groups[current_group], found_groups[next_group][node]))
-						{
-							merge = true;
-						}
-					}
-				}
-				if (merge) //If the group has at least one neighbor save it for merging
-				{
-					merging_candidates.push_back(next_group);
-				}
-			}
+			//unite the two groups, the root is always the group with the smaller index
+			int root_a = group, root_b = inserted.first->second;
+			while (parent[root_a] != root_a)
+				root_a = parent[root_a] = parent[parent[root_a]];
+			while (parent[root_b] != root_b)
+				root_b = parent[root_b] = parent[parent[root_b]];
+			if (root_a < root_b)
+				parent[root_b] = root_a;
+			else
+				parent[root_a] = root_b;
+		}
+	}
 
-			//Add the merging-candidates nodes to the current group and add the candidates to the done groups
-			for (int merge_candidate = 0; merge_candidate < merging_candidates.size(); merge_candidate++)
-			{
-				done_groups.push_back(merging_candidates[merge_candidate]);
-				for (int node = 0; node < found_groups[merging_candidates[merge_candidate]].size(); node++)
-				{
-					if (!contains(current_group_saver, found_groups[merging_candidates[merge_candidate]][node]))
-					{
-						current_group_saver.push_back(found_groups[merging_candidates[merge_candidate]][node]);
-					}
-				}
-			}
-			//add the merged group to the vector
-			merged_groups.push_back(current_group_saver);
+	//collect the nodes of each merged group in the order of the groups
+	std::vector < std::vector<int> > merged_groups; //The merged groups.
+	std::vector<int> merged_group_index(found_groups.size(), -1);
+	std::set<int> added_nodes;
+	for (int group = 0; group < found_groups.size(); group++)
+	{
+		int root = group;
+		while (parent[root] != root)
+			root = parent[root];
+		if (merged_group_index[root] == -1)
+		{
+			merged_group_index[root] = (int)merged_groups.size();
+			merged_groups.push_back(std::vector<int>());
 		}
+		std::vector<int>& merged_group = merged_groups[merged_group_index[root]];
+		for (size_t node = 0; node < found_groups[group].size(); node++)
+			if (added_nodes.insert(found_groups[group][node]).second == true)
+				merged_group.push_back(found_groups[group][node]);
 	}
 	std::cout << "Finished merging." << std::endl;
 	return merged_groups;
@@ -110,86 +104,99 @@ std::vector<std::vector<int> > SetCoverSolver::mergeGroups(const std::vector<std
 //are the same as the ones from the clique-solver and also the distance-matrix. The variable max_number_of_clique_members
 //implies how many members a clique is allowed to have.
 
+//The greedy search keeps the number of open nodes of each clique up to date with an index from nodes to their cliques and
+//finds the best clique with a lazy max-heap: heap entries whose count is outdated are skipped when they reach the top.
+//Cliques with more open nodes than max_number_of_clique_members only enter the heap once enough of their nodes are covered.
+
 //the cliques are given
 std::vector<std::vector<int> > SetCoverSolver::solveSetCover(std::vector<std::vector<int> >& given_cliques,
 		const int number_of_nodes, const int max_number_of_clique_members, const cv::Mat& distance_matrix)
 {
 	std::vector < std::vector<int> > minimal_set;
 
-	std::vector<std::vector<int> > cliques_for_covering;
+	//Put the nodes in a open-nodes set. The nodes are named after their position in the room-centers-vector and so every
+	//node from 0 to number_of_nodes-1 is in the Graph.
+	boost::dynamic_bitset<> open_nodes(number_of_nodes);
+	open_nodes.set();
 
-	for(size_t clique = 0; clique < given_cliques.size(); clique++)
+	//count the open nodes of each clique and save the cliques each node belongs to (nodes are only counted once per clique)
+	std::vector<int> open_node_counts(given_cliques.size(), 0);
+	std::vector<std::vector<int> > cliques_of_node(number_of_nodes);
+	for (int clique = 0; clique < given_cliques.size(); clique++)
 	{
-		std::vector<int> temporary_clique;
-		for(size_t node = 0; node < given_cliques[clique].size(); node++)
+		for (size_t node = 0; node < given_cliques[clique].size(); node++)
 		{
-			temporary_clique.push_back(given_cliques[clique][node]);
+			const int current_node = given_cliques[clique][node];
+			if (current_node < 0 || current_node >= number_of_nodes)
+				continue;
+			if (cliques_of_node[current_node].empty() == false && cliques_of_node[current_node].back() == clique)
+				continue;
+			cliques_of_node[current_node].push_back(clique);
+			open_node_counts[clique]++;
 		}
-		cliques_for_covering.push_back(temporary_clique);
 	}
 
-	//Put the nodes in a open-nodes vector. The nodes are named after their position in the room-centers-vector and so every
-	//node from 0 to number_of_nodes-1 is in the Graph.
-	std::vector<int> open_nodes;
-	for (int new_node = 0; new_node < number_of_nodes; new_node++)
-	{
-		open_nodes.push_back(new_node);
-	}
+	//heap of (number of open nodes, -clique index), so that equally good cliques are taken in their given order
+	std::priority_queue<std::pair<int, int> > best_cliques;
+	for (int clique = 0; clique < given_cliques.size(); clique++)
+		if (open_node_counts[clique] > 0 && open_node_counts[clique] <= max_number_of_clique_members)
+			best_cliques.push(std::pair<int, int>(open_node_counts[clique], -clique));
 
 	std::cout << "Starting greedy search for set-cover-problem." << std::endl;
 
 	//Search for the clique with the most unvisited nodes and choose this one before the others. Then remove the nodes of
-	//this clique from the unvisited-vector. This is done until no more nodes can be visited.
-
-	do
+	//this clique from the unvisited-set. This is done until no more nodes can be visited.
+	int number_of_open_nodes = number_of_nodes;
+	while (number_of_open_nodes > 0)
 	{
-		int covered_open_nodes;
-		int best_covered_counter = 0;
 		int best_clique = -1;
-		for (int clique = 0; clique < cliques_for_covering.size(); clique++)
+		while (best_cliques.empty() == false && best_clique == -1)
 		{
-			// skip too big cliques
-			if(cliques_for_covering[clique].size() > max_number_of_clique_members)
-				continue;
+			const std::pair<int, int> entry = best_cliques.top();
+			best_cliques.pop();
+			if (entry.first == open_node_counts[-entry.second])
+				best_clique = -entry.second;
+		}
 
-			covered_open_nodes = 0;
-			for (int node = 0; node < cliques_for_covering[clique].size(); node++)
+		// check if a allowed clique could be found, if not split the biggest clique until it consists of cliques that are of the
+		// allowed size
+		bool split_clique = false;
+		if(best_clique == -1)
+		{
+			int best_covered_counter = 0;
+			for (int clique = 0; clique < given_cliques.size(); clique++)
 			{
-				if (contains(open_nodes, cliques_for_covering[clique][node]))
+				if (open_node_counts[clique] > best_covered_counter)
 				{
-					covered_open_nodes++;
+					best_covered_counter = open_node_counts[clique];
+					best_clique = clique;
 				}
 			}
-			if (covered_open_nodes > best_covered_counter)
+			if (best_clique == -1)
 			{
-				best_covered_counter = covered_open_nodes;
-				best_clique = clique;
+				std::cout << "SetCoverSolver::solveSetCover: Warning: " << number_of_open_nodes << " nodes are not covered by any clique." << std::endl;
+				break;
 			}
+			split_clique = true;
 		}
 
-		// check if a allowed clique could be found, if not split the biggest clique until it consists of cliques that are of the
-		// allowed size
-		if(best_clique == -1)
+		//take the open nodes of the chosen clique in their given order and remove them from the open nodes
+		std::vector<int> open_clique_nodes;
+		for (size_t node = 0; node < given_cliques[best_clique].size(); node++)
 		{
-			for (int clique = 0; clique < cliques_for_covering.size(); clique++)
+			const int current_node = given_cliques[best_clique][node];
+			if (current_node >= 0 && current_node < number_of_nodes && open_nodes.test(current_node) == true)
 			{
-				covered_open_nodes = 0;
-				for (int node = 0; node < cliques_for_covering[clique].size(); node++)
-				{
-					if (contains(open_nodes, cliques_for_covering[clique][node]))
-					{
-						covered_open_nodes++;
-					}
-				}
-				if (covered_open_nodes > best_covered_counter)
-				{
-					best_covered_counter = covered_open_nodes;
-					best_clique = clique;
-				}
+				open_clique_nodes.push_back(current_node);
+				open_nodes.reset(current_node);
 			}
+		}
+		number_of_open_nodes -= (int)open_clique_nodes.size();
 
+		if (split_clique == true)
+		{
 			// save big clique
-			std::vector<int> big_clique = cliques_for_covering[best_clique];
+			std::vector<int> big_clique = open_clique_nodes;
 
 			// iteratively remove nodes far away from the remaining nodes to create small cliques
 			bool removed_node = false;
@@ -245,24 +252,23 @@ std::vector<std::vector<int> > SetCoverSolver::solveSetCover(std::vector<std::ve
 		}
 		else
 		{
-			minimal_set.push_back(cliques_for_covering[best_clique]);
+			minimal_set.push_back(open_clique_nodes);
 		}
-		//remove nodes of best clique from all cliques (this is okay because if you remove a node from a clique it stays a clique, it only isn't a maximal clique anymore)
-		for(size_t clique = 0; clique < cliques_for_covering.size(); clique++)
+
+		//update the open node counts of all cliques containing the covered nodes (this is okay because if you remove a node from a
+		//clique it stays a clique, it only isn't a maximal clique anymore)
+		for (size_t node = 0; node < open_clique_nodes.size(); node++)
 		{
-			for(int node = 0; node < cliques_for_covering[best_clique].size(); node++)
+			const int current_node = open_clique_nodes[node];
+			for (size_t clique = 0; clique < cliques_of_node[current_node].size(); clique++)
 			{
-				if(clique != best_clique)
-					cliques_for_covering[clique].erase(std::remove(cliques_for_covering[clique].begin(), cliques_for_covering[clique].end(), cliques_for_covering[best_clique][node]), cliques_for_covering[clique].end());
+				const int current_clique = cliques_of_node[current_node][clique];
+				open_node_counts[current_clique]--;
+				if (open_node_counts[current_clique] > 0 && open_node_counts[current_clique] <= max_number_of_clique_members)
+					best_cliques.push(std::pair<int, int>(open_node_counts[current_clique], -current_clique));
 			}
 		}
-		for (int node = 0; node < cliques_for_covering[best_clique].size(); node++)
-		{
-			open_nodes.erase(std::remove(open_nodes.begin(), open_nodes.end(), cliques_for_covering[best_clique][node]), open_nodes.end());
-		}
-//		cliques_for_covering = new_set;
-//		std::cout << open_nodes.size() << std::endl;
-	} while (open_nodes.size() > 0);
+	}
 
 	std::cout << "Finished greedy search." << std::endl;
 
@@ -0,0 +1,253 @@
+#include <ipa_building_navigation/sparse_distance_matrix.h>
+
+#include <algorithm>
+#include <limits>
+#include <boost/thread.hpp>
+#include <boost/bind.hpp>
+
+#include <ipa_building_navigation/A_star_pathplanner.h>
+#include <ipa_building_navigation/wavefront_planner.h>
+#include <ipa_building_navigation/line_of_sight.h>
+#include <ipa_building_navigation/timer.h>
+#include <ipa_building_navigation/instrumentation.h>
+
+// unreachable pairs have a path length of 1e100, which exceeds the float range and is stored as the largest float instead
+static const float unreachable_distance = std::numeric_limits<float>::max();
+
+// size of the cache of getDistance, relative to the number of points
+static const int cached_pairs_per_point = 8;
+
+static inline float toStoredDistance(const double distance)
+{
+	return (distance >= (double)unreachable_distance ? unreachable_distance : (float)distance);
+}
+
+static inline double fromStoredDistance(const float distance)
+{
+	return (distance >= unreachable_distance ? 1e100 : (double)distance);
+}
+
+SparseDistanceMatrix::SparseDistanceMatrix()
+: number_points_(0), row_offsets_(1, 0), downsampling_factor_(1.), map_resolution_(1.),
+  number_of_threads_(1), search_mode_(ASTAR_STANDARD), abort_computation_(false)
+{
+}
+
+void SparseDistanceMatrix::abortComputation()
+{
+	abort_computation_ = true;
+}
+
+void SparseDistanceMatrix::setNumberOfThreads(const int number_of_threads)
+{
+	number_of_threads_ = (number_of_threads < 1 ? std::max(1, (int)boost::thread::hardware_concurrency()) : number_of_threads);
+}
+
+void SparseDistanceMatrix::setSearchMode(const int search_mode)
+{
+	search_mode_ = search_mode;
+}
+
+void SparseDistanceMatrix::constructRows(const int first_point, const int number_of_threads, const int number_neighbors, const double max_radius,
+		std::vector<std::vector<std::pair<float, int> > >& rows)
+{
+	WavefrontPlanner wavefront_planner;
+	AStarPlanner path_planner;
+	path_planner.setSearchMode(search_mode_);
+	const double max_squared_radius = max_radius*max_radius;
+	const double step_length = 1./downsampling_factor_;
+	std::vector<std::pair<double, int> > candidates;
+	for (int i=first_point; i<number_points_; i+=number_of_threads)
+	{
+		if (abort_computation_ == true)
+			return;
+
+		// Euclidean nearest points, the squared distances are only compared
+		candidates.clear();
+		for (int j=0; j<number_points_; ++j)
+		{
+			if (j == i)
+				continue;
+			const double dx = points_[j].x - points_[i].x;
+			const double dy = points_[j].y - points_[i].y;
+			const double squared_distance = dx*dx + dy*dy;
+			if (max_radius > 0. && squared_distance > max_squared_radius)
+				continue;
+			candidates.push_back(std::pair<double, int>(squared_distance, j));
+		}
+		const int number_candidates = std::min(number_neighbors, (int)candidates.size());
+		std::partial_sort(candidates.begin(), candidates.begin()+number_candidates, candidates.end());
+		candidates.resize(number_candidates);
+
+		// direct connections get their straight line length, the other candidates are planned with one wavefront
+		std::vector<cv::Point> goals(number_candidates);
+		for (int c=0; c<number_candidates; ++c)
+			goals[c] = points_[candidates[c].second];
+		std::vector<bool> direct_connections;
+		LineOfSight::checkVisibility(original_map_, points_[i], goals, direct_connections, 250);
+
+		std::vector<std::pair<float, int> >& row = rows[i];
+		row.resize(number_candidates);
+		std::vector<int> wavefront_targets;		// indices of the candidates that need to be planned
+		for (int c=0; c<number_candidates; ++c)
+		{
+			row[c].second = candidates[c].second;
+			if (direct_connections[c] == true)
+				row[c].first = (float)std::sqrt(candidates[c].first);
+			else
+				wavefront_targets.push_back(c);
+		}
+		if (wavefront_targets.size() > 0)
+		{
+			const cv::Point start_cell = downsampling_factor_*points_[i];
+			std::vector<cv::Point> target_cells(wavefront_targets.size());
+			for (size_t t=0; t<wavefront_targets.size(); ++t)
+				target_cells[t] = downsampling_factor_*goals[wavefront_targets[t]];
+			wavefront_planner.computeWavefront(downsampled_map_, start_cell, &target_cells);
+			for (size_t t=0; t<wavefront_targets.size(); ++t)
+			{
+				double length = 0.;
+				if (target_cells[t] == start_cell)
+					length = 0.;	// both points fall into the same cell, like in AStarPlanner::planPath
+				else if (wavefront_planner.isReachable(target_cells[t]) == true)
+					length = step_length * wavefront_planner.getPathLength(target_cells[t]);
+				else
+					length = path_planner.planPath(original_map_, points_[i], goals[wavefront_targets[t]], 1., 0., map_resolution_);
+				row[wavefront_targets[t]].first = toStoredDistance(length);
+			}
+		}
+		std::sort(row.begin(), row.end());
+	}
+}
+
+bool SparseDistanceMatrix::construct(const cv::Mat& original_map, const std::vector<cv::Point>& points, const double downsampling_factor,
+		const double robot_radius, const double map_resolution, const int number_neighbors, const double max_radius)
+{
+	ScopedSpan span("sparse_distance_matrix");
+	Timer tim;
+	number_points_ = (int)points.size();
+	points_ = points;
+	original_map_ = original_map;
+	downsampling_factor_ = downsampling_factor;
+	map_resolution_ = map_resolution;
+	{
+		boost::mutex::scoped_lock lock(mutex_);
+		cached_pairs_.assign(std::max(1, cached_pairs_per_point*number_points_), -1);
+		cached_distances_.assign(cached_pairs_.size(), 0.f);
+	}
+	AStarPlanner path_planner;
+	path_planner.downsampleMap(original_map, downsampled_map_, downsampling_factor, robot_radius, map_resolution);
+
+	// every thread computes an interleaved set of rows, the rows of neighboring points have similar costs
+	std::vector<std::vector<std::pair<float, int> > > rows(number_points_);
+	const int number_of_threads = std::min(number_of_threads_, std::max(1, number_points_));
+	if (number_of_threads <= 1)
+		constructRows(0, 1, number_neighbors, max_radius, rows);
+	else
+	{
+		boost::thread_group workers;
+		for (int t=0; t<number_of_threads; ++t)
+			workers.create_thread(boost::bind(&SparseDistanceMatrix::constructRows, this, t, number_of_threads, number_neighbors, max_radius, boost::ref(rows)));
+		workers.join_all();
+	}
+	if (abort_computation_ == true)
+		return false;
+
+	// compress the rows
+	row_offsets_.resize(number_points_+1);
+	row_offsets_[0] = 0;
+	for (int i=0; i<number_points_; ++i)
+		row_offsets_[i+1] = row_offsets_[i] + (int)rows[i].size();
+	neighbor_indices_.resize(row_offsets_[number_points_]);
+	neighbor_distances_.resize(row_offsets_[number_points_]);
+	for (int i=0; i<number_points_; ++i)
+	{
+		for (size_t n=0; n<rows[i].size(); ++n)
+		{
+			neighbor_indices_[row_offsets_[i]+n] = rows[i][n].second;
+			neighbor_distances_[row_offsets_[i]+n] = rows[i][n].first;
+		}
+	}
+
+	std::cout << "SparseDistanceMatrix::construct: " << neighbor_indices_.size() << " path lengths of " << number_points_ << " points ("
+			<< getMemoryUsage()/1024 << " kB) computed in " << tim.getElapsedTimeInMilliSec() << " ms" << std::endl;
+	return true;
+}
+
+bool SparseDistanceMatrix::findStoredDistance(const int i, const int j, double& distance) const
+{
+	for (int n=row_offsets_[i]; n<row_offsets_[i+1]; ++n)
+	{
+		if (neighbor_indices_[n] == j)
+		{
+			distance = fromStoredDistance(neighbor_distances_[n]);
+			return true;
+		}
+	}
+	return false;
+}
+
+double SparseDistanceMatrix::getDistance(const int i, const int j) const
+{
+	if (i == j)
+		return 0.;
+	double distance = 0.;
+	if (findStoredDistance(i, j, distance) == true || findStoredDistance(j, i, distance) == true)
+		return distance;
+
+	const long long key = (long long)std::min(i, j)*number_points_ + std::max(i, j);
+	const size_t slot = (size_t)(key % (long long)cached_pairs_.size());
+	{
+		boost::mutex::scoped_lock lock(mutex_);
+		if (cached_pairs_[slot] == key)
+			return fromStoredDistance(cached_distances_[slot]);
+	}
+
+	// plan the pair like DistanceMatrix, outside of the lock so that concurrent requests for other pairs are not blocked
+	Instrumentation::addCount("raycasts", 1);
+	if (LineOfSight::isFree(original_map_, points_[i], points_[j], 250) == true)
+		distance = cv::norm(points_[i]-points_[j]);
+	else
+	{
+		AStarPlanner path_planner;
+		path_planner.setSearchMode(search_mode_);
+		distance = path_planner.planPath(original_map_, downsampled_map_, points_[i], points_[j], downsampling_factor_, 0., map_resolution_);
+	}
+
+	boost::mutex::scoped_lock lock(mutex_);
+	cached_pairs_[slot] = key;
+	cached_distances_[slot] = toStoredDistance(distance);
+	return distance;
+}
+
+int SparseDistanceMatrix::findNearestUnvisited(const int i, const std::vector<bool>& visited) const
+{
+	for (int n=row_offsets_[i]; n<row_offsets_[i+1]; ++n)
+		if (visited[neighbor_indices_[n]] == false && neighbor_distances_[n] < unreachable_distance)
+			return neighbor_indices_[n];
+
+	// all stored neighbors have been visited: take the closest unvisited point by straight line distance, which is a lower bound
+	// of the path length
+	int nearest_point = -1;
+	double min_squared_distance = std::numeric_limits<double>::max();
+	for (int j=0; j<number_points_; ++j)
+	{
+		if (j == i || visited[j] == true)
+			continue;
+		const double dx = points_[j].x - points_[i].x;
+		const double dy = points_[j].y - points_[i].y;
+		const double squared_distance = dx*dx + dy*dy;
+		if (squared_distance < min_squared_distance)
+		{
+			min_squared_distance = squared_distance;
+			nearest_point = j;
+		}
+	}
+	return nearest_point;
+}
+
+size_t SparseDistanceMatrix::getMemoryUsage() const
+{
+	return row_offsets_.size()*sizeof(int) + neighbor_indices_.size()*sizeof(int) + neighbor_distances_.size()*sizeof(float)
+			+ cached_pairs_.size()*sizeof(long long) + cached_distances_.size()*sizeof(float);
+}
@@ -1,38 +1,78 @@
 #include <ipa_building_navigation/trolley_position_finder.h>
 
+#include <boost/thread.hpp>
+#include <boost/bind.hpp>
+
 //Defaul Constructor
 TrolleyPositionFinder::TrolleyPositionFinder()
+: number_of_threads_(1)
+{
+
+}
+
+void TrolleyPositionFinder::setNumberOfThreads(const int number_of_threads)
+{
+	number_of_threads_ = (number_of_threads < 1 ? std::max(1, (int)boost::thread::hardware_concurrency()) : number_of_threads);
+}
+
+void TrolleyPositionFinder::setMapContext(const boost::shared_ptr<const MapContext>& map_context)
 {
+	map_context_ = map_context;
+}
 
+//This function expands one wavefront from the cell of each of its group members and stores the pathlength to every cell of the
+//bounding box in the matrix of that member. The expansion stops as soon as all accessible cells of the bounding box are reached.
+//Different members write to different matrices, so no locking is necessary.
+void TrolleyPositionFinder::computeMemberPathLengths(const cv::Mat& downsampled_map, const std::vector<cv::Point>& member_cells,
+		const std::vector<cv::Point>& box_cells, const cv::Point& box_offset, const int first_member, const int member_step,
+		std::vector<cv::Mat>& pathlengths)
+{
+	WavefrontPlanner wavefront_planner;
+	for (int member = first_member; member < (int)member_cells.size(); member += member_step)
+	{
+		wavefront_planner.computeWavefront(downsampled_map, member_cells[member], &box_cells);
+		for (size_t cell = 0; cell < box_cells.size(); cell++)
+			pathlengths[member].at<double>(box_cells[cell] - box_offset) = wavefront_planner.getPathLength(box_cells[cell]);
+	}
 }
 
 //This function takes one group and calculates the trolley position for it. It does following steps:
 //		I.   Get the bounding box for all Points in the group. Then expand it by a little factor to make sure the best
 //			 position is found, even when it is slightly outside the bounding Box.
-//		II.  Put a grid over the bounding box to get cells in which the trolley-position possibly is.
-//		     Find the Point in these cells that have the largest distance to the closest zero Pixel as possible candidates
-//			 for trolley positions.
-//		III. From these candidates the one is chosen, which gets the smallest pathlength to all group Points. If the group
-//			 has only two members the algorithm chooses the candidate as trolley position that is the middlest between these.
+//		II.  Expand one wavefront from each group member on the downsampled map, which gives the pathlength from this member
+//			 to every cell of the bounding box. These expansions are independent and distributed over several threads.
+//		III. Every Pixel of the bounding box that is far enough away from the boundaries is a candidate. From these candidates
+//			 the one is chosen, which gets the smallest sum of pathlengths to all group Points. If the group has only two members
+//			 the algorithm chooses the candidate as trolley position that is the middlest between these. Among equally good
+//			 candidates the one with the largest distance to the closest zero Pixel is taken.
 cv::Point TrolleyPositionFinder::findOneTrolleyPosition(const std::vector<cv::Point> group_points, const cv::Mat& original_map,
 		const double downsampling_factor, const double robot_radius, const double map_resolution)
 {
-	double largening_of_bounding_box = 5; //Variable to expand the bounding box of the roomcenters a little bit. This is done to make sure the best trolley position is found if it is a little bit outside this bounding box.
-	double max_x_value = group_points[0].x; //max/min values of the Points that get the bounding box. Initialized with the coordinates of the first Point of the group.
-	double min_x_value = group_points[0].x;
-	double max_y_value = group_points[0].y;
-	double min_y_value = group_points[0].y;
+	int largening_of_bounding_box = 5; //Variable to expand the bounding box of the roomcenters a little bit. This is done to make sure the best trolley position is found if it is a little bit outside this bounding box.
+	int max_x_value = group_points[0].x; //max/min values of the Points that get the bounding box. Initialized with the coordinates of the first Point of the group.
+	int min_x_value = group_points[0].x;
+	int max_y_value = group_points[0].y;
+	int min_y_value = group_points[0].y;
 
 	//create eroded map, which is used to check if the trolley-position candidates are too close to the boundaries
-	cv::Mat eroded_map;
-	cv::erode(original_map, eroded_map, cv::Mat(), cv::Point(-1, -1), 4);
-
-	//create the distance-map to find the candidates for trolley-Positions
-	cv::Mat temporary_map = original_map.clone();
-	cv::erode(temporary_map, temporary_map, cv::Mat());
+	//create the distance-map to prefer candidates that are far away from the boundaries
+	//(both are taken from the map context if it belongs to original_map, the eroded map of the context is only read)
+	const bool use_map_context = (map_context_ && map_context_->isValidFor(original_map) == true);
+	cv::Mat computed_eroded_map;
 	cv::Mat distance_map; //variable for the distance-transformed map, type: CV_32FC1
-	cv::distanceTransform(temporary_map, distance_map, CV_DIST_L2, 5);
-	cv::convertScaleAbs(distance_map, distance_map); // conversion to 8 bit image
+	if (use_map_context == true)
+	{
+		cv::convertScaleAbs(map_context_->getDistanceMap(), distance_map); // conversion to 8 bit image
+	}
+	else
+	{
+		cv::erode(original_map, computed_eroded_map, cv::Mat(), cv::Point(-1, -1), 4);
+		cv::Mat temporary_map = original_map.clone();
+		cv::erode(temporary_map, temporary_map, cv::Mat());
+		cv::distanceTransform(temporary_map, distance_map, CV_DIST_L2, 5);
+		cv::convertScaleAbs(distance_map, distance_map); // conversion to 8 bit image
+	}
+	const cv::Mat& eroded_map = (use_map_context == true ? map_context_->getErodedMap(4) : computed_eroded_map);
 
 	//
 	//******************************** I. Get bounding box of the group ********************************
@@ -40,157 +80,115 @@ cv::Point TrolleyPositionFinder::findOneTrolleyPosition(const std::vector<cv::Po
 	//go trough each Point and find the min/max x/y values --> bounding box
 	for (int point = 0; point < group_points.size(); point++)
 	{
-		if (group_points[point].x > max_x_value)
-		{
-			max_x_value = group_points[point].x;
-		}
-		if (group_points[point].x < min_x_value)
-		{
-			min_x_value = group_points[point].x;
-		}
-		if (group_points[point].y > max_y_value)
-		{
-			max_y_value = group_points[point].y;
-		}
-		if (group_points[point].y < min_y_value)
-		{
-			min_y_value = group_points[point].y;
-		}
+		max_x_value = std::max(max_x_value, group_points[point].x);
+		min_x_value = std::min(min_x_value, group_points[point].x);
+		max_y_value = std::max(max_y_value, group_points[point].y);
+		min_y_value = std::min(min_y_value, group_points[point].y);
 	}
 
-	//expand the bounding box sligthly by the defined factor (check if the values aren't out of the map boundaries before doing this)
-	if (max_x_value + largening_of_bounding_box < original_map.cols)
-	{
-		max_x_value += largening_of_bounding_box;
-	}
-	if (min_x_value - largening_of_bounding_box > 0)
-	{
-		min_x_value -= largening_of_bounding_box;
-	}
-	if (max_y_value + largening_of_bounding_box < original_map.rows)
+	//expand the bounding box sligthly by the defined factor and keep it inside the map boundaries
+	max_x_value = std::min(max_x_value + largening_of_bounding_box, original_map.cols - 1);
+	min_x_value = std::max(min_x_value - largening_of_bounding_box, 0);
+	max_y_value = std::min(max_y_value + largening_of_bounding_box, original_map.rows - 1);
+	min_y_value = std::max(min_y_value - largening_of_bounding_box, 0);
+
+	//
+	//******************************** II. Get the pathlengths from the group points to the bounding box ********************************
+	//
+	// reduce image size, all pathlengths are computed on the downsampled map
+	const double one_by_downsampling_factor = 1./downsampling_factor;
+	cv::Mat downsampled_map;
+	path_planner_.downsampleMap(original_map, downsampled_map, downsampling_factor, robot_radius, map_resolution, map_context_.get());
+
+	//bounding box in the downsampled map
+	const cv::Rect map_rect(0, 0, downsampled_map.cols, downsampled_map.rows);
+	const cv::Point box_offset = downsampling_factor * cv::Point(min_x_value, min_y_value);
+	const cv::Point box_end = downsampling_factor * cv::Point(max_x_value, max_y_value);
+	const cv::Size box_size(box_end.x - box_offset.x + 1, box_end.y - box_offset.y + 1);
+	std::vector<cv::Point> box_cells; //accessible cells of the downsampled bounding box, these are the targets of the wavefronts
+	for (int y = box_offset.y; y <= box_end.y; y++)
+		for (int x = box_offset.x; x <= box_end.x; x++)
+			if (map_rect.contains(cv::Point(x, y)) == true && downsampled_map.at<unsigned char>(y, x) == 255)
+				box_cells.push_back(cv::Point(x, y));
+
+	std::vector<cv::Point> member_cells(group_points.size());
+	std::vector<cv::Mat> pathlengths(group_points.size()); //pathlength in cells of the downsampled map from each member to each cell of the box
+	for (size_t member = 0; member < group_points.size(); member++)
 	{
-		max_y_value += largening_of_bounding_box;
+		member_cells[member] = downsampling_factor * group_points[member];
+		member_cells[member].x = std::max(0, std::min(member_cells[member].x, downsampled_map.cols - 1));
+		member_cells[member].y = std::max(0, std::min(member_cells[member].y, downsampled_map.rows - 1));
+		pathlengths[member] = cv::Mat(box_size, CV_64FC1, cv::Scalar(1e100));
 	}
-	if (min_y_value - largening_of_bounding_box > 0)
+
+	const int number_of_threads = std::min(number_of_threads_, (int)group_points.size());
+	if (number_of_threads <= 1)
+		computeMemberPathLengths(downsampled_map, member_cells, box_cells, box_offset, 0, 1, pathlengths);
+	else
 	{
-		min_y_value -= largening_of_bounding_box;
+		boost::thread_group workers;
+		for (int t = 0; t < number_of_threads; t++)
+			workers.create_thread(boost::bind(&TrolleyPositionFinder::computeMemberPathLengths, boost::cref(downsampled_map), boost::cref(member_cells),
+					boost::cref(box_cells), boost::cref(box_offset), t, number_of_threads, boost::ref(pathlengths)));
+		workers.join_all();
 	}
 
 	//
-	//******************************** II. Get the candidates for trolley positions ********************************
+	//***************** III. Find the candidate that minimizes the pathlengths to all group points *****************
 	//
-	double cell_side_length = 10;
-	double max_x_cell = min_x_value + cell_side_length;
-	double min_x_cell = min_x_value;
-	double max_y_cell = min_y_value + cell_side_length;
-	double min_y_cell = min_y_value;
-
-	bool out_of_y = false;
-	bool out_of_x = false;
-
-	std::vector < cv::Point > trolley_position_candidates;
-
-	//go trough each cell and find the candidate for each of it
-	do //go from y_min to y_max
+	//sum of the pathlengths of each cell of the box, in pixels of the original map
+	cv::Mat summed_pathlengths(box_size, CV_64FC1, cv::Scalar(0.));
+	for (size_t member = 0; member < group_points.size(); member++)
+		summed_pathlengths += pathlengths[member];
+	summed_pathlengths *= one_by_downsampling_factor;
+
+	//the candidates are looked up in the box at the cell they fall into in the downsampled map
+	const cv::Rect box_rect(0, 0, box_size.width, box_size.height);
+	std::vector<cv::Point> candidates; //pixels that are far enough away from the boundaries and reachable from all group points
+	std::vector<cv::Point> candidate_cells;
+	double best_pathlength = 1e90;
+	for (int y = min_y_value; y <= max_y_value; y++)
 	{
-		max_x_cell = min_x_value + cell_side_length; //reset the x-values for the cell to start from beginning when a new y coordinate is reached
-		min_x_cell = min_x_value;
-		do //go from x_min to x_max
-		{
-			out_of_x = false;
-			double best_x = min_x_cell;
-			double best_y = min_y_cell;
-			//go trough each Pixel of the cell and take the one that is most far away of the zero Pixels.
-			for (int y = min_y_cell; y < max_y_cell; y++)
-			{
-				for (int x = min_x_cell; x < max_x_cell; x++)
-				{
-					if (distance_map.at<unsigned char>(best_y, best_x) < distance_map.at<unsigned char>(y, x) && eroded_map.at<unsigned char>(y, x) != 0)
-					{
-						best_x = x;
-						best_y = y;
-					}
-				}
-			}
-			//check if candidate is far enough away from boundary
-			if (eroded_map.at<unsigned char>(best_y, best_x) != 0)
-			{
-				trolley_position_candidates.push_back(cv::Point(best_x, best_y));
-			}
-			min_x_cell = max_x_cell; //set new x values for next step
-			max_x_cell += cell_side_length;
-
-			//check if x is out of box --> if so the next y values should be checked
-			if (min_x_cell > max_x_value)
-			{
-				out_of_x = true;
-			}
-		} while (!out_of_x);
-
-		min_y_cell = max_y_cell; //set new y values for next step
-		max_y_cell += cell_side_length;
-
-		//check if y is out of bounding box --> if true step is done
-		if (min_y_cell > max_y_value)
+		for (int x = min_x_value; x <= max_x_value; x++)
 		{
-			out_of_y = true;
+			const cv::Point cell = downsampling_factor * cv::Point(x, y) - box_offset;
+			if (eroded_map.at<unsigned char>(y, x) == 0 || box_rect.contains(cell) == false || summed_pathlengths.at<double>(cell) >= 1e90)
+				continue;
+			candidates.push_back(cv::Point(x, y));
+			candidate_cells.push_back(cell);
+			best_pathlength = std::min(best_pathlength, summed_pathlengths.at<double>(cell));
 		}
-	} while (!out_of_y);
-
-	//
-	//***************** III. Find the candidate that minimizes the pathlengths to all group points *****************
-	//
-	//variables to save the best candidate
-	double best_pathlength = 1e10;
-	double best_pathlength_point_distance = 1e10;
-	int best_trolley_candidate = 0;
+	}
 
-	// reduce image size already here to avoid resizing in the planner each time
-	const double one_by_downsampling_factor = 1./downsampling_factor;
-	cv::Mat downsampled_map;
-	path_planner_.downsampleMap(original_map, downsampled_map, downsampling_factor, robot_radius, map_resolution);
+	if (candidates.size() == 0)
+	{
+		std::cout << "TrolleyPositionFinder::findOneTrolleyPosition: Warning: no position is reachable from all group points, using the first group point." << std::endl;
+		return group_points[0];
+	}
 
-	//go trough each candidate and calculate the sum of pathlengths
-	for (size_t candidate = 0; candidate < trolley_position_candidates.size(); candidate++)
+	//If the group only has two members every position on the shortest connection path has the same sum of pathlengths, so allow a
+	//tolerance of one cell of the downsampled map and check for the position that is in the middlest of the connectionpath between
+	//these points or else a random point will be chosen.
+	const double pathlength_tolerance = (group_points.size() == 2 ? one_by_downsampling_factor : 1e-6);
+	int best_trolley_candidate = -1;
+	double best_pathlength_point_distance = 1e90;
+	for (size_t candidate = 0; candidate < candidates.size(); candidate++)
 	{
-		cv::Point start_point = downsampling_factor * trolley_position_candidates[candidate];
-		double current_pathlength = 0;
-		std::vector<double> pathlengths;
-		for (int room_center = 0; room_center < group_points.size(); room_center++)
-		{
-			cv::Point end_point = downsampling_factor * group_points[room_center];
-			//get the pathlength to the current center and save it
-			double center_pathlength = one_by_downsampling_factor * path_planner_.planPath(downsampled_map, start_point, end_point, 1., 0., map_resolution);
-			pathlengths.push_back(center_pathlength);
-			//add the pathlenght to the total pathlength
-			current_pathlength += center_pathlength;
-		}
-		//check for the best position that has the shortest pathlength to all centers. Adding a little bit to the best_distances
-		//because the downsampling generates an error and with this better positions can be found.
-		if (group_points.size() == 2)
-		{
-			//If the group only has two members check for the position that is in the middlest of the connectionpath between
-			//these points or else a random point will be chosen.
-			double current_point_distance = std::abs(pathlengths[1] - pathlengths[0]);
-			if (current_pathlength <= (best_pathlength + 0.05) && current_point_distance <= (best_pathlength_point_distance + 0.05)
-					&& downsampled_map.at<unsigned char>(downsampling_factor * trolley_position_candidates[best_trolley_candidate]) != 0)
-			{
-				best_pathlength_point_distance = current_point_distance;
-				best_pathlength = current_pathlength;
-				best_trolley_candidate = candidate;
-			}
-		}
-		else
+		const cv::Point& cell = candidate_cells[candidate];
+		if (summed_pathlengths.at<double>(cell) > best_pathlength + pathlength_tolerance)
+			continue;
+		const double current_point_distance = (group_points.size() == 2 ?
+				one_by_downsampling_factor * std::abs(pathlengths[1].at<double>(cell) - pathlengths[0].at<double>(cell)) : 0.);
+		if (best_trolley_candidate == -1 || current_point_distance < best_pathlength_point_distance - 1e-6 ||
+				(current_point_distance <= best_pathlength_point_distance + 1e-6 &&
+				distance_map.at<unsigned char>(candidates[candidate]) > distance_map.at<unsigned char>(candidates[best_trolley_candidate])))
 		{
-			if (current_pathlength <= (best_pathlength + 0.05))
-			{
-				best_pathlength = current_pathlength;
-				best_trolley_candidate = candidate;
-			}
+			best_pathlength_point_distance = current_point_distance;
+			best_trolley_candidate = (int)candidate;
 		}
 	}
 
-	return trolley_position_candidates[best_trolley_candidate];
+	return candidates[best_trolley_candidate];
 }
 
 //This function takes all found groups and calculates for each of it the best trolley-position using the previously
@@ -0,0 +1,162 @@
+#include <ipa_building_navigation/wavefront_planner.h>
+#include <ipa_building_navigation/instrumentation.h>
+
+#include <algorithm>
+#include <cmath>
+
+// same direction encoding as in the AStarPlanner
+static const int wavefront_dir = 8;
+static const int wavefront_dx[wavefront_dir] = { 1, 1, 0, -1, -1, -1, 0, 1 };
+static const int wavefront_dy[wavefront_dir] = { 0, 1, 1, 1, 0, -1, -1, -1 };
+
+WavefrontPlanner::WavefrontPlanner()
+: rows_(0), cols_(0), start_point_(-1, -1), generation_(0)
+{
+}
+
+void WavefrontPlanner::prepareExpansion(const int rows, const int cols)
+{
+	if (rows != rows_ || cols != cols_)
+	{
+		rows_ = rows;
+		cols_ = cols;
+		const int number_cells = rows_*cols_;
+		reached_generation_.assign(number_cells, 0);
+		settled_generation_.assign(number_cells, 0);
+		target_generation_.assign(number_cells, 0);
+		cost_.resize(number_cells);
+		path_length_.resize(number_cells);
+		predecessor_.resize(number_cells);
+		generation_ = 0;
+	}
+
+	++generation_;
+	if (generation_ == 0)
+	{
+		// overflow of the generation counter: clear the stamps once
+		std::fill(reached_generation_.begin(), reached_generation_.end(), 0);
+		std::fill(settled_generation_.begin(), settled_generation_.end(), 0);
+		std::fill(target_generation_.begin(), target_generation_.end(), 0);
+		generation_ = 1;
+	}
+}
+
+void WavefrontPlanner::computeWavefront(const cv::Mat& map, const cv::Point& start_point, const std::vector<cv::Point>* targets,
+		const cv::Mat* region_map, const int region)
+{
+	prepareExpansion(map.rows, map.cols);
+	start_point_ = start_point;
+
+	if (start_point.x < 0 || start_point.x >= cols_ || start_point.y < 0 || start_point.y >= rows_)
+		return;
+
+	// mark the targets that need to be reached before the expansion may stop
+	int remaining_targets = 0;
+	if (targets != NULL)
+	{
+		for (size_t t=0; t<targets->size(); ++t)
+		{
+			const cv::Point& target = (*targets)[t];
+			if (target.x < 0 || target.x >= cols_ || target.y < 0 || target.y >= rows_)
+				continue;
+			const int index = target.y*cols_ + target.x;
+			const bool accessible = (map.at<unsigned char>(target) == 255 && (region_map == NULL || region_map->at<int>(target) == region));
+			if (target_generation_[index] != generation_ && (accessible == true || target == start_point))
+			{
+				target_generation_[index] = generation_;
+				++remaining_targets;
+			}
+		}
+	}
+
+	// Dijkstra expansion with a lazy priority queue of (cost, cell index)
+	typedef std::pair<int, int> QueueEntry;
+	std::priority_queue<QueueEntry, std::vector<QueueEntry>, std::greater<QueueEntry> > queue;
+	const int start_index = start_point.y*cols_ + start_point.x;
+	reached_generation_[start_index] = generation_;
+	cost_[start_index] = 0;
+	path_length_[start_index] = 0.;
+	predecessor_[start_index] = -1;
+	queue.push(QueueEntry(0, start_index));
+	const double diagonal_step = std::sqrt(2.);
+	long settled_cells = 0;
+	while (queue.empty() == false)
+	{
+		const QueueEntry current = queue.top();
+		queue.pop();
+		const int index = current.second;
+		if (settled_generation_[index] == generation_ || current.first > cost_[index])
+			continue;
+		settled_generation_[index] = generation_;
+		++settled_cells;
+
+		if (targets != NULL && target_generation_[index] == generation_)
+		{
+			--remaining_targets;
+			if (remaining_targets <= 0)
+				break;
+		}
+
+		const int x = index % cols_;
+		const int y = index / cols_;
+		for (int i=0; i<wavefront_dir; ++i)
+		{
+			const int nx = x + wavefront_dx[i];
+			const int ny = y + wavefront_dy[i];
+			if (nx < 0 || nx >= cols_ || ny < 0 || ny >= rows_ || map.at<unsigned char>(ny, nx) != 255)
+				continue;
+			if (region_map != NULL && region_map->at<int>(ny, nx) != region)
+				continue;
+			const int neighbor_index = ny*cols_ + nx;
+			if (settled_generation_[neighbor_index] == generation_)
+				continue;
+			const int new_cost = current.first + (i%2==0 ? 10 : 14);
+			if (reached_generation_[neighbor_index] != generation_ || new_cost < cost_[neighbor_index])
+			{
+				reached_generation_[neighbor_index] = generation_;
+				cost_[neighbor_index] = new_cost;
+				path_length_[neighbor_index] = path_length_[index] + (i%2==0 ? 1. : diagonal_step);
+				predecessor_[neighbor_index] = (signed char)((i + wavefront_dir/2) % wavefront_dir);
+				queue.push(QueueEntry(new_cost, neighbor_index));
+			}
+		}
+	}
+	Instrumentation::addCount("wavefront_expansions", 1);
+	Instrumentation::addCount("wavefront_settled_cells", settled_cells);
+}
+
+bool WavefrontPlanner::isReachable(const cv::Point& target_point) const
+{
+	if (target_point.x < 0 || target_point.x >= cols_ || target_point.y < 0 || target_point.y >= rows_ || generation_ == 0)
+		return false;
+	return (settled_generation_[target_point.y*cols_ + target_point.x] == generation_);
+}
+
+double WavefrontPlanner::getPathLength(const cv::Point& target_point) const
+{
+	if (isReachable(target_point) == false)
+		return 1e100;
+	return path_length_[target_point.y*cols_ + target_point.x];
+}
+
+bool WavefrontPlanner::getPath(const cv::Point& target_point, std::vector<cv::Point>& path) const
+{
+	path.clear();
+	if (isReachable(target_point) == false)
+		return false;
+
+	// follow the predecessors back to the start
+	cv::Point current = target_point;
+	path.push_back(current);
+	while (current != start_point_)
+	{
+		const int j = predecessor_[current.y*cols_ + current.x];
+		if (j < 0)
+			return false;
+		current.x += wavefront_dx[j];
+		current.y += wavefront_dy[j];
+		path.push_back(current);
+	}
+	std::reverse(path.begin(), path.end());
+	return true;
+}
@@ -0,0 +1,180 @@
+/*!
+ *****************************************************************
+ * \file
+ *
+ * \note
+ * Copyright (c) 2026 \n
+ * Fraunhofer Institute for Manufacturing Engineering
+ * and Automation (IPA) \n\n
+ *
+ *****************************************************************
+ *
+ * \note
+ * Project name: Care-O-bot
+ * \note
+ * ROS stack name: autopnp
+ * \note
+ * ROS package name: ipa_building_navigation
+ *
+ * \author
+ * Author: Richard Bormann
+ * \author
+ * Supervised by: Richard Bormann
+ *
+ * \date Date of creation: 10.2026
+ *
+ * \brief
+ *
+ *
+ *****************************************************************
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer. \n
+ * - Redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution. \n
+ * - Neither the name of the Fraunhofer Institute for Manufacturing
+ * Engineering and Automation (IPA) nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission. \n
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License LGPL as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License LGPL for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License LGPL along with this program.
+ * If not, see <http://www.gnu.org/licenses/>.
+ *
+ ****************************************************************/
+
+#pragma once
+
+#include <algorithm>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <ros/ros.h>
+#include <diagnostic_msgs/DiagnosticArray.h>
+
+#include <ipa_building_navigation/instrumentation.h>
+
+// This class connects the Instrumentation of a server process to ROS. It reads the parameters
+//   instrumentation/enabled (bool, default false) and instrumentation/trace_file (string, default empty = no trace)
+// of the given node handle. Call beginCall() at the start and publish() at the end of each action call: the statistics of the
+// call's stages and counters are published as diagnostic_msgs/DiagnosticArray on /diagnostics, one status per stage with the
+// duration histogram, and the spans are written to the trace file in the Chrome trace format, which is overwritten by every call.
+class InstrumentationPublisher
+{
+protected:
+
+	ros::Publisher diagnostics_pub_;
+	std::string name_;			// prefix of the diagnostic status names, e.g. the server name
+	std::string trace_file_;
+
+public:
+
+	InstrumentationPublisher(ros::NodeHandle& node_handle, const std::string& name)
+	: name_(name)
+	{
+		bool enabled = false;
+		node_handle.param("instrumentation/enabled", enabled, false);
+		node_handle.param("instrumentation/trace_file", trace_file_, std::string(""));
+		if (enabled == true)
+		{
+			std::cout << name_ << "/instrumentation/enabled = " << enabled << std::endl;
+			std::cout << name_ << "/instrumentation/trace_file = " << trace_file_ << std::endl;
+			Instrumentation::setEnabled(true);
+			diagnostics_pub_ = node_handle.advertise<diagnostic_msgs::DiagnosticArray>("/diagnostics", 1);
+		}
+	}
+
+	// clears the spans and counters of the previous call
+	void beginCall()
+	{
+		if (Instrumentation::isEnabled() == true)
+			Instrumentation::reset();
+	}
+
+	// publishes the statistics and writes the trace of the current call
+	void publish()
+	{
+		if (Instrumentation::isEnabled() == false)
+			return;
+
+		diagnostic_msgs::DiagnosticArray diagnostics;
+		diagnostics.header.stamp = ros::Time::now();
+
+		// one status per stage
+		std::vector<Instrumentation::StageStatistics> stages;
+		Instrumentation::getStageStatistics(stages);
+		const std::vector<double>& bin_limits = Instrumentation::getHistogramBinLimits();
+		for (size_t i=0; i<stages.size(); ++i)
+		{
+			const Instrumentation::StageStatistics& stage = stages[i];
+			diagnostic_msgs::DiagnosticStatus status;
+			status.level = diagnostic_msgs::DiagnosticStatus::OK;
+			status.name = name_ + ": " + stage.name;
+			std::stringstream message;
+			message << stage.count << " spans, " << stage.total_duration << " ms";
+			status.message = message.str();
+			addValue(status, "count", stage.count);
+			addValue(status, "total [ms]", stage.total_duration);
+			addValue(status, "mean [ms]", stage.total_duration/std::max(1L, stage.count));
+			addValue(status, "min [ms]", stage.min_duration);
+			addValue(status, "max [ms]", stage.max_duration);
+			for (size_t bin=0; bin<stage.histogram.size(); ++bin)
+			{
+				std::stringstream key;
+				if (bin < bin_limits.size())
+					key << "histogram < " << bin_limits[bin] << " ms";
+				else
+					key << "histogram >= " << bin_limits.back() << " ms";
+				addValue(status, key.str(), stage.histogram[bin]);
+			}
+			diagnostics.status.push_back(status);
+		}
+
+		// one status with all counters
+		std::map<std::string, long> counters;
+		Instrumentation::getCounters(counters);
+		if (counters.size() > 0)
+		{
+			diagnostic_msgs::DiagnosticStatus status;
+			status.level = diagnostic_msgs::DiagnosticStatus::OK;
+			status.name = name_ + ": counters";
+			for (std::map<std::string, long>::const_iterator it=counters.begin(); it!=counters.end(); ++it)
+				addValue(status, it->first, it->second);
+			diagnostics.status.push_back(status);
+		}
+		diagnostics_pub_.publish(diagnostics);
+
+		if (trace_file_.empty() == false && Instrumentation::writeChromeTrace(trace_file_) == false)
+			ROS_WARN("InstrumentationPublisher: could not write the trace file %s.", trace_file_.c_str());
+	}
+
+protected:
+
+	template <typename T>
+	static void addValue(diagnostic_msgs::DiagnosticStatus& status, const std::string& key, const T value)
+	{
+		std::stringstream stream;
+		stream << value;
+		diagnostic_msgs::KeyValue key_value;
+		key_value.key = key;
+		key_value.value = stream.str();
+		status.values.push_back(key_value);
+	}
+};
@@ -64,6 +64,8 @@
 #include <iostream>
 #include <iomanip>
 #include <queue>
+#include <map>
+#include <vector>
 #include <string>
 #include <math.h>
 #include <ctime>
@@ -78,6 +80,8 @@
 
 #include <fstream>
 
+#include <boost/thread.hpp>
+
 // Dynamic reconfigure
 #include <dynamic_reconfigure/server.h>
 #include <ipa_building_navigation/BuildingNavigationConfig.h>
@@ -87,6 +91,10 @@
 #include <ipa_building_navigation/nearest_neighbor_TSP.h>
 #include <ipa_building_navigation/genetic_TSP.h>
 #include <ipa_building_navigation/concorde_TSP.h>
+#include <ipa_building_navigation/local_search_TSP.h>
+#include <ipa_building_navigation/distance_matrix.h>
+#include <ipa_building_navigation/distance_matrix_cache.h>
+#include <ipa_building_navigation/instrumentation_publisher.h>
 
 //Set Cover solver to find room groups
 #include <ipa_building_navigation/set_cover_solver.h>
@@ -122,6 +130,8 @@ protected:
 
 	std::string action_name_;
 
+	InstrumentationPublisher instrumentation_publisher_;	// stage timings and counters of each call, see parameters instrumentation/*
+
 	//converter-> Pixel to meter for X coordinate
 	double convert_pixel_to_meter_for_x_coordinate(const int pixel_valued_object_x, const float map_resolution, const cv::Point2d map_origin)
 	{
@@ -138,8 +148,72 @@ protected:
 	// this is the execution function used by action server
 	void findRoomSequenceWithCheckpointsServer(const ipa_building_msgs::FindRoomSequenceWithCheckpointsGoalConstPtr &goal);
 
+	// returns the index of the position that is closest to start_coordinate, map_context provides the downsampled floor plan if it
+	// belongs to it and may be NULL
 	size_t getNearestLocation(const cv::Mat& floor_plan, const cv::Point start_coordinate, const std::vector<cv::Point>& positions,
-			const double map_downsampling_factor, const double robot_radius, const double map_resolution);
+			const double map_downsampling_factor, const double robot_radius, const double map_resolution, const MapContext* map_context);
+
+	// solves the TSP on distance_matrix with the given solver (see TSPSolvers), time_budget in [s] limits the computation time of
+	// the genetic and concorde solvers, <= 0 means no limit
+	std::vector<int> solveTSP(const cv::Mat& distance_matrix, const int start_node, const int tsp_solver, const double time_budget);
+
+	// anytime mode: tries to shorten the closed tour through distance_matrix within time_budget [s] with 2-opt and Or-opt moves that
+	// start from tour, for all TSP solver settings, returns true if a shorter tour has been found
+	bool improveTour(const cv::Mat& distance_matrix, std::vector<int>& tour, const double time_budget);
+
+	// length of the closed tour through distance_matrix
+	double computeTourLength(const cv::Mat& distance_matrix, const std::vector<int>& tour);
+
+	// puts consecutive rooms of room_sequence into the same clique as long as they are close enough to the trolley position of the
+	// clique, the trolley is moved to the first room of a new clique (trolley dragging method), map_context may be NULL
+	void computeDragCliques(const cv::Mat& floor_plan, const std::vector<cv::Point>& room_centers, const std::vector<int>& room_sequence,
+			const cv::Point& robot_start_coordinate, const double robot_radius, const double map_resolution, const MapContext* map_context,
+			std::vector<std::vector<int> >& cliques, std::vector<cv::Point>& trolley_positions);
+
+	// brings cliques and trolley positions into the order of trolley_sequence and the rooms of each clique into the order of room_sequences
+	void orderCliques(const std::vector<std::vector<int> >& cliques, const std::vector<cv::Point>& trolley_positions,
+			const std::vector<int>& trolley_sequence, const std::vector<std::vector<int> >& room_sequences,
+			std::vector<std::vector<int> >& ordered_cliques, std::vector<cv::Point>& ordered_trolley_positions);
+
+	// converts cliques and trolley positions (already in the order of the sequence) into the message format
+	void convertToRoomSequences(const std::vector<std::vector<int> >& cliques, const std::vector<cv::Point>& trolley_positions,
+			const std::map<size_t, size_t>& mapping_room_centers_index_to_original_room_index, const double map_resolution,
+			const cv::Point2d& map_origin, std::vector<ipa_building_msgs::RoomSequence>& room_sequences);
+
+	// anytime mode: publishes the best sequence found so far as action feedback
+	void publishSequenceFeedback(const std::vector<std::vector<int> >& cliques, const std::vector<cv::Point>& trolley_positions,
+			const std::map<size_t, size_t>& mapping_room_centers_index_to_original_room_index, const double map_resolution,
+			const cv::Point2d& map_origin);
+
+	// shared state of the worker threads that determine the start points and room sequences of the cliques
+	struct CliqueSequencingTask
+	{
+		boost::mutex mutex;
+		size_t next_clique;		// index of the next clique that has not been taken by a worker
+		const cv::Mat* floor_plan;
+		const cv::Mat* distance_matrix;		// path lengths between all room centers
+		const std::vector<std::vector<int> >* cliques;
+		const std::vector<cv::Point>* trolley_positions;
+		const std::vector<std::vector<cv::Point> >* room_cliques_as_points;
+		double robot_radius;
+		double map_resolution;
+		const MapContext* map_context;		// preprocessed versions of floor_plan
+		std::vector<size_t>* clique_starting_points;
+		std::vector<std::vector<int> >* optimal_room_sequences;
+		int tsp_solver;				// solver for the room sequences of the cliques
+		bool improve_sequences;		// anytime mode: false = compute the sequences, true = improve the sequences of the previous pass
+		ros::WallTime deadline;		// anytime mode: end of the planning time budget
+		int number_of_threads;
+		const std::vector<int>* trolley_sequence;	// anytime mode: order of the cliques for the feedback
+		const std::map<size_t, size_t>* mapping_room_centers_index_to_original_room_index;
+		cv::Point2d map_origin;
+	};
+
+	// takes cliques from the task until all are done, finds the room closest to the trolley position and solves the TSP of each clique
+	// on the submatrix of the room center distance matrix, every clique writes only its own result entries
+	// in the improvement pass of the anytime mode, each clique gets an equal share of the remaining time of all cliques of its thread
+	// and every improved sequence is stored and published as feedback under the task mutex
+	void cliqueSequencingWorker(CliqueSequencingTask& task);
 
 	void publishSequenceVisualization(const std::vector<ipa_building_msgs::RoomSequence>& room_sequences, const std::vector<cv::Point>& room_centers,
 			std::vector< std::vector<int> >& cliques, const double map_resolution, const cv::Point2d& map_origin);
@@ -158,6 +232,10 @@ protected:
 	int planning_method_;	// Method of planning the sequence: 1 = drag trolley if next room is too far away, 2 = calculate cliques as roomgroups with trolleypositions
 	double max_clique_path_length_;	// max A* path length between two rooms that are assigned to the same clique, in [m]
 	double map_downsampling_factor_;	// the map may be downsampled during computations (e.g. of A* path lengths) in order to speed up the algorithm, range of the factor [0 < factor <= 1], if set to 1 the map will have original size, if set to 0 the algorithm won't work
+	int astar_search_mode_;		// search algorithm of the A* path planner: 1 = standard A*, 2 = Jump Point Search
+	int distance_matrix_backend_;	// method for computing the path lengths of the distance matrix: 1 = A* search per pair, 2 = one wavefront expansion per point, 3 = room graph from the segmented map
+	int distance_matrix_cache_size_;	// number of distance matrices kept in memory for reuse in later requests on the same map, 0 = disabled
+	std::string distance_matrix_cache_directory_;	// directory for storing distance matrices on disk across restarts, empty = disabled
 	bool check_accessibility_of_rooms_;	// boolean to tell the sequence planner if it should check the given room centers for accessibility from the starting position
 	bool return_sequence_map_;	// boolean to tell the server if the map with the sequence drawn in should be returned
 	int max_clique_size_; // maximal number of nodes belonging to one clique, when planning trolley positions
@@ -62,7 +62,8 @@
 RoomSequencePlanningServer::RoomSequencePlanningServer(ros::NodeHandle nh, std::string name_of_the_action) :
 	node_handle_(nh),
 	room_sequence_with_checkpoints_server_(node_handle_, name_of_the_action, boost::bind(&RoomSequencePlanningServer::findRoomSequenceWithCheckpointsServer, this, _1), false),
-	action_name_(name_of_the_action)
+	action_name_(name_of_the_action),
+	instrumentation_publisher_(node_handle_, "room_sequence_planning")
 {
 	// setup publishers
 	room_sequence_visualization_pub_ = nh.advertise<visualization_msgs::MarkerArray>("room_sequence_marker", 1);
@@ -125,6 +126,15 @@ RoomSequencePlanningServer::RoomSequencePlanningServer(ros::NodeHandle nh, std::
 	// general settings
 	node_handle_.param("map_downsampling_factor", map_downsampling_factor_, 0.25);
 	std::cout << "room_sequence_planning/map_downsampling_factor = " << map_downsampling_factor_ << std::endl;
+	node_handle_.param("astar_search_mode", astar_search_mode_, (int)ASTAR_STANDARD);
+	std::cout << "room_sequence_planning/astar_search_mode = " << astar_search_mode_ << std::endl;
+	node_handle_.param("distance_matrix_backend", distance_matrix_backend_, (int)DISTANCE_MATRIX_ASTAR);
+	std::cout << "room_sequence_planning/distance_matrix_backend = " << distance_matrix_backend_ << std::endl;
+	node_handle_.param("distance_matrix_cache_size", distance_matrix_cache_size_, 5);
+	std::cout << "room_sequence_planning/distance_matrix_cache_size = " << distance_matrix_cache_size_ << std::endl;
+	node_handle_.param<std::string>("distance_matrix_cache_directory", distance_matrix_cache_directory_, "");
+	std::cout << "room_sequence_planning/distance_matrix_cache_directory = " << distance_matrix_cache_directory_ << std::endl;
+	DistanceMatrixCache::getInstance().configure(std::max(0, distance_matrix_cache_size_), distance_matrix_cache_directory_);
 	node_handle_.param("check_accessibility_of_rooms", check_accessibility_of_rooms_, true);
 	std::cout << "room_sequence_planning/check_accessibility_of_rooms = " << check_accessibility_of_rooms_ << std::endl;
 	node_handle_.param("return_sequence_map", return_sequence_map_, false);
@@ -189,6 +199,15 @@ void RoomSequencePlanningServer::dynamic_reconfigure_callback(ipa_building_navig
 	// general settings
 	map_downsampling_factor_ = config.map_downsampling_factor;
 	std::cout << "room_sequence_planning/map_downsampling_factor = " << map_downsampling_factor_ << std::endl;
+	astar_search_mode_ = config.astar_search_mode;
+	std::cout << "room_sequence_planning/astar_search_mode = " << astar_search_mode_ << std::endl;
+	distance_matrix_backend_ = config.distance_matrix_backend;
+	std::cout << "room_sequence_planning/distance_matrix_backend = " << distance_matrix_backend_ << std::endl;
+	distance_matrix_cache_size_ = config.distance_matrix_cache_size;
+	std::cout << "room_sequence_planning/distance_matrix_cache_size = " << distance_matrix_cache_size_ << std::endl;
+	distance_matrix_cache_directory_ = config.distance_matrix_cache_directory;
+	std::cout << "room_sequence_planning/distance_matrix_cache_directory = " << distance_matrix_cache_directory_ << std::endl;
+	DistanceMatrixCache::getInstance().configure(std::max(0, distance_matrix_cache_size_), distance_matrix_cache_directory_);
 	check_accessibility_of_rooms_ = config.check_accessibility_of_rooms;
 	std::cout << "room_sequence_planning/check_accessibility_of_rooms = " << check_accessibility_of_rooms_ << std::endl;
 	return_sequence_map_ = config.return_sequence_map;
@@ -200,36 +219,82 @@ void RoomSequencePlanningServer::dynamic_reconfigure_callback(ipa_building_navig
 void RoomSequencePlanningServer::findRoomSequenceWithCheckpointsServer(const ipa_building_msgs::FindRoomSequenceWithCheckpointsGoalConstPtr &goal)
 {
 	ROS_INFO("********Sequence planning started************");
+	instrumentation_publisher_.beginCall();
+	ScopedSpan sequence_planning_span("sequence_planning");
+
+	// anytime mode: nearest neighbor sequences are published first and then improved until the deadline, the improvement runs
+	// synchronously in this callback, so the result is only sent afterwards and the feedback is the only early result
+	const bool anytime_mode = (goal->planning_time_budget > 0.);
+	const ros::WallTime deadline = ros::WallTime::now() + ros::WallDuration(std::max(0., (double)goal->planning_time_budget));
 
 	// converting the map msg in cv format
 	cv_bridge::CvImagePtr cv_ptr_obj;
 	cv_ptr_obj = cv_bridge::toCvCopy(goal->input_map, sensor_msgs::image_encodings::MONO8);
 	cv::Mat floor_plan = cv_ptr_obj->image;
 
+	// compute the eroded and downsampled versions of the floor plan only once for all planners of this request
+	boost::shared_ptr<const MapContext> map_context(new MapContext(floor_plan, goal->robot_radius, goal->map_resolution));
+
 	//get map origin and convert robot start coordinate to [pixel]
 	const cv::Point2d map_origin(goal->map_origin.position.x, goal->map_origin.position.y);
 	cv::Point robot_start_coordinate((goal->robot_start_coordinate.position.x - map_origin.x)/goal->map_resolution, (goal->robot_start_coordinate.position.y - map_origin.y)/goal->map_resolution);
 
+	// build the room graph for the distance matrices of this request from the segmented map
+	boost::shared_ptr<RoomGraphPlanner> room_graph;
+	if (distance_matrix_backend_ == DISTANCE_MATRIX_ROOM_GRAPH)
+	{
+		if (goal->segmented_map.data.size() > 0)
+		{
+			cv_bridge::CvImagePtr cv_ptr_segmented;
+			cv_ptr_segmented = cv_bridge::toCvCopy(goal->segmented_map, sensor_msgs::image_encodings::TYPE_32SC1);
+			const cv::Mat segmented_map = cv_ptr_segmented->image;
+			if (segmented_map.rows == floor_plan.rows && segmented_map.cols == floor_plan.cols)
+			{
+				room_graph.reset(new RoomGraphPlanner());
+				room_graph->buildGraph(floor_plan, segmented_map, map_downsampling_factor_, goal->robot_radius, goal->map_resolution, map_context.get());
+			}
+			else
+				ROS_WARN("The segmented map does not have the size of the input map, using A* for the distance matrices.");
+		}
+		else
+			ROS_WARN("No segmented map provided for the room graph, using A* for the distance matrices.");
+	}
+
+	// settings of the distance matrices of this request, the computations in the action callback itself use all cores
+	DistanceMatrixSettings distance_matrix_settings;
+	distance_matrix_settings.number_of_threads = 0;
+	distance_matrix_settings.backend = distance_matrix_backend_;
+	distance_matrix_settings.astar_search_mode = astar_search_mode_;
+	distance_matrix_settings.room_graph = room_graph;
+	distance_matrix_settings.map_context = map_context;
 
 	//create a star pathplanner to plan a path from Point A to Point B in a given gridmap
 	AStarPlanner a_star_path_planner;
+	a_star_path_planner.setSearchMode(distance_matrix_settings.astar_search_mode);
 
-	//get room centers and check how many of them are reachable
-	cv::Mat downsampled_map_for_accessibility_checking;
+	//get room centers and check how many of them are reachable (one wavefront from the robot start position to all room centers)
+	std::vector<cv::Point> all_room_centers(goal->room_information_in_pixel.size());
+	for (size_t i=0; i<goal->room_information_in_pixel.size(); ++i)
+		all_room_centers[i] = cv::Point(goal->room_information_in_pixel[i].room_center.x, goal->room_information_in_pixel[i].room_center.y);
+	std::vector<double> room_center_path_lengths;
 	if(check_accessibility_of_rooms_ == true)
 	{
-		a_star_path_planner.downsampleMap(floor_plan, downsampled_map_for_accessibility_checking, map_downsampling_factor_, goal->robot_radius, goal->map_resolution);
+		std::cout << "checking for accessibility of rooms" << std::endl;
+		ScopedSpan span("accessibility_check");
+		cv::Mat downsampled_map_for_accessibility_checking;
+		a_star_path_planner.downsampleMap(floor_plan, downsampled_map_for_accessibility_checking, map_downsampling_factor_, goal->robot_radius, goal->map_resolution, map_context.get());
+		DistanceMatrix distance_matrix_computation;
+		distance_matrix_computation.computePathLengthsFromPoint(room_center_path_lengths, floor_plan, downsampled_map_for_accessibility_checking,
+				robot_start_coordinate, all_room_centers, map_downsampling_factor_, goal->map_resolution, a_star_path_planner);
 	}
 	std::vector<cv::Point> room_centers;	// collect the valid, accessible room_centers
 	std::map<size_t, size_t> mapping_room_centers_index_to_original_room_index;		// maps the index of each entry in room_centers to the original index in goal->room_information_in_pixel
 	for (size_t i=0; i<goal->room_information_in_pixel.size(); ++i)
 	{
-		cv::Point current_center(goal->room_information_in_pixel[i].room_center.x, goal->room_information_in_pixel[i].room_center.y);
+		const cv::Point& current_center = all_room_centers[i];
 		if(check_accessibility_of_rooms_ == true)
 		{
-			std::cout << "checking for accessibility of rooms" << std::endl;
-			double length = a_star_path_planner.planPath(floor_plan, downsampled_map_for_accessibility_checking, robot_start_coordinate, current_center, map_downsampling_factor_, 0., goal->map_resolution);
-			if(length < 1e9)
+			if(room_center_path_lengths[i] < 1e9)
 			{
 				room_centers.push_back(current_center);
 				mapping_room_centers_index_to_original_room_index[room_centers.size()-1] = i;
@@ -241,9 +306,9 @@ void RoomSequencePlanningServer::findRoomSequenceWithCheckpointsServer(const ipa
 		else
 		{
 			room_centers.push_back(current_center);
+			mapping_room_centers_index_to_original_room_index[room_centers.size()-1] = i;
 		}
 	}
-	downsampled_map_for_accessibility_checking.release(); //release not anymore needed space
 
 	std::cout << "number of reachable roomcenters: " << room_centers.size() << std::endl;
 
@@ -252,6 +317,8 @@ void RoomSequencePlanningServer::findRoomSequenceWithCheckpointsServer(const ipa
 		ROS_ERROR("No given roomcenter reachable from starting position.");
 		ipa_building_msgs::FindRoomSequenceWithCheckpointsResult action_result;
 		room_sequence_with_checkpoints_server_.setAborted(action_result);
+		sequence_planning_span.stop();
+		instrumentation_publisher_.publish();
 		return;
 	}
 
@@ -284,51 +351,37 @@ void RoomSequencePlanningServer::findRoomSequenceWithCheckpointsServer(const ipa
 	{
 		std::cout << "Maximal cliquedistance [m]: "<< max_clique_path_length_  << " Maximal cliquedistance [Pixel]: "<< max_clique_path_length_/goal->map_resolution << std::endl;
 
+		//compute the path lengths between all room centers once, the TSP solvers and the anytime improvement work on this matrix
+		cv::Mat room_center_distance_matrix;
+		DistanceMatrix distance_matrix_computation(distance_matrix_settings);
+		distance_matrix_computation.constructDistanceMatrix(room_center_distance_matrix, floor_plan, room_centers, map_downsampling_factor_, goal->robot_radius, goal->map_resolution, a_star_path_planner);
+
 		//calculate the index of the best starting position
-		size_t optimal_start_position = getNearestLocation(floor_plan, robot_start_coordinate, room_centers, map_downsampling_factor_, goal->robot_radius, goal->map_resolution);
+		size_t optimal_start_position = getNearestLocation(floor_plan, robot_start_coordinate, room_centers, map_downsampling_factor_, goal->robot_radius, goal->map_resolution, map_context.get());
 
-		//plan the optimal path trough all given rooms
+		//plan the optimal path trough all given rooms and put the rooms that are close enough together into the same clique
 		std::vector<int> optimal_room_sequence;
-		if(tsp_solver_ == TSP_NEAREST_NEIGHBOR) //nearest neighbor TSP solver
-		{
-			NearestNeighborTSPSolver nearest_neighbor_tsp_solver;
-			optimal_room_sequence = nearest_neighbor_tsp_solver.solveNearestTSP(floor_plan, room_centers, map_downsampling_factor_, goal->robot_radius, goal->map_resolution, (int) optimal_start_position);
-		}
-		if(tsp_solver_ == TSP_GENETIC) //genetic TSP solver
-		{
-			GeneticTSPSolver genetic_tsp_solver;
-			optimal_room_sequence = genetic_tsp_solver.solveGeneticTSP(floor_plan, room_centers, map_downsampling_factor_, goal->robot_radius, goal->map_resolution, (int) optimal_start_position);
-		}
-		if(tsp_solver_ == TSP_CONCORDE) //concorde TSP solver
-		{
-			ConcordeTSPSolver concorde_tsp_solver;
-			optimal_room_sequence = concorde_tsp_solver.solveConcordeTSP(floor_plan, room_centers, map_downsampling_factor_, goal->robot_radius, goal->map_resolution, (int) optimal_start_position);
-		}
-
-		//put the rooms that are close enough together into the same clique, if a new clique is needed put the first roomcenter as a trolleyposition
-		std::vector<int> current_clique;
-		trolley_positions.push_back(robot_start_coordinate); //trolley stands close to robot on startup
-		//sample down map one time to reduce calculation time
-		cv::Mat downsampled_map;
-		a_star_path_planner.downsampleMap(floor_plan, downsampled_map, map_downsampling_factor_, goal->robot_radius, goal->map_resolution);
-		const double one_by_downsampling_factor = 1 / map_downsampling_factor_;
-		for(size_t i=0; i<optimal_room_sequence.size(); ++i)
+		if (anytime_mode == true)
 		{
-			double distance_to_trolley = a_star_path_planner.planPath(floor_plan, downsampled_map, trolley_positions.back(), room_centers[optimal_room_sequence[i]], map_downsampling_factor_, 0, goal->map_resolution);
-			if (distance_to_trolley <= max_clique_path_length_/goal->map_resolution && current_clique.size() < max_clique_size_) //expand current clique by next roomcenter
-			{
-				current_clique.push_back(optimal_room_sequence[i]);
-			}
-			else //start new clique and put the old clique into the cliques vector
+			optimal_room_sequence = solveTSP(room_center_distance_matrix, (int)optimal_start_position, TSP_NEAREST_NEIGHBOR, 0.);
+			const ros::WallTime drag_cliques_start = ros::WallTime::now();
+			computeDragCliques(floor_plan, room_centers, optimal_room_sequence, robot_start_coordinate, goal->robot_radius, goal->map_resolution, map_context.get(), cliques, trolley_positions);
+			// the cliques have to be computed again after an improvement, so the improvement stops that much earlier
+			const ros::WallDuration drag_cliques_duration = ros::WallTime::now() - drag_cliques_start;
+			publishSequenceFeedback(cliques, trolley_positions, mapping_room_centers_index_to_original_room_index, goal->map_resolution, map_origin);
+			if (improveTour(room_center_distance_matrix, optimal_room_sequence, (deadline-drag_cliques_duration-ros::WallTime::now()).toSec()) == true)
 			{
-				cliques.push_back(current_clique);
-				current_clique.clear();
-				current_clique.push_back(optimal_room_sequence[i]);
-				trolley_positions.push_back(room_centers[optimal_room_sequence[i]]);
+				cliques.clear();
+				trolley_positions.clear();
+				computeDragCliques(floor_plan, room_centers, optimal_room_sequence, robot_start_coordinate, goal->robot_radius, goal->map_resolution, map_context.get(), cliques, trolley_positions);
+				publishSequenceFeedback(cliques, trolley_positions, mapping_room_centers_index_to_original_room_index, goal->map_resolution, map_origin);
 			}
 		}
-		//add last clique
-		cliques.push_back(current_clique);
+		else
+		{
+			optimal_room_sequence = solveTSP(room_center_distance_matrix, (int)optimal_start_position, tsp_solver_, 0.);
+			computeDragCliques(floor_plan, room_centers, optimal_room_sequence, robot_start_coordinate, goal->robot_radius, goal->map_resolution, map_context.get(), cliques, trolley_positions);
+		}
 
 		//fill vector of cv::Point for display purpose
 		for(size_t i=0; i<cliques.size(); ++i)
@@ -385,39 +438,37 @@ void RoomSequencePlanningServer::findRoomSequenceWithCheckpointsServer(const ipa
 		std::cout << "Maximal cliquedistance [m]: "<< max_clique_path_length_  << " Maximal cliquedistance [Pixel]: "<< max_clique_path_length_/goal->map_resolution << std::endl;
 
 		std::cout << "finding trolley positions" << std::endl;
-		// 1. determine cliques of rooms
+		// 1. determine cliques of rooms (the distance matrix of all room centers is also used for the room sequences within the cliques)
+		cv::Mat room_center_distance_matrix;
+		DistanceMatrix distance_matrix_computation(distance_matrix_settings);
+		distance_matrix_computation.constructDistanceMatrix(room_center_distance_matrix, floor_plan, room_centers, map_downsampling_factor_, goal->robot_radius, goal->map_resolution, a_star_path_planner);
+		ScopedSpan set_cover_span("set_cover");
 		SetCoverSolver set_cover_solver;
-		cliques = set_cover_solver.solveSetCover(floor_plan, room_centers, map_downsampling_factor_, goal->robot_radius, goal->map_resolution, max_clique_path_length_/goal->map_resolution, max_clique_size_);
+		cliques = set_cover_solver.solveSetCover(room_center_distance_matrix, room_centers, (int)room_centers.size(), max_clique_path_length_/goal->map_resolution, max_clique_size_);
+
+		set_cover_span.stop();
 
 		// 2. determine trolley position within each clique (same indexing as in cliques)
+		ScopedSpan trolley_positions_span("trolley_positions");
 		TrolleyPositionFinder trolley_position_finder;
+		trolley_position_finder.setNumberOfThreads(distance_matrix_settings.number_of_threads);
+		trolley_position_finder.setMapContext(map_context);
 		trolley_positions = trolley_position_finder.findTrolleyPositions(floor_plan, cliques, room_centers, map_downsampling_factor_, goal->robot_radius, goal->map_resolution);
+		trolley_positions_span.stop();
 		std::cout << "Trolley positions within each clique computed" << std::endl;
 
 		// 3. determine optimal sequence of trolley positions (solve TSP problem)
 		//		a) find nearest trolley location to current robot location
 		//		b) solve the TSP for the trolley positions
 		// reduce image size already here to avoid resizing in the planner each time
-		size_t optimal_trolley_start_position = getNearestLocation(floor_plan, robot_start_coordinate, trolley_positions, map_downsampling_factor_, goal->robot_radius, goal->map_resolution);
+		size_t optimal_trolley_start_position = getNearestLocation(floor_plan, robot_start_coordinate, trolley_positions, map_downsampling_factor_, goal->robot_radius, goal->map_resolution, map_context.get());
 
-		//solve the TSP
+		//solve the TSP on the path lengths between the trolley positions, in anytime mode start with the nearest neighbor sequence
 		std::vector<int> optimal_trolley_sequence;
 		std::cout << "finding optimal trolley sequence. Start: " << optimal_trolley_start_position << std::endl;
-		if(tsp_solver_ == TSP_NEAREST_NEIGHBOR) //nearest neighbor TSP solver
-		{
-			NearestNeighborTSPSolver nearest_neighbor_tsp_solver;
-			optimal_trolley_sequence = nearest_neighbor_tsp_solver.solveNearestTSP(floor_plan, trolley_positions, map_downsampling_factor_, goal->robot_radius, goal->map_resolution, (int) optimal_trolley_start_position);
-		}
-		if(tsp_solver_ == TSP_GENETIC) //genetic TSP solver
-		{
-			GeneticTSPSolver genetic_tsp_solver;
-			optimal_trolley_sequence = genetic_tsp_solver.solveGeneticTSP(floor_plan, trolley_positions, map_downsampling_factor_, goal->robot_radius, goal->map_resolution, (int) optimal_trolley_start_position);
-		}
-		if(tsp_solver_ == TSP_CONCORDE) //concorde TSP solver
-		{
-			ConcordeTSPSolver concorde_tsp_solver;
-			optimal_trolley_sequence = concorde_tsp_solver.solveConcordeTSP(floor_plan, trolley_positions, map_downsampling_factor_, goal->robot_radius, goal->map_resolution, (int) optimal_trolley_start_position);
-		}
+		cv::Mat trolley_distance_matrix;
+		distance_matrix_computation.constructDistanceMatrix(trolley_distance_matrix, floor_plan, trolley_positions, map_downsampling_factor_, goal->robot_radius, goal->map_resolution, a_star_path_planner);
+		optimal_trolley_sequence = solveTSP(trolley_distance_matrix, (int)optimal_trolley_start_position, (anytime_mode==true ? (int)TSP_NEAREST_NEIGHBOR : tsp_solver_), 0.);
 
 		// 4. determine optimal sequence of rooms with each clique (solve TSP problem)
 		//		a) find start point for each clique closest to the trolley position
@@ -455,41 +506,62 @@ void RoomSequencePlanningServer::findRoomSequenceWithCheckpointsServer(const ipa
 		std::cout << std::endl;
 
 		std::cout << "number of trolley positions: " << trolley_positions.size() << " " << optimal_trolley_sequence.size() << std::endl;
-		//find starting points
-		//find starting points
+		//find the starting points and solve the TSPs of the cliques, the cliques are independent and distributed over a bounded number of threads
 		std::vector<size_t> clique_starting_points(cliques.size());
-		for(size_t i=0; i<cliques.size(); ++i)
-			clique_starting_points[i] = getNearestLocation(floor_plan, trolley_positions[i], room_cliques_as_points[i], map_downsampling_factor_, goal->robot_radius, goal->map_resolution);
-		//solve TSPs
 		std::vector< std::vector <int> > optimal_room_sequences(cliques.size());
-		// Create the TSP solver objects two times and not one time for the whole function because by this way only two objects has to be
-		// created and else three
-		if(tsp_solver_ == TSP_NEAREST_NEIGHBOR) //nearest neighbor TSP solver
-		{
-			NearestNeighborTSPSolver nearest_neighbor_tsp_solver;
-			for(size_t i=0; i<cliques.size(); ++i)
-			{
-				optimal_room_sequences[i] = nearest_neighbor_tsp_solver.solveNearestTSP(floor_plan, room_cliques_as_points[i], map_downsampling_factor_, goal->robot_radius, goal->map_resolution, clique_starting_points[i]);
-				std::cout << "done one clique" << std::endl;
-			}
-		}
-		if(tsp_solver_ == TSP_GENETIC) //genetic TSP solver
+		CliqueSequencingTask task;
+		task.next_clique = 0;
+		task.floor_plan = &floor_plan;
+		task.distance_matrix = &room_center_distance_matrix;
+		task.cliques = &cliques;
+		task.trolley_positions = &trolley_positions;
+		task.room_cliques_as_points = &room_cliques_as_points;
+		task.robot_radius = goal->robot_radius;
+		task.map_resolution = goal->map_resolution;
+		task.map_context = map_context.get();
+		task.clique_starting_points = &clique_starting_points;
+		task.optimal_room_sequences = &optimal_room_sequences;
+		task.tsp_solver = (anytime_mode==true ? (int)TSP_NEAREST_NEIGHBOR : tsp_solver_);
+		task.improve_sequences = false;
+		task.deadline = deadline;
+		task.trolley_sequence = &optimal_trolley_sequence;
+		task.mapping_room_centers_index_to_original_room_index = &mapping_room_centers_index_to_original_room_index;
+		task.map_origin = map_origin;
+		const int number_of_threads = std::min((int)cliques.size(), std::max(1, (int)boost::thread::hardware_concurrency()));
+		task.number_of_threads = number_of_threads;
 		{
-			GeneticTSPSolver genetic_tsp_solver;
-			for(size_t i=0; i<cliques.size(); ++i)
-			{
-				optimal_room_sequences[i] = genetic_tsp_solver.solveGeneticTSP(floor_plan, room_cliques_as_points[i], map_downsampling_factor_, goal->robot_radius, goal->map_resolution, clique_starting_points[i]);
-				std::cout << "done one clique" << std::endl;
-			}
+			boost::thread_group workers;
+			for (int t = 1; t < number_of_threads; ++t)
+				workers.create_thread(boost::bind(&RoomSequencePlanningServer::cliqueSequencingWorker, this, boost::ref(task)));
+			cliqueSequencingWorker(task);	// the calling thread works as well
+			workers.join_all();
 		}
-		if(tsp_solver_ == TSP_CONCORDE) //concorde TSP solver
+		std::cout << "room sequences of " << cliques.size() << " cliques computed with " << number_of_threads << " threads" << std::endl;
+
+		// anytime mode: publish the nearest neighbor sequences, then improve the trolley sequence and the room sequences until the deadline
+		if (anytime_mode == true)
 		{
-			ConcordeTSPSolver concorde_tsp_solver;
-			for(size_t i=0; i<cliques.size(); ++i)
+			std::vector<std::vector<int> > ordered_cliques;
+			std::vector<cv::Point> ordered_trolley_positions;
+			orderCliques(cliques, trolley_positions, optimal_trolley_sequence, optimal_room_sequences, ordered_cliques, ordered_trolley_positions);
+			publishSequenceFeedback(ordered_cliques, ordered_trolley_positions, mapping_room_centers_index_to_original_room_index, goal->map_resolution, map_origin);
+
+			// the trolley sequence gets a share of the remaining time that corresponds to its share of all nodes
+			const double trolley_time_share = (double)trolley_positions.size()/(double)(trolley_positions.size()+room_centers.size());
+			if (improveTour(trolley_distance_matrix, optimal_trolley_sequence, trolley_time_share*(deadline-ros::WallTime::now()).toSec()) == true)
 			{
-				optimal_room_sequences[i] = concorde_tsp_solver.solveConcordeTSP(floor_plan, room_cliques_as_points[i], map_downsampling_factor_, goal->robot_radius, goal->map_resolution, clique_starting_points[i]);
-				std::cout << "done one clique" << std::endl;
+				orderCliques(cliques, trolley_positions, optimal_trolley_sequence, optimal_room_sequences, ordered_cliques, ordered_trolley_positions);
+				publishSequenceFeedback(ordered_cliques, ordered_trolley_positions, mapping_room_centers_index_to_original_room_index, goal->map_resolution, map_origin);
 			}
+
+			task.next_clique = 0;
+			task.improve_sequences = true;
+			boost::thread_group workers;
+			for (int t = 1; t < number_of_threads; ++t)
+				workers.create_thread(boost::bind(&RoomSequencePlanningServer::cliqueSequencingWorker, this, boost::ref(task)));
+			cliqueSequencingWorker(task);
+			workers.join_all();
+			std::cout << "sequences improved until " << (ros::WallTime::now()-deadline).toSec() << " s relative to the deadline" << std::endl;
 		}
 
 		if(return_sequence_map_ == true)
@@ -535,16 +607,9 @@ void RoomSequencePlanningServer::findRoomSequenceWithCheckpointsServer(const ipa
 		}
 
 		// reorder cliques, trolley positions and rooms into optimal order
-		std::vector<std::vector<int> > new_cliques_order(cliques.size());
-		std::vector<cv::Point> new_trolley_positions(trolley_positions.size());
-		for (size_t i=0; i<optimal_trolley_sequence.size(); ++i)
-		{
-			const int oi = optimal_trolley_sequence[i];
-			new_trolley_positions[i] = trolley_positions[oi];
-			new_cliques_order[i].resize(optimal_room_sequences[oi].size());
-			for (size_t j=0; j<optimal_room_sequences[oi].size(); ++j)
-				new_cliques_order[i][j] = cliques[oi][optimal_room_sequences[oi][j]];
-		}
+		std::vector<std::vector<int> > new_cliques_order;
+		std::vector<cv::Point> new_trolley_positions;
+		orderCliques(cliques, trolley_positions, optimal_trolley_sequence, optimal_room_sequences, new_cliques_order, new_trolley_positions);
 		cliques = new_cliques_order;
 		trolley_positions = new_trolley_positions;
 	}
@@ -553,26 +618,16 @@ void RoomSequencePlanningServer::findRoomSequenceWithCheckpointsServer(const ipa
 		ROS_ERROR("Undefined planning method.");
 		ipa_building_msgs::FindRoomSequenceWithCheckpointsResult action_result;
 		room_sequence_with_checkpoints_server_.setAborted(action_result);
+		sequence_planning_span.stop();
+		instrumentation_publisher_.publish();
 		return;
 	}
 	std::cout << "done sequence planning" << std::endl << std::endl;
 
 	// return results
 	ipa_building_msgs::FindRoomSequenceWithCheckpointsResult action_result;
-	std::vector<ipa_building_msgs::RoomSequence> room_sequences(cliques.size());
-	for(size_t i=0; i<cliques.size(); ++i)
-	{
-		//convert signed int to unsigned int (necessary for this msg type)
-		room_sequences[i].room_indices.resize(cliques[i].size());
-		for (size_t j=0; j<cliques[i].size(); ++j)
-			room_sequences[i].room_indices[j] = mapping_room_centers_index_to_original_room_index[cliques[i][j]];
-		room_sequences[i].checkpoint_position_in_pixel.x = trolley_positions[i].x;
-		room_sequences[i].checkpoint_position_in_pixel.y = trolley_positions[i].y;
-		room_sequences[i].checkpoint_position_in_pixel.z = 0.;
-		room_sequences[i].checkpoint_position_in_meter.x = convert_pixel_to_meter_for_x_coordinate(trolley_positions[i].x, goal->map_resolution, map_origin);
-		room_sequences[i].checkpoint_position_in_meter.y = convert_pixel_to_meter_for_y_coordinate(trolley_positions[i].y, goal->map_resolution, map_origin);
-		room_sequences[i].checkpoint_position_in_meter.z = 0.;
-	}
+	std::vector<ipa_building_msgs::RoomSequence> room_sequences;
+	convertToRoomSequences(cliques, trolley_positions, mapping_room_centers_index_to_original_room_index, goal->map_resolution, map_origin, room_sequences);
 	action_result.checkpoints = room_sequences;
 	if(return_sequence_map_ == true)
 	{
@@ -588,6 +643,8 @@ void RoomSequencePlanningServer::findRoomSequenceWithCheckpointsServer(const ipa
 	publishSequenceVisualization(room_sequences, room_centers, cliques, goal->map_resolution, cv::Point2d(goal->map_origin.position.x, goal->map_origin.position.y));
 
 	room_sequence_with_checkpoints_server_.setSucceeded(action_result);
+	sequence_planning_span.stop();
+	instrumentation_publisher_.publish();
 
 	//garbage collection
 	action_result.checkpoints.clear();
@@ -595,21 +652,232 @@ void RoomSequencePlanningServer::findRoomSequenceWithCheckpointsServer(const ipa
 	ROS_INFO("********Sequence planning finished************");
 }
 
-size_t RoomSequencePlanningServer::getNearestLocation(const cv::Mat& floor_plan, const cv::Point start_coordinate, const std::vector<cv::Point>& positions,
-		const double map_downsampling_factor, const double robot_radius, const double map_resolution)
+void RoomSequencePlanningServer::cliqueSequencingWorker(CliqueSequencingTask& task)
 {
-//	const double one_by_downsampling_factor = 1./map_downsampling_factor;
-	cv::Mat downsampled_map;
+	while (true)
+	{
+		size_t i = 0;
+		{
+			boost::mutex::scoped_lock lock(task.mutex);
+			if (task.next_clique >= task.cliques->size())
+				return;
+			i = task.next_clique++;
+		}
+
+		if (task.improve_sequences == false)
+			task.clique_starting_points->at(i) = getNearestLocation(*task.floor_plan, task.trolley_positions->at(i), task.room_cliques_as_points->at(i), map_downsampling_factor_, task.robot_radius, task.map_resolution, task.map_context);
+
+		// slice the distance matrix of the clique from the distance matrix of all room centers
+		const std::vector<int>& clique = task.cliques->at(i);
+		cv::Mat clique_distance_matrix((int)clique.size(), (int)clique.size(), CV_64F);
+		for (size_t r=0; r<clique.size(); ++r)
+			for (size_t c=0; c<clique.size(); ++c)
+				clique_distance_matrix.at<double>(r, c) = task.distance_matrix->at<double>(clique[r], clique[c]);
+
+		if (task.improve_sequences == true)
+		{
+			// equal share of the remaining time for the cliques that are still left for this thread
+			const double remaining_cliques_per_thread = std::max(1., (double)(task.cliques->size()-i)/(double)task.number_of_threads);
+			std::vector<int> room_sequence = task.optimal_room_sequences->at(i);
+			if (improveTour(clique_distance_matrix, room_sequence, (task.deadline-ros::WallTime::now()).toSec()/remaining_cliques_per_thread) == true)
+			{
+				// the other workers may not change their sequences while the ordered sequences are published
+				boost::mutex::scoped_lock lock(task.mutex);
+				task.optimal_room_sequences->at(i) = room_sequence;
+				std::vector<std::vector<int> > ordered_cliques;
+				std::vector<cv::Point> ordered_trolley_positions;
+				orderCliques(*task.cliques, *task.trolley_positions, *task.trolley_sequence, *task.optimal_room_sequences, ordered_cliques, ordered_trolley_positions);
+				publishSequenceFeedback(ordered_cliques, ordered_trolley_positions, *task.mapping_room_centers_index_to_original_room_index, task.map_resolution, task.map_origin);
+			}
+		}
+		else
+			task.optimal_room_sequences->at(i) = solveTSP(clique_distance_matrix, (int)task.clique_starting_points->at(i), task.tsp_solver, 0.);
+	}
+}
+
+std::vector<int> RoomSequencePlanningServer::solveTSP(const cv::Mat& distance_matrix, const int start_node, const int tsp_solver, const double time_budget)
+{
+	std::vector<int> sequence;
+	if(tsp_solver == TSP_NEAREST_NEIGHBOR) //nearest neighbor TSP solver
+	{
+		NearestNeighborTSPSolver nearest_neighbor_tsp_solver;
+		sequence = nearest_neighbor_tsp_solver.solveNearestTSP(distance_matrix, start_node);
+	}
+	if(tsp_solver == TSP_GENETIC) //genetic TSP solver
+	{
+		GeneticTSPSolver genetic_tsp_solver;
+		if (time_budget > 0.)
+			genetic_tsp_solver.setTimeBudget(time_budget);
+		sequence = genetic_tsp_solver.solveGeneticTSP(distance_matrix, start_node);
+	}
+	if(tsp_solver == TSP_CONCORDE) //concorde TSP solver
+	{
+		ConcordeTSPSolver concorde_tsp_solver;
+		if (time_budget > 0.)
+			concorde_tsp_solver.setTimeBudget(time_budget);
+		sequence = concorde_tsp_solver.solveConcordeTSP(distance_matrix, start_node);
+	}
+	return sequence;
+}
+
+bool RoomSequencePlanningServer::improveTour(const cv::Mat& distance_matrix, std::vector<int>& tour, const double time_budget)
+{
+	// closed tours through less than four nodes are already optimal
+	if (time_budget <= 0. || tour.size() < 4)
+		return false;
+
+	// the local search starts from the current tour, so the time already spent on it is not lost
+	LocalSearchTSPSolver local_search_tsp_solver;
+	local_search_tsp_solver.setTimeBudget(time_budget);
+	const std::vector<int> improved_tour = local_search_tsp_solver.solveLocalSearchTSP(distance_matrix, tour);
+
+	// only accept complete tours that are shorter than the current one
+	if (improved_tour.size() != tour.size() || computeTourLength(distance_matrix, improved_tour) >= computeTourLength(distance_matrix, tour))
+		return false;
+	tour = improved_tour;
+	return true;
+}
+
+double RoomSequencePlanningServer::computeTourLength(const cv::Mat& distance_matrix, const std::vector<int>& tour)
+{
+	double length = 0.;
+	for (size_t i=0; i<tour.size(); ++i)
+		length += distance_matrix.at<double>(tour[i], tour[(i+1)%tour.size()]);
+	return length;
+}
+
+void RoomSequencePlanningServer::computeDragCliques(const cv::Mat& floor_plan, const std::vector<cv::Point>& room_centers, const std::vector<int>& room_sequence,
+		const cv::Point& robot_start_coordinate, const double robot_radius, const double map_resolution, const MapContext* map_context,
+		std::vector<std::vector<int> >& cliques, std::vector<cv::Point>& trolley_positions)
+{
+	//put the rooms that are close enough together into the same clique, if a new clique is needed put the first roomcenter as a trolleyposition
+	std::vector<int> current_clique;
+	trolley_positions.push_back(robot_start_coordinate); //trolley stands close to robot on startup
+	//sample down map one time to reduce calculation time
 	AStarPlanner a_star_path_planner;
-	a_star_path_planner.downsampleMap(floor_plan, downsampled_map, map_downsampling_factor, robot_radius, map_resolution);
+	a_star_path_planner.setSearchMode(astar_search_mode_);
+	cv::Mat downsampled_map;
+	a_star_path_planner.downsampleMap(floor_plan, downsampled_map, map_downsampling_factor_, robot_radius, map_resolution, map_context);
+	//whenever the trolley moves, the distances to the following rooms that still fit into its clique are computed with one wavefront
+	DistanceMatrix distance_matrix_computation;
+	std::vector<double> distances_to_trolley;
+	size_t first_room_of_trolley_position = 0;
+	bool trolley_moved = true;
+	for(size_t i=0; i<room_sequence.size(); ++i)
+	{
+		if (trolley_moved == true)
+		{
+			std::vector<cv::Point> following_rooms;
+			for (size_t j=i; j<std::min(room_sequence.size(), i+(size_t)std::max(0, max_clique_size_)); ++j)
+				following_rooms.push_back(room_centers[room_sequence[j]]);
+			distance_matrix_computation.computePathLengthsFromPoint(distances_to_trolley, floor_plan, downsampled_map, trolley_positions.back(),
+					following_rooms, map_downsampling_factor_, map_resolution, a_star_path_planner);
+			first_room_of_trolley_position = i;
+			trolley_moved = false;
+		}
+		const size_t room_of_trolley_position = i-first_room_of_trolley_position;
+		double distance_to_trolley = (room_of_trolley_position < distances_to_trolley.size() ? distances_to_trolley[room_of_trolley_position] : 1e100);
+		if (distance_to_trolley <= max_clique_path_length_/map_resolution && current_clique.size() < max_clique_size_) //expand current clique by next roomcenter
+		{
+			current_clique.push_back(room_sequence[i]);
+		}
+		else //start new clique and put the old clique into the cliques vector
+		{
+			cliques.push_back(current_clique);
+			current_clique.clear();
+			current_clique.push_back(room_sequence[i]);
+			trolley_positions.push_back(room_centers[room_sequence[i]]);
+			trolley_moved = true;
+		}
+	}
+	//add last clique
+	cliques.push_back(current_clique);
+}
+
+void RoomSequencePlanningServer::orderCliques(const std::vector<std::vector<int> >& cliques, const std::vector<cv::Point>& trolley_positions,
+		const std::vector<int>& trolley_sequence, const std::vector<std::vector<int> >& room_sequences,
+		std::vector<std::vector<int> >& ordered_cliques, std::vector<cv::Point>& ordered_trolley_positions)
+{
+	ordered_cliques.assign(cliques.size(), std::vector<int>());
+	ordered_trolley_positions.resize(trolley_positions.size());
+	for (size_t i=0; i<trolley_sequence.size(); ++i)
+	{
+		const int oi = trolley_sequence[i];
+		ordered_trolley_positions[i] = trolley_positions[oi];
+		ordered_cliques[i].resize(room_sequences[oi].size());
+		for (size_t j=0; j<room_sequences[oi].size(); ++j)
+			ordered_cliques[i][j] = cliques[oi][room_sequences[oi][j]];
+	}
+}
+
+void RoomSequencePlanningServer::convertToRoomSequences(const std::vector<std::vector<int> >& cliques, const std::vector<cv::Point>& trolley_positions,
+		const std::map<size_t, size_t>& mapping_room_centers_index_to_original_room_index, const double map_resolution,
+		const cv::Point2d& map_origin, std::vector<ipa_building_msgs::RoomSequence>& room_sequences)
+{
+	room_sequences.resize(cliques.size());
+	for(size_t i=0; i<cliques.size(); ++i)
+	{
+		//convert signed int to unsigned int (necessary for this msg type)
+		room_sequences[i].room_indices.resize(cliques[i].size());
+		for (size_t j=0; j<cliques[i].size(); ++j)
+			room_sequences[i].room_indices[j] = mapping_room_centers_index_to_original_room_index.at(cliques[i][j]);
+		room_sequences[i].checkpoint_position_in_pixel.x = trolley_positions[i].x;
+		room_sequences[i].checkpoint_position_in_pixel.y = trolley_positions[i].y;
+		room_sequences[i].checkpoint_position_in_pixel.z = 0.;
+		room_sequences[i].checkpoint_position_in_meter.x = convert_pixel_to_meter_for_x_coordinate(trolley_positions[i].x, map_resolution, map_origin);
+		room_sequences[i].checkpoint_position_in_meter.y = convert_pixel_to_meter_for_y_coordinate(trolley_positions[i].y, map_resolution, map_origin);
+		room_sequences[i].checkpoint_position_in_meter.z = 0.;
+	}
+}
+
+void RoomSequencePlanningServer::publishSequenceFeedback(const std::vector<std::vector<int> >& cliques, const std::vector<cv::Point>& trolley_positions,
+		const std::map<size_t, size_t>& mapping_room_centers_index_to_original_room_index, const double map_resolution,
+		const cv::Point2d& map_origin)
+{
+	ipa_building_msgs::FindRoomSequenceWithCheckpointsFeedback feedback;
+	convertToRoomSequences(cliques, trolley_positions, mapping_room_centers_index_to_original_room_index, map_resolution, map_origin, feedback.checkpoints);
+	room_sequence_with_checkpoints_server_.publishFeedback(feedback);
+}
+
+size_t RoomSequencePlanningServer::getNearestLocation(const cv::Mat& floor_plan, const cv::Point start_coordinate, const std::vector<cv::Point>& positions,
+		const double map_downsampling_factor, const double robot_radius, const double map_resolution, const MapContext* map_context)
+{
+	// the distances from start_coordinate to all positions are stored as a 1xN matrix in the distance matrix cache
+	DistanceMatrixCache& cache = DistanceMatrixCache::getInstance();
+	const bool use_cache = cache.isEnabled();
+	boost::uint64_t cache_key = 0;
+	cv::Mat distances;
+	if (use_cache == true)
+	{
+		std::vector<cv::Point> key_points(1, start_coordinate);
+		key_points.insert(key_points.end(), positions.begin(), positions.end());
+		const boost::uint64_t map_hash = ((map_context != NULL && map_context->isValidFor(floor_plan) == true) ? map_context->getMapHash() : DistanceMatrixCache::computeMapHash(floor_plan));
+		cache_key = DistanceMatrixCache::computeKey(map_hash, key_points, map_downsampling_factor, robot_radius, map_resolution, -1);
+	}
+	if (use_cache == false || cache.lookup(cache_key, distances) == false || distances.cols != (int)positions.size())
+	{
+		// one wavefront from start_coordinate to all positions
+		cv::Mat downsampled_map;
+		AStarPlanner a_star_path_planner;
+		a_star_path_planner.setSearchMode(astar_search_mode_);
+		a_star_path_planner.downsampleMap(floor_plan, downsampled_map, map_downsampling_factor, robot_radius, map_resolution, map_context);
+		std::vector<double> path_lengths;
+		DistanceMatrix distance_matrix_computation;
+		distance_matrix_computation.computePathLengthsFromPoint(path_lengths, floor_plan, downsampled_map, start_coordinate, positions,
+				map_downsampling_factor, map_resolution, a_star_path_planner);
+		distances.create(1, (int)positions.size(), CV_64F);
+		for (size_t i=0; i<positions.size(); ++i)
+			distances.at<double>(0, i) = path_lengths[i];
+		if (use_cache == true)
+			cache.store(cache_key, distances);
+	}
+
 	//find nearest trolley position as start point for TSP
 	double min_dist = 1e10;
 	size_t nearest_position = 0;
-//	const cv::Point start_point = map_downsampling_factor * start_coordinate;
 	for (size_t i=0; i<positions.size(); ++i)
 	{
-//		const cv::Point end_point = map_downsampling_factor * positions[i];
-		double dist = a_star_path_planner.planPath(floor_plan, downsampled_map, start_coordinate, positions[i], map_downsampling_factor, 0., map_resolution);
+		double dist = distances.at<double>(0, i);
 		if (dist < min_dist)
 		{
 			min_dist = dist;
@@ -0,0 +1,496 @@
+/*!
+ *****************************************************************
+ * \file
+ *
+ * \note
+ * Copyright (c) 2026 \n
+ * Fraunhofer Institute for Manufacturing Engineering
+ * and Automation (IPA) \n\n
+ *
+ *****************************************************************
+ *
+ * \note
+ * Project name: Care-O-bot
+ * \note
+ * ROS stack name: autopnp
+ * \note
+ * ROS package name: ipa_building_navigation
+ *
+ * \author
+ * Author: Richard Bormann
+ * \author
+ * Supervised by: Richard Bormann
+ *
+ * \date Date of creation: 10.2026
+ *
+ * \brief
+ *
+ *
+ *****************************************************************
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer. \n
+ * - Redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution. \n
+ * - Neither the name of the Fraunhofer Institute for Manufacturing
+ * Engineering and Automation (IPA) nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission. \n
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License LGPL as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License LGPL for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License LGPL along with this program.
+ * If not, see <http://www.gnu.org/licenses/>.
+ *
+ ****************************************************************/
+
+
+// Standalone benchmark of the distance matrix computation and the TSP solvers on synthetic floor plans.
+// It does not need a running ROS master. Usage:
+//   tsp_benchmark [--points=20,50,100] [--repetitions=5] [--map_size=600] [--rooms=4] [--seed=1] [--threads=0]
+//                 [--downsampling=0.25] [--robot_radius=0.3] [--resolution=0.05] [--reference_time=5] [--output=file.json]
+// For every number of points, repetitions random floor plans (a grid of rooms x rooms rooms connected by doors, with furniture)
+// and point sets are generated. Each stage is timed and the TSP tours are compared to a reference tour, which is computed by the
+// local search solver with a long time budget (reference_time). The reference is not a proven optimum, it is the same heuristic that
+// the concorde setting uses, so a tour quality of 1 only means that a solver matches it. The results (latency percentiles,
+// throughput, tour quality, peak RSS) are written as JSON.
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <map>
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+
+#include <sys/resource.h>
+
+#include <opencv2/opencv.hpp>
+#include <boost/shared_ptr.hpp>
+
+#include <ipa_building_navigation/timer.h>
+#include <ipa_building_navigation/tsp_solver_defines.h>
+#include <ipa_building_navigation/nearest_neighbor_TSP.h>
+#include <ipa_building_navigation/genetic_TSP.h>
+#include <ipa_building_navigation/concorde_TSP.h>
+#include <ipa_building_navigation/local_search_TSP.h>
+#include <ipa_building_navigation/distance_matrix.h>
+#include <ipa_building_navigation/distance_matrix_cache.h>
+#include <ipa_building_navigation/room_graph_planner.h>
+
+struct BenchmarkOptions
+{
+	std::vector<int> point_counts;
+	int repetitions;
+	int map_size;		// [pixel]
+	int rooms;			// rooms per row and column
+	int seed;
+	int threads;		// threads of the distance matrix computation, 0 = hardware threads
+	double downsampling_factor;
+	double robot_radius;	// [m]
+	double map_resolution;	// [m/pixel]
+	double reference_time;	// time budget of the local search that computes the reference tour [s]
+	std::string output;		// output file, empty = standard output
+
+	BenchmarkOptions()
+	: repetitions(5), map_size(600), rooms(4), seed(1), threads(0), downsampling_factor(0.25), robot_radius(0.3), map_resolution(0.05),
+	  reference_time(5.)
+	{
+		point_counts.push_back(20);
+		point_counts.push_back(50);
+		point_counts.push_back(100);
+	}
+};
+
+// timings and tour qualities of one stage for one number of points
+struct StageStatistics
+{
+	std::vector<double> latencies;	// [ms]
+	std::vector<double> qualities;	// tour length / reference tour length, the reference is a long local search run, not the optimum
+};
+
+bool parseArguments(int argc, char** argv, BenchmarkOptions& options)
+{
+	for (int i=1; i<argc; ++i)
+	{
+		const std::string argument(argv[i]);
+		const size_t separator = argument.find('=');
+		if (argument.compare(0, 2, "--") != 0 || separator == std::string::npos)
+		{
+			std::cout << "Invalid argument '" << argument << "', expected --name=value." << std::endl;
+			return false;
+		}
+		const std::string name = argument.substr(2, separator-2);
+		const std::string value = argument.substr(separator+1);
+		if (name == "points")
+		{
+			options.point_counts.clear();
+			std::stringstream ss(value);
+			std::string item;
+			while (std::getline(ss, item, ','))
+				options.point_counts.push_back(atoi(item.c_str()));
+		}
+		else if (name == "repetitions")
+			options.repetitions = std::max(1, atoi(value.c_str()));
+		else if (name == "map_size")
+			options.map_size = std::max(100, atoi(value.c_str()));
+		else if (name == "rooms")
+			options.rooms = std::max(1, atoi(value.c_str()));
+		else if (name == "seed")
+			options.seed = atoi(value.c_str());
+		else if (name == "threads")
+			options.threads = atoi(value.c_str());
+		else if (name == "downsampling")
+			options.downsampling_factor = atof(value.c_str());
+		else if (name == "robot_radius")
+			options.robot_radius = atof(value.c_str());
+		else if (name == "resolution")
+			options.map_resolution = atof(value.c_str());
+		else if (name == "reference_time")
+			options.reference_time = atof(value.c_str());
+		else if (name == "output")
+			options.output = value;
+		else
+		{
+			std::cout << "Unknown argument '" << name << "'." << std::endl;
+			return false;
+		}
+	}
+	return true;
+}
+
+// generates a floor plan with a grid of rooms that are connected by doors (a random spanning tree of doors plus some additional
+// doors) and contain some furniture, segmented_map receives the room labels 1..N (walls = 0)
+void generateFloorPlan(const BenchmarkOptions& options, cv::RNG& rng, cv::Mat& map, cv::Mat& segmented_map)
+{
+	const int size = options.map_size;
+	const int rooms = options.rooms;
+	const int wall = 3;
+	const int door_width = std::max(4, (int)(1.0/options.map_resolution));
+	map = cv::Mat(size, size, CV_8UC1, cv::Scalar(0));
+	segmented_map = cv::Mat(size, size, CV_32SC1, cv::Scalar(0));
+
+	// rooms
+	std::vector<int> borders(rooms+1);
+	for (int k=0; k<=rooms; ++k)
+		borders[k] = k*(size-1)/rooms;
+	for (int r=0; r<rooms; ++r)
+	{
+		for (int c=0; c<rooms; ++c)
+		{
+			const cv::Rect room(borders[c]+wall, borders[r]+wall, borders[c+1]-borders[c]-wall, borders[r+1]-borders[r]-wall);
+			map(room).setTo(cv::Scalar(255));
+			segmented_map(room).setTo(cv::Scalar(r*rooms+c+1));
+		}
+	}
+
+	// doors: random spanning tree over the room grid and 30% of the remaining walls
+	std::vector<bool> connected(rooms*rooms, false);
+	std::vector<int> stack(1, 0);
+	connected[0] = true;
+	std::map<std::pair<int,int>, bool> doors;
+	while (stack.empty() == false)
+	{
+		const int room = stack.back();
+		std::vector<int> candidates;
+		const int r = room/rooms, c = room%rooms;
+		if (r > 0 && connected[room-rooms] == false) candidates.push_back(room-rooms);
+		if (r < rooms-1 && connected[room+rooms] == false) candidates.push_back(room+rooms);
+		if (c > 0 && connected[room-1] == false) candidates.push_back(room-1);
+		if (c < rooms-1 && connected[room+1] == false) candidates.push_back(room+1);
+		if (candidates.empty() == true)
+		{
+			stack.pop_back();
+			continue;
+		}
+		const int next = candidates[rng.uniform(0, (int)candidates.size())];
+		connected[next] = true;
+		doors[std::pair<int,int>(std::min(room, next), std::max(room, next))] = true;
+		stack.push_back(next);
+	}
+	for (int room=0; room<rooms*rooms; ++room)
+	{
+		if (room%rooms < rooms-1 && rng.uniform(0., 1.) < 0.3)
+			doors[std::pair<int,int>(room, room+1)] = true;
+		if (room/rooms < rooms-1 && rng.uniform(0., 1.) < 0.3)
+			doors[std::pair<int,int>(room, room+rooms)] = true;
+	}
+	for (std::map<std::pair<int,int>, bool>::iterator door=doors.begin(); door!=doors.end(); ++door)
+	{
+		const int a = door->first.first, b = door->first.second;
+		const int r = a/rooms, c = a%rooms;
+		if (b == a+1)
+		{
+			// vertical wall between columns c and c+1
+			const int length = borders[r+1]-borders[r]-wall;
+			const int start = borders[r] + wall + rng.uniform(0, std::max(1, length-door_width));
+			const cv::Rect opening(borders[c+1], start, wall, std::min(door_width, length));
+			map(opening).setTo(cv::Scalar(255));
+			segmented_map(opening).setTo(cv::Scalar(a+1));
+		}
+		else
+		{
+			// horizontal wall between rows r and r+1
+			const int length = borders[c+1]-borders[c]-wall;
+			const int start = borders[c] + wall + rng.uniform(0, std::max(1, length-door_width));
+			const cv::Rect opening(start, borders[r+1], std::min(door_width, length), wall);
+			map(opening).setTo(cv::Scalar(255));
+			segmented_map(opening).setTo(cv::Scalar(a+1));
+		}
+	}
+
+	// furniture, kept away from the walls so that the doors stay passable
+	const int margin = door_width + wall;
+	for (int r=0; r<rooms; ++r)
+	{
+		for (int c=0; c<rooms; ++c)
+		{
+			const int width = borders[c+1]-borders[c]-2*margin;
+			const int height = borders[r+1]-borders[r]-2*margin;
+			if (width < 10 || height < 10)
+				continue;
+			for (int k=0; k<3; ++k)
+			{
+				const int w = rng.uniform(3, std::max(4, width/4));
+				const int h = rng.uniform(3, std::max(4, height/4));
+				const cv::Rect object(borders[c]+margin+rng.uniform(0, width-w), borders[r]+margin+rng.uniform(0, height-h), w, h);
+				map(object).setTo(cv::Scalar(0));
+				segmented_map(object).setTo(cv::Scalar(0));
+			}
+		}
+	}
+}
+
+// samples points on cells that the robot can reach with its footprint, all points are connected to each other on the downsampled
+// map of the path planners (furniture may enclose small areas), so that the benchmark does not measure the fallback to the original map
+void samplePoints(const cv::Mat& map, const BenchmarkOptions& options, const int number_points, cv::RNG& rng, std::vector<cv::Point>& points)
+{
+	AStarPlanner path_planner;
+	cv::Mat downsampled_map;
+	path_planner.downsampleMap(map, downsampled_map, options.downsampling_factor, options.robot_radius, options.map_resolution);
+
+	// collect the free cells connected to a random free seed cell
+	cv::Point seed;
+	do
+		seed = cv::Point(rng.uniform(0, downsampled_map.cols), rng.uniform(0, downsampled_map.rows));
+	while (downsampled_map.at<unsigned char>(seed) != 255);
+	std::vector<cv::Point> connected_cells(1, seed);
+	downsampled_map.at<unsigned char>(seed) = 128;
+	for (size_t i=0; i<connected_cells.size(); ++i)
+	{
+		const cv::Point cell = connected_cells[i];
+		for (int dy=-1; dy<=1; ++dy)
+		{
+			for (int dx=-1; dx<=1; ++dx)
+			{
+				const cv::Point neighbor(cell.x+dx, cell.y+dy);
+				if (neighbor.x>=0 && neighbor.y>=0 && neighbor.x<downsampled_map.cols && neighbor.y<downsampled_map.rows
+						&& downsampled_map.at<unsigned char>(neighbor)==255)
+				{
+					downsampled_map.at<unsigned char>(neighbor) = 128;
+					connected_cells.push_back(neighbor);
+				}
+			}
+		}
+	}
+
+	// map the cells back to free cells of the original map
+	points.clear();
+	while ((int)points.size() < number_points)
+	{
+		const cv::Point cell = connected_cells[rng.uniform(0, (int)connected_cells.size())];
+		const cv::Point point((int)((cell.x+0.5)/options.downsampling_factor), (int)((cell.y+0.5)/options.downsampling_factor));
+		if (point.x < map.cols && point.y < map.rows && map.at<unsigned char>(point) == 255)
+			points.push_back(point);
+	}
+}
+
+double getTourLength(const cv::Mat& distance_matrix, const std::vector<int>& order)
+{
+	double length = 0.;
+	for (size_t i=0; i<order.size(); ++i)
+		length += distance_matrix.at<double>(order[i], order[(i+1)%order.size()]);
+	return length;
+}
+
+// nearest rank percentile of sorted values
+double getPercentile(const std::vector<double>& sorted_values, const double percentile)
+{
+	if (sorted_values.size() == 0)
+		return 0.;
+	const int rank = (int)std::ceil(percentile/100.*sorted_values.size());
+	return sorted_values[std::max(0, std::min((int)sorted_values.size()-1, rank-1))];
+}
+
+void writeStatistics(std::ostream& out, const std::string& name, const StageStatistics& statistics, const bool last)
+{
+	std::vector<double> latencies = statistics.latencies;
+	std::sort(latencies.begin(), latencies.end());
+	double sum = 0.;
+	for (size_t i=0; i<latencies.size(); ++i)
+		sum += latencies[i];
+	const double mean = (latencies.size() > 0 ? sum/latencies.size() : 0.);
+	out << "        \"" << name << "\": {\"count\": " << latencies.size() << ", \"latency_ms\": {\"mean\": " << mean
+			<< ", \"p50\": " << getPercentile(latencies, 50.) << ", \"p90\": " << getPercentile(latencies, 90.)
+			<< ", \"p99\": " << getPercentile(latencies, 99.) << ", \"max\": " << (latencies.size() > 0 ? latencies.back() : 0.)
+			<< "}, \"throughput_per_s\": " << (mean > 0. ? 1000./mean : 0.);
+	if (statistics.qualities.size() > 0)
+	{
+		double quality_sum = 0., quality_max = 0.;
+		for (size_t i=0; i<statistics.qualities.size(); ++i)
+		{
+			quality_sum += statistics.qualities[i];
+			quality_max = std::max(quality_max, statistics.qualities[i]);
+		}
+		out << ", \"tour_quality\": {\"mean\": " << quality_sum/statistics.qualities.size() << ", \"max\": " << quality_max << "}";
+	}
+	out << "}" << (last ? "" : ",") << std::endl;
+}
+
+int main(int argc, char **argv)
+{
+	BenchmarkOptions options;
+	if (parseArguments(argc, argv, options) == false)
+		return 1;
+
+	// every stage has to compute its result
+	DistanceMatrixCache::getInstance().configure(0, "");
+	DistanceMatrixCache::getInstance().clear();
+
+	cv::RNG rng(options.seed);
+	std::vector<std::map<std::string, StageStatistics> > results(options.point_counts.size());
+	for (size_t p=0; p<options.point_counts.size(); ++p)
+	{
+		const int number_points = options.point_counts[p];
+		std::map<std::string, StageStatistics>& stages = results[p];
+		for (int repetition=0; repetition<options.repetitions; ++repetition)
+		{
+			std::cout << "tsp_benchmark: " << number_points << " points, repetition " << repetition+1 << "/" << options.repetitions << std::endl;
+			cv::Mat map, segmented_map;
+			generateFloorPlan(options, rng, map, segmented_map);
+			std::vector<cv::Point> points;
+			samplePoints(map, options, number_points, rng, points);
+
+			// distance matrices
+			AStarPlanner path_planner;
+			cv::Mat distance_matrix;
+			{
+				DistanceMatrix distance_matrix_computation;
+				distance_matrix_computation.setNumberOfThreads(options.threads);
+				distance_matrix_computation.setBackend(DISTANCE_MATRIX_ASTAR);
+				Timer tim;
+				distance_matrix_computation.constructDistanceMatrix(distance_matrix, map, points, options.downsampling_factor,
+						options.robot_radius, options.map_resolution, path_planner);
+				stages["distance_matrix_astar"].latencies.push_back(tim.getElapsedTimeInMilliSec());
+			}
+			{
+				DistanceMatrix distance_matrix_computation;
+				distance_matrix_computation.setNumberOfThreads(options.threads);
+				distance_matrix_computation.setBackend(DISTANCE_MATRIX_WAVEFRONT);
+				cv::Mat wavefront_distance_matrix;
+				Timer tim;
+				distance_matrix_computation.constructDistanceMatrix(wavefront_distance_matrix, map, points, options.downsampling_factor,
+						options.robot_radius, options.map_resolution, path_planner);
+				stages["distance_matrix_wavefront"].latencies.push_back(tim.getElapsedTimeInMilliSec());
+			}
+			{
+				Timer tim;
+				boost::shared_ptr<RoomGraphPlanner> room_graph(new RoomGraphPlanner());
+				room_graph->buildGraph(map, segmented_map, options.downsampling_factor, options.robot_radius, options.map_resolution);
+				stages["room_graph_build"].latencies.push_back(tim.getElapsedTimeInMilliSec());
+				DistanceMatrix distance_matrix_computation;
+				distance_matrix_computation.setBackend(DISTANCE_MATRIX_ROOM_GRAPH);
+				distance_matrix_computation.setRoomGraph(room_graph);
+				cv::Mat room_graph_distance_matrix;
+				tim.start();
+				distance_matrix_computation.constructDistanceMatrix(room_graph_distance_matrix, map, points, options.downsampling_factor,
+						options.robot_radius, options.map_resolution, path_planner);
+				stages["distance_matrix_room_graph"].latencies.push_back(tim.getElapsedTimeInMilliSec());
+			}
+
+			// reference tour: the local search of the concorde setting with a longer time budget, not an optimal tour
+			LocalSearchTSPSolver reference_solver;
+			reference_solver.setTimeBudget(options.reference_time);
+			reference_solver.setMaxKicksPerNode(1000);
+			std::vector<int> reference_order = reference_solver.solveLocalSearchTSP(distance_matrix, 0);
+			const double reference_length = getTourLength(distance_matrix, reference_order);
+
+			// TSP solvers on the A* distance matrix
+			{
+				NearestNeighborTSPSolver solver;
+				Timer tim;
+				std::vector<int> order = solver.solveNearestTSP(distance_matrix, 0);
+				stages["tsp_nearest_neighbor"].latencies.push_back(tim.getElapsedTimeInMilliSec());
+				stages["tsp_nearest_neighbor"].qualities.push_back(getTourLength(distance_matrix, order)/reference_length);
+			}
+			{
+				GeneticTSPSolver solver;
+				Timer tim;
+				std::vector<int> order = solver.solveGeneticTSP(distance_matrix, 0);
+				stages["tsp_genetic"].latencies.push_back(tim.getElapsedTimeInMilliSec());
+				stages["tsp_genetic"].qualities.push_back(getTourLength(distance_matrix, order)/reference_length);
+			}
+			{
+				ConcordeTSPSolver solver;
+				Timer tim;
+				std::vector<int> order = solver.solveConcordeTSP(distance_matrix, 0);
+				stages["tsp_concorde"].latencies.push_back(tim.getElapsedTimeInMilliSec());
+				stages["tsp_concorde"].qualities.push_back(getTourLength(distance_matrix, order)/reference_length);
+			}
+		}
+	}
+
+	// peak resident set size in [kB] (Linux reports ru_maxrss in kB)
+	struct rusage usage;
+	getrusage(RUSAGE_SELF, &usage);
+
+	// write the results as JSON
+	std::ofstream file;
+	if (options.output.empty() == false)
+	{
+		file.open(options.output.c_str());
+		if (file.is_open() == false)
+		{
+			std::cout << "Output file '" << options.output << "' could not be opened." << std::endl;
+			return 1;
+		}
+	}
+	std::ostream& out = (options.output.empty() ? std::cout : file);
+	out << std::setprecision(10);
+	out << "{" << std::endl
+		<< "  \"benchmark\": \"ipa_building_navigation/tsp_benchmark\"," << std::endl
+		<< "  \"options\": {\"repetitions\": " << options.repetitions << ", \"map_size\": " << options.map_size << ", \"rooms\": " << options.rooms
+		<< ", \"seed\": " << options.seed << ", \"threads\": " << options.threads << ", \"downsampling\": " << options.downsampling_factor
+		<< ", \"robot_radius\": " << options.robot_radius << ", \"resolution\": " << options.map_resolution
+		<< ", \"reference_time\": " << options.reference_time << "}," << std::endl
+		<< "  \"results\": [" << std::endl;
+	for (size_t p=0; p<results.size(); ++p)
+	{
+		out << "    {\"points\": " << options.point_counts[p] << ", \"stages\": {" << std::endl;
+		size_t stage_index = 0;
+		for (std::map<std::string, StageStatistics>::const_iterator stage=results[p].begin(); stage!=results[p].end(); ++stage, ++stage_index)
+			writeStatistics(out, stage->first, stage->second, stage_index+1 == results[p].size());
+		out << "    }}" << (p+1 < results.size() ? "," : "") << std::endl;
+	}
+	out << "  ]," << std::endl
+		<< "  \"peak_rss_kb\": " << usage.ru_maxrss << std::endl
+		<< "}" << std::endl;
+
+	return 0;
+}
@@ -0,0 +1,188 @@
+/*!
+ *****************************************************************
+ * \file
+ *
+ * \note
+ * Copyright (c) 2026 \n
+ * Fraunhofer Institute for Manufacturing Engineering
+ * and Automation (IPA) \n\n
+ *
+ *****************************************************************
+ *
+ * \note
+ * Project name: Care-O-bot
+ * \note
+ * ROS stack name: autopnp
+ * \note
+ * ROS package name: ipa_building_navigation
+ *
+ * \author
+ * Author: Richard Bormann
+ * \author
+ * Supervised by: Richard Bormann
+ *
+ * \date Date of creation: 10.2026
+ *
+ * \brief
+ *
+ *
+ *****************************************************************
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer. \n
+ * - Redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution. \n
+ * - Neither the name of the Fraunhofer Institute for Manufacturing
+ * Engineering and Automation (IPA) nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission. \n
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License LGPL as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License LGPL for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License LGPL along with this program.
+ * If not, see <http://www.gnu.org/licenses/>.
+ *
+ ****************************************************************/
+
+#include <gtest/gtest.h>
+
+#include <vector>
+#include <boost/thread.hpp>
+#include <boost/bind.hpp>
+
+#include <ipa_building_navigation/A_star_pathplanner.h>
+
+#include "path_planning_test_maps.h"
+
+// The A* search core of AStarPlanner has to find shortest paths with the step costs 10 (straight) and 14 (diagonal), the
+// returned route has to be connected and the path length has to be the length of this route. These properties are checked
+// against a Dijkstra search on several synthetic maps.
+
+// plans between all pairs of cells with one planner object and compares the results with the reference search
+static void checkShortestPaths(AStarPlanner& planner, const cv::Mat& map, const std::vector<cv::Point>& cells)
+{
+	for (size_t i=0; i<cells.size(); ++i)
+	{
+		for (size_t j=i+1; j<cells.size(); ++j)
+		{
+			std::vector<cv::Point> route;
+			const double length = planner.planPath(map, cells[i], cells[j], 1., 0., 0.05, 0, &route);
+			const int reference_cost = computeReferenceCost(map, cells[i], cells[j]);
+			if (cells[i] == cells[j])
+			{
+				EXPECT_EQ(0., length);
+				continue;
+			}
+			if (reference_cost < 0)
+			{
+				EXPECT_GT(length, 1e90) << "path from " << cells[i] << " to " << cells[j] << " should not exist";
+				continue;
+			}
+			int cost = 0;
+			double route_length = 0.;
+			ASSERT_TRUE(evaluateRoute(map, route, cells[i], cells[j], cost, route_length)) << "invalid route from " << cells[i] << " to " << cells[j];
+			EXPECT_EQ(reference_cost, cost) << "path from " << cells[i] << " to " << cells[j] << " is not the shortest";
+			EXPECT_NEAR(route_length, length, 1e-9);
+		}
+	}
+}
+
+TEST(AStarPlannerTest, emptyMapHasOctileLengths)
+{
+	const cv::Mat map = createEmptyMap(50, 30);
+	AStarPlanner planner;
+	EXPECT_NEAR(47., planner.planPath(map, cv::Point(1, 5), cv::Point(48, 5), 1., 0., 0.05), 1e-9);
+	EXPECT_NEAR(20.*std::sqrt(2.), planner.planPath(map, cv::Point(2, 2), cv::Point(22, 22), 1., 0., 0.05), 1e-9);
+	EXPECT_NEAR(30. + 10.*std::sqrt(2.), planner.planPath(map, cv::Point(45, 25), cv::Point(5, 15), 1., 0., 0.05), 1e-9);
+	EXPECT_EQ(0., planner.planPath(map, cv::Point(7, 7), cv::Point(7, 7), 1., 0., 0.05));
+}
+
+TEST(AStarPlannerTest, invalidAndUnreachablePoints)
+{
+	const cv::Mat map = createOfficeMap();
+	AStarPlanner planner;
+	// outside of the map
+	EXPECT_GT(planner.planPath(map, cv::Point(5, 5), cv::Point(200, 5), 1., 0., 0.05), 1e90);
+	EXPECT_GT(planner.planPath(map, cv::Point(-1, 5), cv::Point(5, 5), 1., 0., 0.05), 1e90);
+	// the closed room in the lower right corner
+	EXPECT_GT(planner.planPath(map, cv::Point(5, 30), cv::Point(150, 50), 1., 0., 0.05), 1e90);
+	// the search context is reused after the failed searches
+	EXPECT_NEAR(10., planner.planPath(map, cv::Point(5, 30), cv::Point(15, 30), 1., 0., 0.05), 1e-9);
+}
+
+TEST(AStarPlannerTest, shortestPathsOnOfficeMap)
+{
+	const cv::Mat map = createOfficeMap();
+	AStarPlanner planner;
+	checkShortestPaths(planner, map, sampleAccessibleCells(map, 25, 1));
+}
+
+TEST(AStarPlannerTest, shortestPathsOnRandomObstacleMaps)
+{
+	// one planner for maps of different sizes, so that the search context is resized between the queries
+	AStarPlanner planner;
+	for (int seed=1; seed<=4; ++seed)
+	{
+		const cv::Mat map = createRandomObstacleMap(40+20*seed, 70-10*seed, 0.1*seed, seed);
+		checkShortestPaths(planner, map, sampleAccessibleCells(map, 15, seed));
+	}
+}
+
+TEST(AStarPlannerTest, repeatedQueriesGiveTheSameResults)
+{
+	const cv::Mat map = createRandomObstacleMap(80, 60, 0.25, 5);
+	const std::vector<cv::Point> cells = sampleAccessibleCells(map, 20, 5);
+	AStarPlanner reused_planner;
+	for (size_t i=0; i+1<cells.size(); ++i)
+	{
+		AStarPlanner new_planner;
+		const double expected_length = new_planner.planPath(map, cells[i], cells[i+1], 1., 0., 0.05);
+		for (int repetition=0; repetition<3; ++repetition)
+			EXPECT_EQ(expected_length, reused_planner.planPath(map, cells[i], cells[i+1], 1., 0., 0.05));
+	}
+}
+
+// plans the paths from cells[0] to all other cells and writes the lengths into lengths
+static void planFromFirstCell(const cv::Mat* map, const std::vector<cv::Point>* cells, std::vector<double>* lengths)
+{
+	AStarPlanner planner;
+	lengths->resize(cells->size());
+	for (size_t i=0; i<cells->size(); ++i)
+		(*lengths)[i] = planner.planPath(*map, (*cells)[0], (*cells)[i], 1., 0., 0.05);
+}
+
+TEST(AStarPlannerTest, oneObjectPerThread)
+{
+	const cv::Mat map = createRandomObstacleMap(120, 90, 0.2, 6);
+	const std::vector<cv::Point> cells = sampleAccessibleCells(map, 40, 6);
+	std::vector<double> expected_lengths;
+	planFromFirstCell(&map, &cells, &expected_lengths);
+
+	const int number_threads = 4;
+	std::vector<std::vector<double> > lengths(number_threads);
+	boost::thread_group threads;
+	for (int t=0; t<number_threads; ++t)
+		threads.create_thread(boost::bind(&planFromFirstCell, &map, &cells, &lengths[t]));
+	threads.join_all();
+	for (int t=0; t<number_threads; ++t)
+		EXPECT_EQ(expected_lengths, lengths[t]);
+}
+
+int main(int argc, char** argv)
+{
+	testing::InitGoogleTest(&argc, argv);
+	return RUN_ALL_TESTS();
+}
@@ -0,0 +1,250 @@
+/*!
+ *****************************************************************
+ * \file
+ *
+ * \note
+ * Copyright (c) 2026 \n
+ * Fraunhofer Institute for Manufacturing Engineering
+ * and Automation (IPA) \n\n
+ *
+ *****************************************************************
+ *
+ * \note
+ * Project name: Care-O-bot
+ * \note
+ * ROS stack name: autopnp
+ * \note
+ * ROS package name: ipa_building_navigation
+ *
+ * \author
+ * Author: Richard Bormann
+ * \author
+ * Supervised by: Richard Bormann
+ *
+ * \date Date of creation: 10.2026
+ *
+ * \brief
+ *
+ *
+ *****************************************************************
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer. \n
+ * - Redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution. \n
+ * - Neither the name of the Fraunhofer Institute for Manufacturing
+ * Engineering and Automation (IPA) nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission. \n
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License LGPL as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License LGPL for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License LGPL along with this program.
+ * If not, see <http://www.gnu.org/licenses/>.
+ *
+ ****************************************************************/
+
+#include <gtest/gtest.h>
+
+#include <vector>
+#include <map>
+
+#include <opencv2/opencv.hpp>
+
+#include <ipa_building_navigation/distance_matrix.h>
+
+// DistanceMatrix::cleanDistanceMatrix keeps the largest connected component of the finite path lengths and then removes the
+// remaining infinite entries one at a time. It has to give the same result as the former implementation, which repeatedly
+// recounted all infinite entries and removed the row with the most of them (the highest index on equal counts).
+
+static const double infinite_length = 1e100;
+
+// the former implementation of DistanceMatrix::cleanDistanceMatrix (without output), it needs O(N^3) time
+static void cleanDistanceMatrixBaseline(const cv::Mat& distance_matrix, cv::Mat& distance_matrix_cleaned, std::map<int,int>& cleaned_index_to_original_index_mapping)
+{
+	cleaned_index_to_original_index_mapping.clear();
+	for (int i=0; i<distance_matrix.rows; ++i)
+		cleaned_index_to_original_index_mapping[i] = i;
+	distance_matrix_cleaned = distance_matrix.clone();
+	if (distance_matrix.rows < 1)
+		return;
+
+	const double max_length = 1e90;
+	std::vector<bool> remove_entry(distance_matrix.rows, false);
+	cv::Mat distance_matrix_temp = distance_matrix.clone();
+	while (true)
+	{
+		std::vector<int> infinite_length_entries(distance_matrix_temp.rows, 0);
+		for (int i=0; i<distance_matrix_temp.rows; ++i)
+			for (int j=0; j<distance_matrix_temp.cols; ++j)
+				if (distance_matrix_temp.at<double>(i,j)>max_length)
+					infinite_length_entries[i]++;
+		std::multimap<int, int> number_infinite_entries_to_row_index_mapping;
+		for (size_t i=0; i<infinite_length_entries.size(); ++i)
+			number_infinite_entries_to_row_index_mapping.insert(std::pair<int,int>(infinite_length_entries[i], (int)i));
+		if (number_infinite_entries_to_row_index_mapping.rbegin()->first == 0)
+			break;
+		const int mark_index = number_infinite_entries_to_row_index_mapping.rbegin()->second;
+		remove_entry[mark_index] = true;
+		for (int j=0; j<distance_matrix_temp.cols; ++j)
+			distance_matrix_temp.at<double>(mark_index, j) = -1.;
+		for (int i=0; i<distance_matrix_temp.rows; ++i)
+			distance_matrix_temp.at<double>(i, mark_index) = -1.;
+	}
+
+	int new_size = 0;
+	for (size_t i=0; i<remove_entry.size(); ++i)
+		if (remove_entry[i] == false)
+			new_size++;
+	if (new_size == distance_matrix.rows || new_size == 0)
+		return;
+	distance_matrix_cleaned.create(new_size, new_size, CV_64F);
+	cleaned_index_to_original_index_mapping.clear();
+	int new_index = 0;
+	for (size_t i=0; i<remove_entry.size(); ++i)
+	{
+		if (remove_entry[i] == true)
+			continue;
+		cleaned_index_to_original_index_mapping[new_index] = (int)i;
+		int new_j = 0;
+		for (size_t j=0; j<remove_entry.size(); ++j)
+		{
+			if (remove_entry[j] == false)
+			{
+				distance_matrix_cleaned.at<double>(new_index, new_j) = distance_matrix.at<double>(i,j);
+				new_j++;
+			}
+		}
+		new_index++;
+	}
+}
+
+// symmetric matrix with zero diagonal, each pair of points is unreachable with probability infinite_ratio
+static cv::Mat createRandomDistanceMatrix(const int size, const double infinite_ratio, cv::RNG& rng)
+{
+	cv::Mat distance_matrix(size, size, CV_64F, cv::Scalar(0.));
+	for (int i=0; i<size; ++i)
+		for (int j=i+1; j<size; ++j)
+			distance_matrix.at<double>(i, j) = distance_matrix.at<double>(j, i) = (rng.uniform(0., 1.) < infinite_ratio ? infinite_length : rng.uniform(1., 100.));
+	return distance_matrix;
+}
+
+// symmetric matrix of points in number_blocks separate areas, the points of different areas are unreachable from each other and
+// within an area a path is missing with probability missing_path_ratio (e.g. not found on the downsampled map)
+static cv::Mat createBlockDistanceMatrix(const int size, const int number_blocks, const double missing_path_ratio, cv::RNG& rng)
+{
+	std::vector<int> block(size);
+	for (int i=0; i<size; ++i)
+		block[i] = rng.uniform(0, number_blocks);
+	cv::Mat distance_matrix(size, size, CV_64F, cv::Scalar(0.));
+	for (int i=0; i<size; ++i)
+		for (int j=i+1; j<size; ++j)
+			distance_matrix.at<double>(i, j) = distance_matrix.at<double>(j, i) =
+					(block[i] != block[j] || rng.uniform(0., 1.) < missing_path_ratio ? infinite_length : rng.uniform(1., 100.));
+	return distance_matrix;
+}
+
+// cleans distance_matrix with both implementations and compares the cleaned matrices and the index mappings
+static void compareWithBaseline(const cv::Mat& distance_matrix)
+{
+	cv::Mat expected_cleaned;
+	std::map<int,int> expected_mapping;
+	cleanDistanceMatrixBaseline(distance_matrix, expected_cleaned, expected_mapping);
+
+	DistanceMatrix distance_matrix_utils;
+	cv::Mat cleaned;
+	std::vector<int> mapping;
+	distance_matrix_utils.cleanDistanceMatrix(distance_matrix, cleaned, mapping);
+
+	ASSERT_EQ(expected_mapping.size(), mapping.size());
+	for (size_t i=0; i<mapping.size(); ++i)
+		EXPECT_EQ(expected_mapping[(int)i], mapping[i]) << "cleaned index " << i;
+	ASSERT_EQ(expected_cleaned.rows, cleaned.rows);
+	ASSERT_EQ(expected_cleaned.cols, cleaned.cols);
+	for (int i=0; i<cleaned.rows; ++i)
+		for (int j=0; j<cleaned.cols; ++j)
+			EXPECT_EQ(expected_cleaned.at<double>(i, j), cleaned.at<double>(i, j));
+
+	// the version with the former std::map mapping
+	cv::Mat map_cleaned;
+	std::map<int,int> map_mapping;
+	map_mapping[42] = 42;	// has to be cleared
+	distance_matrix_utils.cleanDistanceMatrix(distance_matrix, map_cleaned, map_mapping);
+	EXPECT_EQ(expected_mapping, map_mapping);
+	EXPECT_EQ(cleaned.rows, map_cleaned.rows);
+}
+
+TEST(CleanDistanceMatrixTest, emptyMatrix)
+{
+	compareWithBaseline(cv::Mat(0, 0, CV_64F));
+}
+
+TEST(CleanDistanceMatrixTest, finiteMatrixIsKept)
+{
+	cv::RNG rng(1);
+	const cv::Mat distance_matrix = createRandomDistanceMatrix(20, 0., rng);
+	DistanceMatrix distance_matrix_utils;
+	cv::Mat cleaned;
+	std::vector<int> mapping;
+	distance_matrix_utils.cleanDistanceMatrix(distance_matrix, cleaned, mapping);
+	ASSERT_EQ(20u, mapping.size());
+	for (size_t i=0; i<mapping.size(); ++i)
+		EXPECT_EQ((int)i, mapping[i]);
+	EXPECT_EQ(0, cv::countNonZero(cleaned != distance_matrix));
+	compareWithBaseline(distance_matrix);
+}
+
+TEST(CleanDistanceMatrixTest, allPointsUnreachable)
+{
+	// only one point is kept if no pair of points is connected
+	cv::RNG rng(2);
+	compareWithBaseline(createRandomDistanceMatrix(15, 1., rng));
+
+	// the matrix is kept unchanged if every point would have to be removed
+	const cv::Mat distance_matrix(15, 15, CV_64F, cv::Scalar(infinite_length));
+	compareWithBaseline(distance_matrix);
+	DistanceMatrix distance_matrix_utils;
+	cv::Mat cleaned;
+	std::vector<int> mapping;
+	distance_matrix_utils.cleanDistanceMatrix(distance_matrix, cleaned, mapping);
+	EXPECT_EQ(15u, mapping.size());
+	EXPECT_EQ(15, cleaned.rows);
+}
+
+TEST(CleanDistanceMatrixTest, randomMatrices)
+{
+	cv::RNG rng(3);
+	const double infinite_ratios[5] = {0.02, 0.1, 0.3, 0.6, 0.9};
+	for (int size=1; size<=40; size+=3)
+		for (int r=0; r<5; ++r)
+			compareWithBaseline(createRandomDistanceMatrix(size, infinite_ratios[r], rng));
+}
+
+TEST(CleanDistanceMatrixTest, blockMatrices)
+{
+	cv::RNG rng(4);
+	const double missing_path_ratios[3] = {0., 0.05, 0.3};
+	for (int size=2; size<=50; size+=4)
+		for (int number_blocks=1; number_blocks<=4; ++number_blocks)
+			for (int r=0; r<3; ++r)
+				compareWithBaseline(createBlockDistanceMatrix(size, number_blocks, missing_path_ratios[r], rng));
+}
+
+int main(int argc, char** argv)
+{
+	testing::InitGoogleTest(&argc, argv);
+	return RUN_ALL_TESTS();
+}
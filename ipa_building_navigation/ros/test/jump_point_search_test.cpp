@@ -0,0 +1,189 @@
+/*!
+ *****************************************************************
+ * \file
+ *
+ * \note
+ * Copyright (c) 2026 \n
+ * Fraunhofer Institute for Manufacturing Engineering
+ * and Automation (IPA) \n\n
+ *
+ *****************************************************************
+ *
+ * \note
+ * Project name: Care-O-bot
+ * \note
+ * ROS stack name: autopnp
+ * \note
+ * ROS package name: ipa_building_navigation
+ *
+ * \author
+ * Author: Richard Bormann
+ * \author
+ * Supervised by: Richard Bormann
+ *
+ * \date Date of creation: 10.2026
+ *
+ * \brief
+ *
+ *
+ *****************************************************************
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer. \n
+ * - Redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution. \n
+ * - Neither the name of the Fraunhofer Institute for Manufacturing
+ * Engineering and Automation (IPA) nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission. \n
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License LGPL as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License LGPL for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License LGPL along with this program.
+ * If not, see <http://www.gnu.org/licenses/>.
+ *
+ ****************************************************************/
+
+#include <gtest/gtest.h>
+
+#include <vector>
+
+#include <ipa_building_navigation/A_star_pathplanner.h>
+
+#include "path_planning_test_maps.h"
+
+// Jump Point Search has to return paths of the same (minimal) cost as the standard A* search, only the expanded nodes differ.
+// Paths of equal cost may still differ in their lengths, e.g. 5 diagonal steps (cost 70, length 7.07) and 7 straight steps
+// (cost 70, length 7), hence the paths are compared by their cost in the step costs of the planner.
+
+// plans between all pairs of cells with a standard and a Jump Point Search planner and compares the results with each other
+// and with the reference search
+static void comparePathsWithStandardSearch(const cv::Mat& map, const std::vector<cv::Point>& cells)
+{
+	AStarPlanner standard_planner;
+	standard_planner.setSearchMode(ASTAR_STANDARD);
+	AStarPlanner jps_planner;
+	jps_planner.setSearchMode(ASTAR_JUMP_POINT_SEARCH);
+	for (size_t i=0; i<cells.size(); ++i)
+	{
+		for (size_t j=i+1; j<cells.size(); ++j)
+		{
+			std::vector<cv::Point> standard_route, jps_route;
+			const double standard_length = standard_planner.planPath(map, cells[i], cells[j], 1., 0., 0.05, 0, &standard_route);
+			const double jps_length = jps_planner.planPath(map, cells[i], cells[j], 1., 0., 0.05, 0, &jps_route);
+			if (cells[i] == cells[j])
+			{
+				EXPECT_EQ(0., jps_length);
+				continue;
+			}
+			const int reference_cost = computeReferenceCost(map, cells[i], cells[j]);
+			if (reference_cost < 0)
+			{
+				EXPECT_GT(standard_length, 1e90);
+				EXPECT_GT(jps_length, 1e90) << "path from " << cells[i] << " to " << cells[j] << " should not exist";
+				continue;
+			}
+			int standard_cost = 0, jps_cost = 0;
+			double standard_route_length = 0., jps_route_length = 0.;
+			ASSERT_TRUE(evaluateRoute(map, standard_route, cells[i], cells[j], standard_cost, standard_route_length));
+			ASSERT_TRUE(evaluateRoute(map, jps_route, cells[i], cells[j], jps_cost, jps_route_length)) << "invalid route from " << cells[i] << " to " << cells[j];
+			EXPECT_EQ(reference_cost, jps_cost) << "path from " << cells[i] << " to " << cells[j] << " is not the shortest";
+			EXPECT_EQ(standard_cost, jps_cost);
+			EXPECT_NEAR(jps_route_length, jps_length, 1e-9);
+			// paths of equal cost differ by at most 0.071 cells per 70 cost units in their lengths
+			EXPECT_NEAR(standard_length, jps_length, 0.1 + 0.001*jps_cost);
+		}
+	}
+}
+
+TEST(JumpPointSearchTest, emptyMapHasOctileLengths)
+{
+	const cv::Mat map = createEmptyMap(50, 30);
+	AStarPlanner planner;
+	planner.setSearchMode(ASTAR_JUMP_POINT_SEARCH);
+	EXPECT_NEAR(47., planner.planPath(map, cv::Point(1, 5), cv::Point(48, 5), 1., 0., 0.05), 1e-9);
+	EXPECT_NEAR(20.*std::sqrt(2.), planner.planPath(map, cv::Point(2, 2), cv::Point(22, 22), 1., 0., 0.05), 1e-9);
+	EXPECT_NEAR(30. + 10.*std::sqrt(2.), planner.planPath(map, cv::Point(45, 25), cv::Point(5, 15), 1., 0., 0.05), 1e-9);
+	EXPECT_EQ(0., planner.planPath(map, cv::Point(7, 7), cv::Point(7, 7), 1., 0., 0.05));
+}
+
+TEST(JumpPointSearchTest, corridorPathsOnOfficeMap)
+{
+	const cv::Mat map = createOfficeMap();
+	AStarPlanner jps_planner;
+	jps_planner.setSearchMode(ASTAR_JUMP_POINT_SEARCH);
+	// along the corridor, which has a unique shortest path
+	EXPECT_NEAR(157., jps_planner.planPath(map, cv::Point(1, 30), cv::Point(158, 30), 1., 0., 0.05), 1e-9);
+	// into the closed room
+	EXPECT_GT(jps_planner.planPath(map, cv::Point(5, 30), cv::Point(150, 50), 1., 0., 0.05), 1e90);
+
+	// corridor ends, rooms on both sides of the corridor and the closed room
+	std::vector<cv::Point> cells;
+	cells.push_back(cv::Point(1, 30));
+	cells.push_back(cv::Point(158, 30));
+	cells.push_back(cv::Point(5, 5));
+	cells.push_back(cv::Point(135, 10));
+	cells.push_back(cv::Point(45, 55));
+	cells.push_back(cv::Point(65, 5));
+	cells.push_back(cv::Point(150, 50));
+	comparePathsWithStandardSearch(map, cells);
+}
+
+TEST(JumpPointSearchTest, shortestPathsOnOfficeMap)
+{
+	const cv::Mat map = createOfficeMap();
+	comparePathsWithStandardSearch(map, sampleAccessibleCells(map, 25, 2));
+}
+
+TEST(JumpPointSearchTest, shortestPathsOnRandomObstacleMaps)
+{
+	for (int seed=1; seed<=4; ++seed)
+	{
+		const cv::Mat map = createRandomObstacleMap(40+20*seed, 70-10*seed, 0.1*seed, seed);
+		comparePathsWithStandardSearch(map, sampleAccessibleCells(map, 15, seed+10));
+	}
+}
+
+TEST(JumpPointSearchTest, switchingTheSearchModeOnOneObject)
+{
+	const cv::Mat map = createRandomObstacleMap(80, 60, 0.2, 7);
+	const std::vector<cv::Point> cells = sampleAccessibleCells(map, 10, 7);
+	AStarPlanner planner;
+	for (size_t i=0; i+1<cells.size(); ++i)
+	{
+		planner.setSearchMode(ASTAR_STANDARD);
+		std::vector<cv::Point> route;
+		const double standard_length = planner.planPath(map, cells[i], cells[i+1], 1., 0., 0.05);
+		planner.setSearchMode(ASTAR_JUMP_POINT_SEARCH);
+		EXPECT_EQ(ASTAR_JUMP_POINT_SEARCH, planner.getSearchMode());
+		const double jps_length = planner.planPath(map, cells[i], cells[i+1], 1., 0., 0.05, 0, &route);
+		if (standard_length > 1e90)
+		{
+			EXPECT_GT(jps_length, 1e90);
+			continue;
+		}
+		int cost = 0;
+		double route_length = 0.;
+		ASSERT_TRUE(evaluateRoute(map, route, cells[i], cells[i+1], cost, route_length));
+		EXPECT_EQ(computeReferenceCost(map, cells[i], cells[i+1]), cost);
+	}
+}
+
+int main(int argc, char** argv)
+{
+	testing::InitGoogleTest(&argc, argv);
+	return RUN_ALL_TESTS();
+}
@@ -0,0 +1,191 @@
+/*!
+ *****************************************************************
+ * \file
+ *
+ * \note
+ * Copyright (c) 2026 \n
+ * Fraunhofer Institute for Manufacturing Engineering
+ * and Automation (IPA) \n\n
+ *
+ *****************************************************************
+ *
+ * \note
+ * Project name: Care-O-bot
+ * \note
+ * ROS stack name: autopnp
+ * \note
+ * ROS package name: ipa_building_navigation
+ *
+ * \author
+ * Author: Richard Bormann
+ * \author
+ * Supervised by: Richard Bormann
+ *
+ * \date Date of creation: 10.2026
+ *
+ * \brief
+ *
+ *
+ *****************************************************************
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer. \n
+ * - Redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution. \n
+ * - Neither the name of the Fraunhofer Institute for Manufacturing
+ * Engineering and Automation (IPA) nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission. \n
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License LGPL as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License LGPL for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License LGPL along with this program.
+ * If not, see <http://www.gnu.org/licenses/>.
+ *
+ ****************************************************************/
+
+#pragma once
+
+#include <vector>
+#include <queue>
+#include <functional>
+#include <cmath>
+#include <cstdlib>
+
+#include <opencv2/opencv.hpp>
+
+// synthetic occupancy grid maps (CV_8UC1, 255 = accessible) and a reference search for the tests of the path planners
+
+// room of the given size, surrounded by obstacles
+inline cv::Mat createEmptyMap(const int width, const int height)
+{
+	cv::Mat map(height, width, CV_8UC1, cv::Scalar(255));
+	cv::rectangle(map, cv::Point(0, 0), cv::Point(width-1, height-1), cv::Scalar(0), 1);
+	return map;
+}
+
+// office-like map: a long horizontal corridor with rooms above and below, each room has a door to the corridor
+inline cv::Mat createOfficeMap()
+{
+	cv::Mat map = createEmptyMap(160, 61);
+	cv::line(map, cv::Point(0, 25), cv::Point(159, 25), cv::Scalar(0), 1);
+	cv::line(map, cv::Point(0, 35), cv::Point(159, 35), cv::Scalar(0), 1);
+	for (int x=20; x<160; x+=20)
+	{
+		cv::line(map, cv::Point(x, 0), cv::Point(x, 25), cv::Scalar(0), 1);
+		cv::line(map, cv::Point(x, 35), cv::Point(x, 60), cv::Scalar(0), 1);
+	}
+	for (int x=10; x<160; x+=20)
+	{
+		cv::line(map, cv::Point(x-1, 25), cv::Point(x+1, 25), cv::Scalar(255), 1);
+		cv::line(map, cv::Point(x-1, 35), cv::Point(x+1, 35), cv::Scalar(255), 1);
+	}
+	// a closed room without door
+	cv::line(map, cv::Point(149, 35), cv::Point(151, 35), cv::Scalar(0), 1);
+	return map;
+}
+
+// room with randomly placed obstacle cells, the generator is seeded so that the map is the same in every run
+inline cv::Mat createRandomObstacleMap(const int width, const int height, const double obstacle_ratio, const int seed)
+{
+	cv::Mat map = createEmptyMap(width, height);
+	cv::RNG rng(seed);
+	for (int v=1; v<height-1; ++v)
+		for (int u=1; u<width-1; ++u)
+			if (rng.uniform(0., 1.) < obstacle_ratio)
+				map.at<uchar>(v, u) = 0;
+	return map;
+}
+
+// returns number randomly chosen accessible cells of the map, the generator is seeded so that the cells are the same in every run
+inline std::vector<cv::Point> sampleAccessibleCells(const cv::Mat& map, const int number, const int seed)
+{
+	std::vector<cv::Point> accessible_cells;
+	for (int v=0; v<map.rows; ++v)
+		for (int u=0; u<map.cols; ++u)
+			if (map.at<uchar>(v, u) == 255)
+				accessible_cells.push_back(cv::Point(u, v));
+	cv::RNG rng(seed);
+	std::vector<cv::Point> cells;
+	for (int i=0; i<number && accessible_cells.empty()==false; ++i)
+		cells.push_back(accessible_cells[rng.uniform(0, (int)accessible_cells.size())]);
+	return cells;
+}
+
+// Dijkstra search on the 8-connected grid with the step costs of AStarPlanner (10 straight, 14 diagonal, diagonal moves past
+// obstacle corners allowed), returns the cost of the shortest path from start to goal or -1 if goal cannot be reached
+inline int computeReferenceCost(const cv::Mat& map, const cv::Point& start, const cv::Point& goal)
+{
+	static const int dx[8] = {1, 1, 0, -1, -1, -1, 0, 1};
+	static const int dy[8] = {0, 1, 1, 1, 0, -1, -1, -1};
+	std::vector<int> cost(map.rows*map.cols, -1);
+	std::priority_queue<std::pair<int, int>, std::vector<std::pair<int, int> >, std::greater<std::pair<int, int> > > open;
+	cost[start.y*map.cols+start.x] = 0;
+	open.push(std::make_pair(0, start.y*map.cols+start.x));
+	while (open.empty() == false)
+	{
+		const int current_cost = open.top().first;
+		const int cell = open.top().second;
+		open.pop();
+		if (current_cost > cost[cell])
+			continue;
+		const int x = cell % map.cols;
+		const int y = cell / map.cols;
+		if (x == goal.x && y == goal.y)
+			return current_cost;
+		for (int d=0; d<8; ++d)
+		{
+			const int nx = x + dx[d];
+			const int ny = y + dy[d];
+			if (nx < 0 || nx >= map.cols || ny < 0 || ny >= map.rows || map.at<uchar>(ny, nx) != 255)
+				continue;
+			const int next_cost = current_cost + (d%2 == 0 ? 10 : 14);
+			const int next_cell = ny*map.cols + nx;
+			if (cost[next_cell] == -1 || next_cost < cost[next_cell])
+			{
+				cost[next_cell] = next_cost;
+				open.push(std::make_pair(next_cost, next_cell));
+			}
+		}
+	}
+	return -1;
+}
+
+// checks that route leads from start to goal over accessible, 8-neighboring cells and computes its cost with the step costs of
+// AStarPlanner and its length in [cell], returns false if the route is not valid
+inline bool evaluateRoute(const cv::Mat& map, const std::vector<cv::Point>& route, const cv::Point& start, const cv::Point& goal,
+		int& cost, double& length)
+{
+	cost = 0;
+	length = 0.;
+	if (route.size() < 2 || route.front() != start || route.back() != goal)
+		return false;
+	for (size_t i=0; i<route.size(); ++i)
+	{
+		const cv::Point& cell = route[i];
+		if (cell.x < 0 || cell.x >= map.cols || cell.y < 0 || cell.y >= map.rows || map.at<uchar>(cell) != 255)
+			return false;
+		if (i == 0)
+			continue;
+		const int step_x = std::abs(cell.x - route[i-1].x);
+		const int step_y = std::abs(cell.y - route[i-1].y);
+		if (step_x > 1 || step_y > 1 || step_x+step_y == 0)
+			return false;
+		cost += (step_x+step_y == 1 ? 10 : 14);
+		length += (step_x+step_y == 1 ? 1. : std::sqrt(2.));
+	}
+	return true;
+}
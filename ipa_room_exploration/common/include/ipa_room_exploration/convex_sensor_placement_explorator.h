@@ -83,6 +83,7 @@
 
 #include <ipa_building_navigation/A_star_pathplanner.h>
 #include <ipa_building_navigation/distance_matrix.h>
+#include <ipa_building_navigation/line_of_sight.h>
 #include <ipa_building_navigation/nearest_neighbor_TSP.h>
 
 #include <ipa_room_exploration/room_rotator.h>
@@ -140,6 +141,12 @@ public:
 	// constructor
 	convexSPPExplorator();
 
+	// selects the search mode of the A* planner that computes the distances between the sensing poses, see AStarSearchModes, default: ASTAR_STANDARD
+	void setSearchMode(const int search_mode)
+	{
+		path_planner_.setSearchMode(search_mode);
+	}
+
 	// Function that creates an exploration path for a given room. The room has to be drawn in a cv::Mat (filled with Bit-uchar),
 	// with free space drawn white (255) and obstacles as black (0). It returns a series of 2D poses that show to which positions
 	// the robot should drive at. The footprint stores a polygon that is used to determine the visibility at a specific
@@ -495,6 +495,12 @@ public:
 	// constructor
 	FlowNetworkExplorator();
 
+	// selects the search mode of the A* planner that connects the path segments, see AStarSearchModes, default: ASTAR_STANDARD
+	void setSearchMode(const int search_mode)
+	{
+		path_planner_.setSearchMode(search_mode);
+	}
+
 	// Function that creates an exploration path for a given room. The room has to be drawn in a cv::Mat (filled with Bit-uchar),
 	// with free space drawn white (255) and obstacles as black (0). It returns a series of 2D poses that show to which positions
 	// the robot should drive at. The footprint stores a polygon that is used to determine the visibility at a specific
@@ -84,16 +84,23 @@
 //
 class GridPointExplorator
 {
+protected:
+	// settings of the distance matrix of the grid points
+	DistanceMatrixSettings distance_matrix_settings_;
+
 public:
 	// constructor
 	GridPointExplorator();
 
+	// sets the settings of the distance matrix of the grid points, see DistanceMatrixSettings
+	void setDistanceMatrixSettings(const DistanceMatrixSettings& settings);
+
 	// separate, interruptible thread for the external solvers
 	void tsp_solver_thread_concorde(ConcordeTSPSolver& tsp_solver, std::vector<int>& optimal_order,
-			const cv::Mat& distance_matrix, const std::map<int,int>& cleaned_index_to_original_index_mapping, const int start_node);
+			const cv::Mat& distance_matrix, const std::vector<int>& cleaned_index_to_original_index_mapping, const int start_node);
 
 	void tsp_solver_thread_genetic(GeneticTSPSolver& tsp_solver, std::vector<int>& optimal_order,
-			const cv::Mat& distance_matrix, const std::map<int,int>& cleaned_index_to_original_index_mapping, const int start_node);
+			const cv::Mat& distance_matrix, const std::vector<int>& cleaned_index_to_original_index_mapping, const int start_node);
 
 	void tsp_solver_thread(const int tsp_solver, std::vector<int>& optimal_order, const cv::Mat& original_map,
 		const std::vector<cv::Point>& points, const double downsampling_factor, const double robot_radius, const double map_resolution,
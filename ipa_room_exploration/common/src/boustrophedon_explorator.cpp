@@ -1,4 +1,5 @@
 #include <ipa_room_exploration/boustrophedon_explorator.h>
+#include <ipa_building_navigation/instrumentation.h>
 
 //#define DEBUG_VISUALIZATION
 
@@ -263,6 +264,8 @@ void BoustrophedonExplorer::computeCellDecompositionWithRotation(const cv::Mat&
 void BoustrophedonExplorer::computeCellDecomposition(const cv::Mat& room_map, const float map_resolution, const double min_cell_area,
 		const int min_cell_width, std::vector<GeneralizedPolygon>& cell_polygons, std::vector<cv::Point>& polygon_centers)
 {
+	ScopedSpan span("cell_decomposition");
+
 	// *********************** II. Sweep a slice trough the map and mark the found cell boundaries. ***********************
 	// create a map copy to mark the cell boundaries
 	cv::Mat cell_map = room_map.clone();
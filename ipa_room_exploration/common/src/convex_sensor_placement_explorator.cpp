@@ -1,4 +1,5 @@
 #include <ipa_room_exploration/convex_sensor_placement_explorator.h>
+#include <ipa_building_navigation/instrumentation.h>
 
 // Constructor
 convexSPPExplorator::convexSPPExplorator()
@@ -128,8 +129,12 @@ void convexSPPExplorator::solveOptimizationProblem(std::vector<T>& C, const cv::
 	CbcModel model(*solver_pointer);
 	model.solver()->setHintParam(OsiDoReducePrint, true, OsiHintTry);
 
+	Instrumentation::addCount("lp_variables", solver_pointer->getNumCols());
+	Instrumentation::addCount("lp_constraints", solver_pointer->getNumRows());
+	ScopedSpan lp_span("lp_solve");
 	model.initialSolve();
 	model.branchAndBound();
+	lp_span.stop();
 
 	// retrieve solution
 	const double * solution = model.solver()->getColSolution();
@@ -269,7 +274,11 @@ void convexSPPExplorator::getExplorationPath(const cv::Mat& room_map, std::vecto
 	cv::Mat V = cv::Mat::zeros(cell_centers.size(), number_of_candidates, CV_8U); // binary variables
 
 	// check observable cells from each candidate pose
+	// the distance field lets the line of sight checks skip over open space, pixels with value 0 are obstacles
+	cv::Mat obstacle_distance_field;
+	LineOfSight::computeDistanceField(room_map, obstacle_distance_field, 1);
 	const double map_resolution_inverse = 1./map_resolution;
+	long raycasts = 0;	// added to the instrumentation once after the loop
 	for(std::vector<geometry_msgs::Pose2D>::iterator pose=candidate_sensing_poses.begin(); pose!=candidate_sensing_poses.end(); ++pose)
 	{
 		// get the transformed field of view
@@ -319,11 +328,8 @@ void convexSPPExplorator::getExplorationPath(const cv::Mat& room_map, std::vecto
 				if(cv::pointPolygonTest(transformed_fov_points, *neighbor, false) >= 0) // point inside
 				{
 					// check if the line from the robot pose to the neighbor crosses an obstacle, if so it is not observable from the pose
-					cv::LineIterator border_line(room_map, cv::Point(pose->x, pose->y), *neighbor, 8); // opencv implementation of bresenham algorithm, 8: color, irrelevant
-					bool hit_obstacle = false;
-					for(size_t i = 0; i < border_line.count; ++i, ++border_line)
-						if(room_map.at<uchar>(border_line.pos()) == 0)
-							hit_obstacle = true;
+					const bool hit_obstacle = !LineOfSight::isFree(room_map, cv::Point(pose->x, pose->y), *neighbor, 1, &obstacle_distance_field);
+					++raycasts;
 
 					if(hit_obstacle == false)
 					{
@@ -339,11 +345,8 @@ void convexSPPExplorator::getExplorationPath(const cv::Mat& room_map, std::vecto
 			else if(plan_for_footprint==true && (distance+cell_outcircle_radius_pixel)<=largest_robot_to_footprint_distance_pixel)
 			{
 				// check if the line from the robot pose to the neighbor crosses an obstacle, if so it is not observable from the pose
-				cv::LineIterator border_line(room_map, cv::Point(pose->x, pose->y), *neighbor, 8); // opencv implementation of bresenham algorithm, 8: color, irrelevant
-				bool hit_obstacle = false;
-				for(size_t i = 0; i < border_line.count; ++i, ++border_line)
-					if(room_map.at<uchar>(border_line.pos()) == 0)
-						hit_obstacle = true;
+				const bool hit_obstacle = !LineOfSight::isFree(room_map, cv::Point(pose->x, pose->y), *neighbor, 1, &obstacle_distance_field);
+				++raycasts;
 				if(hit_obstacle == false)
 					V.at<uchar>(neighbor-cell_centers.begin(), pose-candidate_sensing_poses.begin()) = 1;
 				else	// neighbor cell not observable
@@ -353,6 +356,7 @@ void convexSPPExplorator::getExplorationPath(const cv::Mat& room_map, std::vecto
 				V.at<uchar>(neighbor-cell_centers.begin(), pose-candidate_sensing_poses.begin()) = 0;
 		}
 	}
+	Instrumentation::addCount("raycasts", raycasts);
 	std::cout << "number of optimization variables: " << W.size() << std::endl;
 
 //	testing
@@ -1,4 +1,5 @@
 #include <ipa_room_exploration/flow_network_explorator.h>
+#include <ipa_building_navigation/instrumentation.h>
 
 // Constructor
 FlowNetworkExplorator::FlowNetworkExplorator()
@@ -254,8 +255,12 @@ void FlowNetworkExplorator::solveThreeStageOptimizationProblem(std::vector<doubl
 	CbcHeuristicFPump heuristic(model);
 	model.addHeuristic(&heuristic);
 
+	Instrumentation::addCount("lp_variables", solver_pointer->getNumCols());
+	Instrumentation::addCount("lp_constraints", solver_pointer->getNumRows());
+	ScopedSpan lp_span("lp_solve");
 	model.initialSolve();
 	model.branchAndBound();
+	lp_span.stop();
 
 	// retrieve solution
 	const double* solution = model.solver()->getColSolution();
@@ -606,8 +611,12 @@ void FlowNetworkExplorator::solveLazyConstraintOptimizationProblem(std::vector<d
 
 	CbcHeuristicFPump heuristic(model);
 	model.addHeuristic(&heuristic);
+	Instrumentation::addCount("lp_variables", solver_pointer->getNumCols());
+	Instrumentation::addCount("lp_constraints", solver_pointer->getNumRows());
+	ScopedSpan lp_span("lp_solve");
 	model.initialSolve();
 	model.branchAndBound();
+	lp_span.stop();
 
 //	testing
 //	std::vector<int> test_row(2);
@@ -937,8 +946,11 @@ void FlowNetworkExplorator::solveLazyConstraintOptimizationProblem(std::vector<d
 			CbcHeuristicFPump heuristic_new(new_model);
 			new_model.addHeuristic(&heuristic_new);
 
+			Instrumentation::addCount("lp_constraints", solver_pointer->getNumRows());
+			ScopedSpan lp_span("lp_solve");
 //			new_model.initialSolve();
 			new_model.branchAndBound();
+			lp_span.stop();
 
 			// retrieve new solution
 			solution = new_model.solver()->getColSolution();
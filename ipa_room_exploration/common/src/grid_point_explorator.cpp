@@ -10,8 +10,13 @@ GridPointExplorator::GridPointExplorator()
 {
 }
 
+void GridPointExplorator::setDistanceMatrixSettings(const DistanceMatrixSettings& settings)
+{
+	distance_matrix_settings_ = settings;
+}
+
 void GridPointExplorator::tsp_solver_thread_concorde(ConcordeTSPSolver& tsp_solver, std::vector<int>& optimal_order,
-		const cv::Mat& distance_matrix, const std::map<int,int>& cleaned_index_to_original_index_mapping, const int start_node)
+		const cv::Mat& distance_matrix, const std::vector<int>& cleaned_index_to_original_index_mapping, const int start_node)
 {
 	try
 	{
@@ -26,7 +31,7 @@ void GridPointExplorator::tsp_solver_thread_concorde(ConcordeTSPSolver& tsp_solv
 }
 
 void GridPointExplorator::tsp_solver_thread_genetic(GeneticTSPSolver& tsp_solver, std::vector<int>& optimal_order,
-		const cv::Mat& distance_matrix, const std::map<int,int>& cleaned_index_to_original_index_mapping, const int start_node)
+		const cv::Mat& distance_matrix, const std::vector<int>& cleaned_index_to_original_index_mapping, const int start_node)
 {
 	try
 	{
@@ -49,16 +54,19 @@ void GridPointExplorator::tsp_solver_thread(const int tsp_solver, std::vector<in
 		if (tsp_solver == TSP_NEAREST_NEIGHBOR)
 		{
 			NearestNeighborTSPSolver tsp_solve;
+			tsp_solve.setDistanceMatrixSettings(distance_matrix_settings_);
 			optimal_order = tsp_solve.solveNearestTSP(original_map, points, downsampling_factor, robot_radius, map_resolution, start_node, 0);
 		}
 		else if (tsp_solver == TSP_GENETIC)
 		{
 			GeneticTSPSolver tsp_solve;
+			tsp_solve.setDistanceMatrixSettings(distance_matrix_settings_);
 			optimal_order = tsp_solve.solveGeneticTSP(original_map, points, downsampling_factor, robot_radius, map_resolution, start_node, 0);
 		}
 		else if (tsp_solver == TSP_CONCORDE)
 		{
 			ConcordeTSPSolver tsp_solve;
+			tsp_solve.setDistanceMatrixSettings(distance_matrix_settings_);
 			optimal_order = tsp_solve.solveConcordeTSP(original_map, points, downsampling_factor, robot_radius, map_resolution, start_node, 0);
 		}
 		else
@@ -155,9 +163,10 @@ void GridPointExplorator::getExplorationPath(const cv::Mat& room_map, std::vecto
 	const double map_downsampling_factor = 0.25;
 	// compute distance matrix for TSP (outside of time limits for solving TSP)
 	cv::Mat distance_matrix_cleaned;
-	std::map<int,int> cleaned_index_to_original_index_mapping;	// maps the indices of the cleaned distance_matrix to the original indices of the original distance_matrix
+	std::vector<int> cleaned_index_to_original_index_mapping;	// maps the indices of the cleaned distance_matrix to the original indices of the original distance_matrix
 	AStarPlanner path_planner;
-	DistanceMatrix distance_matrix_computation;
+	path_planner.setSearchMode(distance_matrix_settings_.astar_search_mode);
+	DistanceMatrix distance_matrix_computation(distance_matrix_settings_);
 	distance_matrix_computation.computeCleanedDistanceMatrix(rotated_room_map, grid_points, map_downsampling_factor, 0.0, map_resolution, path_planner,
 			distance_matrix_cleaned, cleaned_index_to_original_index_mapping, min_index);
 
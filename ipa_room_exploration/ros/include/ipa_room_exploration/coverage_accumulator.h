@@ -0,0 +1,111 @@
+/*!
+ *****************************************************************
+ * \file
+ *
+ * \note
+ * Copyright (c) 2016 \n
+ * Fraunhofer Institute for Manufacturing Engineering
+ * and Automation (IPA) \n\n
+ *
+ *****************************************************************
+ *
+ * \note
+ * Project name: Care-O-bot
+ * \note
+ * ROS stack name: autopnp
+ * \note
+ * ROS package name: ipa_room_exploration
+ *
+ * \author
+ * Author: Richard Bormann
+ * \author
+ * Supervised by: Richard Bormann
+ *
+ * \date Date of creation: 10.2026
+ *
+ * \brief
+ *
+ *
+ *****************************************************************
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer. \n
+ * - Redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution. \n
+ * - Neither the name of the Fraunhofer Institute for Manufacturing
+ * Engineering and Automation (IPA) nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission. \n
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License LGPL as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License LGPL for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License LGPL along with this program.
+ * If not, see <http://www.gnu.org/licenses/>.
+ *
+ ****************************************************************/
+
+#pragma once
+
+#include <ipa_room_exploration/coverage_check_server.h>
+
+// Accumulates the coverage of a growing robot trajectory. In contrast to CoverageCheckServer::checkCoverage, which checks a complete
+// path at once, each new pose is added to a persistent coverage map and number of coverages image with work that only depends on
+// the size of the field of view or footprint. The results are the same as checking the whole path with CoverageCheckServer.
+class CoverageAccumulator : public CoverageCheckServer
+{
+protected:
+	cv::Mat map_;	// the map used for initialization, 0 = obstacle, 255 = free space
+	float map_resolution_;
+	float map_resolution_inverse_;	// computed like in CoverageCheckServer, so that the pixel coordinates and radius are identical
+	cv::Point2d map_origin_;
+	std::vector<Eigen::Matrix<float, 2, 1> > field_of_view_;
+	Eigen::Matrix<float, 2, 1> fov_origin_;
+	float coverage_radius_;
+	bool check_for_footprint_;
+
+	cv::Mat obstacle_distance_field_;	// distance of each pixel to the closest obstacle in map_, used for the field of view rays
+	cv::Mat footprint_stamp_;			// filled circle of the footprint
+	int coverage_radius_pixel_;
+
+	cv::Mat coverage_map_;				// map_ with all covered pixels drawn in as 127
+	cv::Mat number_of_coverage_image_;	// number of coverages of each pixel, 32 bit
+	size_t number_of_poses_;			// number of poses added since the last initialization
+
+public:
+	CoverageAccumulator();
+
+	// Discards the accumulated coverage and starts over with the given map and coverage device, the parameters have the same meaning as for
+	// CoverageCheckServer::checkCoverage.
+	void initialize(const cv::Mat& map, const float map_resolution, const cv::Point2d& map_origin,
+			const std::vector<Eigen::Matrix<float, 2, 1> >& field_of_view, const Eigen::Matrix<float, 2, 1>& fov_origin,
+			const float coverage_radius, const bool check_for_footprint);
+
+	// returns true if initialize has been called with the same parameters before
+	bool isInitializedFor(const cv::Mat& map, const float map_resolution, const cv::Point2d& map_origin,
+			const std::vector<Eigen::Matrix<float, 2, 1> >& field_of_view, const Eigen::Matrix<float, 2, 1>& fov_origin,
+			const float coverage_radius, const bool check_for_footprint) const;
+
+	// adds the coverage of the given robot poses (x, y, theta in the map frame), several poses are checked in parallel
+	void addPoses(const std::vector<cv::Point3d>& robot_poses);
+
+	// copies the current coverage map (covered pixels are 127) and number of coverages image (32 bit)
+	void getCoverage(cv::Mat& coverage_map, cv::Mat& number_of_coverage_image) const;
+
+	size_t getNumberOfPoses() const
+	{
+		return number_of_poses_;
+	}
+};
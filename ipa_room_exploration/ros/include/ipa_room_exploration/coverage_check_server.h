@@ -1,3 +1,5 @@
+#pragma once
+
 // Ros
 #include <ros/ros.h>
 // OpenCV
@@ -13,6 +15,13 @@
 #include <vector>
 #include <algorithm>
 #include <cmath>
+#include <limits>
+
+// Boost
+#include <boost/thread.hpp>
+
+#include <ipa_building_navigation/line_of_sight.h>
+
 // services
 #include <ipa_building_msgs/CheckCoverage.h>
 
@@ -27,6 +36,17 @@ protected:
 	// node handle
 	ros::NodeHandle node_handle_;
 
+	// number of threads that check the robot poses in parallel
+	int number_of_threads_;
+
+	// Image coordinates of the area that can be covered from one robot pose.
+	struct CoverageArea
+	{
+		std::vector<cv::Point> fov_points;	// field of view polygon, empty for a circular footprint
+		cv::Point origin;	// field of view origin or footprint center
+		cv::Rect bounding_box;	// contains all pixels that can be covered from this pose, clipped to the map
+	};
+
 	// Function to draw the covered areas into the given map. This is done by going through all given robot-poses and calculating
 	// the field of view. The field of view is given in robot base coordinates (x-axis shows to the front and y-axis to left side).
 	// The function then calculates the field_of_view in the global frame by using the given robot pose.
@@ -38,6 +58,35 @@ protected:
 			const std::vector<Eigen::Matrix<float, 2, 1>>& field_of_view_points, const Eigen::Matrix<float, 2, 1>& fov_origin,
 			const float map_resolution, const cv::Point2d map_origin, cv::Mat* number_of_coverages_image=NULL);
 
+	// Computes the field of view polygon and its origin in image coordinates for the given robot pose, as used by drawCoveredPointsPolygon.
+	void computeFovCoverageArea(const cv::Point3d& pose, const std::vector<Eigen::Matrix<float, 2, 1> >& field_of_view,
+			const Eigen::Matrix<float, 2, 1>& fov_origin, const float map_resolution_inverse, const cv::Point2d& map_origin,
+			const int rows, const int cols, CoverageArea& area);
+
+	// Computes the pixels of the given field of view polygon (in image coordinates) that are visible from fov_origin_point.
+	// Only the bounding box of the polygon and its origin is rasterized, which yields the same pixels as filling the polygon
+	// in a full map sized image. When the bounding box contains no obstacle, every line from the origin stays inside of it and
+	// all fov pixels are visible without casting rays, otherwise each pixel is checked with a ray through the obstacle_distance_field.
+	// fov_mask is a buffer that can be reused between calls.
+	static void computeVisibleFovPixels(const cv::Mat& reachable_areas_map, const cv::Mat& obstacle_distance_field,
+			const std::vector<cv::Point>& fov_points, const cv::Point& fov_origin_point, cv::Mat& fov_mask,
+			std::vector<cv::Point>& visible_fov_pixels);
+
+	// Marks the pixels covered by the given areas in reachable_areas_map with 127 and adds the number of coverages to
+	// number_of_coverages_image, if it is not NULL. Since coverage is commutative, the areas are split into consecutive chunks that
+	// are distributed over number_of_threads_ threads. Each chunk is counted in a 16 bit tile that only spans the bounding box of
+	// its areas, which is merged into the results afterwards.
+	// If footprint_stamp is not empty, it is added around the origin of each area and only free pixels (255) are marked as covered,
+	// otherwise the visible pixels of the field of view are computed in obstacle_map.
+	void accumulateCoverage(const std::vector<CoverageArea>& coverage_areas, const cv::Mat& obstacle_map,
+			const cv::Mat& obstacle_distance_field, const cv::Mat& footprint_stamp, cv::Mat& reachable_areas_map,
+			cv::Mat* number_of_coverages_image);
+
+	// Worker of accumulateCoverage that processes the given chunks of coverage_areas.
+	static void accumulateCoverageChunks(const std::vector<CoverageArea>& coverage_areas, const cv::Mat& obstacle_map,
+			const cv::Mat& obstacle_distance_field, const cv::Mat& footprint_stamp, const std::vector<cv::Range>& chunks,
+			cv::Mat& reachable_areas_map, cv::Mat* number_of_coverages_image, boost::mutex& merge_mutex);
+
 	// Function that takes the given robot poses and draws the circular footprint with coverage_radius at these positions into the given map.
 	// Used when the server should plan a coverage path for the robot coverage area (a circle). This drawing function does not test occlusions
 	// since a footprint can usually be assumed to reach all covered map positions (otherwise it would be a collision).
@@ -45,6 +94,13 @@ protected:
 				const double coverage_radius, const float map_resolution,
 				const cv::Point2d map_origin, cv::Mat* number_of_coverages_image=NULL);
 
+	// Draws the filled circle with coverage_radius_pixel that is stamped at each footprint position by drawCoveredPointsCircle.
+	static void createFootprintStamp(const int coverage_radius_pixel, cv::Mat& footprint_stamp);
+
+	// Computes the footprint center in image coordinates for the given robot pose, as used by drawCoveredPointsCircle.
+	static void computeFootprintCoverageArea(const cv::Point3d& pose, const int coverage_radius_pixel, const float map_resolution_inverse,
+			const cv::Point2d& map_origin, const int rows, const int cols, CoverageArea& area);
+
 	// reduces image coordinates of a point to valid values inside the image, i.e. between [0,rows-1]/[0,cols-1]
 	cv::Point clampImageCoordinates(const cv::Point& p, const int rows, const int cols);
 
@@ -55,6 +111,9 @@ public:
 	CoverageCheckServer();
 	CoverageCheckServer(ros::NodeHandle nh);
 
+	// sets the number of threads for checking the poses (default 1), values < 1 use the number of available cores
+	void setNumberOfThreads(const int number_of_threads);
+
 	// callback function for the server
 	bool checkCoverage(ipa_building_msgs::CheckCoverageRequest& request, ipa_building_msgs::CheckCoverageResponse& response);
 
@@ -82,8 +82,11 @@
 #include <vector>
 #include <algorithm>
 #include <cmath>
+// Boost
+#include <boost/thread.hpp>
 // services and actions
 #include <ipa_building_msgs/RoomExplorationAction.h>
+#include <ipa_building_msgs/MultiRoomExplorationAction.h>
 #include <cob_map_accessibility_analysis/CheckPerimeterAccessibility.h>
 #include <ipa_building_msgs/CheckCoverage.h>
 // messages
@@ -97,6 +100,7 @@
 #include <sensor_msgs/image_encodings.h>
 // specific from this package
 #include <ipa_building_navigation/concorde_TSP.h>
+#include <ipa_building_navigation/instrumentation_publisher.h>
 #include <ipa_room_exploration/RoomExplorationConfig.h>
 #include <ipa_room_exploration/grid_point_explorator.h>
 #include <ipa_room_exploration/boustrophedon_explorator.h>
@@ -122,13 +126,27 @@ protected:
 
 	ros::Publisher path_pub_; // a publisher sending the path as a nav_msgs::Path before executing
 
-	GridPointExplorator grid_point_planner; // object that uses the grid point method to plan a path trough a room
-	BoustrophedonExplorer boustrophedon_explorer_; // object that uses the boustrophedon exploration method to plan a path trough the room
-	NeuralNetworkExplorator neural_network_explorator_; // object that uses the neural network method to create an exploration path
-	convexSPPExplorator convex_SPP_explorator_; // object that uses the convex spp exploration methd to create an exploration path
-	FlowNetworkExplorator flow_network_explorator_; // object that uses the flow network exploration method to create an exploration path
-	EnergyFunctionalExplorator energy_functional_explorator_; // object that uses the energy functional exploration method to create an exploration path
-	BoustrophedonVariantExplorer boustrophedon_variant_explorer_; // object that uses the boustrophedon variant exploration method to plan a path trough the room
+	// the objects of all exploration methods, rooms that are planned concurrently need separate instances
+	struct ExplorationPlanners
+	{
+		GridPointExplorator grid_point_planner; // object that uses the grid point method to plan a path trough a room
+		BoustrophedonExplorer boustrophedon_explorer; // object that uses the boustrophedon exploration method to plan a path trough the room
+		NeuralNetworkExplorator neural_network_explorator; // object that uses the neural network method to create an exploration path
+		convexSPPExplorator convex_SPP_explorator; // object that uses the convex spp exploration methd to create an exploration path
+		FlowNetworkExplorator flow_network_explorator; // object that uses the flow network exploration method to create an exploration path
+		EnergyFunctionalExplorator energy_functional_explorator; // object that uses the energy functional exploration method to create an exploration path
+		BoustrophedonVariantExplorer boustrophedon_variant_explorer; // object that uses the boustrophedon variant exploration method to plan a path trough the room
+	};
+	ExplorationPlanners exploration_planners_;	// planners of the single room exploration action
+
+	// one room of a multi room exploration request
+	struct RoomPlanningTask
+	{
+		cv::Mat room_map;				// map of the room cropped to its bounding box with a small margin, 255 = room, 0 = elsewhere, empty if the room does not exist
+		cv::Point2d map_origin;			// origin of the cropped map, in [m]
+		cv::Point starting_position;	// room center in the cropped map, in [pixel], moved to the closest accessible room pixel by planRoomTasks
+		ipa_building_msgs::RoomExplorationPath result;
+	};
 
 	// parameters
 	int room_exploration_algorithm_;	// variable to specify which algorithm is going to be used to plan a path
@@ -141,6 +159,7 @@ protected:
 										// 7: Voronoi explorator
 										// 8: boustrophedon variant explorator
 	bool display_trajectory_;		// display final trajectory plan step by step
+	int multi_room_planning_threads_;	// number of rooms that are planned concurrently by the multi room exploration action, values < 1 use the number of available cores
 
 	// parameters on map correction
 	int map_correction_closing_neighborhood_size_;	// Applies a closing operation to neglect inaccessible areas and map errors/artifacts if the
@@ -164,12 +183,17 @@ protected:
 	std::string map_frame_;			// string that carries the name of the map frame, used for tracking of the robot
 	std::string camera_frame_;				// string that carries the name of the camera frame, that is in the same kinematic chain as the map_frame and shows the camera pose
 
+	int astar_search_mode_;		// search algorithm of the A* path planner: 1 = standard A*, 2 = Jump Point Search
+
 	// parameters specific to the grid point explorator
 	int tsp_solver_;	// indicates which TSP solver should be used
 						//   1 = Nearest Neighbor
 						//   2 = Genetic solver
 						//   3 = Concorde solver
 	int64_t tsp_solver_timeout_;	// a sophisticated solver like Concorde or Genetic can be interrupted if it does not find a solution within this time, in [s], and then falls back to the nearest neighbor solver
+	int distance_matrix_backend_;	// method for computing the path lengths of the distance matrix: 1 = A* search per pair, 2 = one wavefront expansion per point
+	int distance_matrix_cache_size_;	// number of distance matrices kept in memory for reuse in later requests on the same map, 0 = disabled
+	std::string distance_matrix_cache_directory_;	// directory for storing distance matrices on disk across restarts, empty = disabled
 
 	// parameters specific for the boustrophedon explorator
 	double min_cell_area_;			// minimal area a cell can have, when using the boustrophedon explorator
@@ -207,6 +231,26 @@ protected:
 	// this is the execution function used by action server
 	void exploreRoom(const ipa_building_msgs::RoomExplorationGoalConstPtr &goal);
 
+	// execution function of the multi room exploration action server, plans the coverage paths of all rooms of a segmented map concurrently
+	void exploreRooms(const ipa_building_msgs::MultiRoomExplorationGoalConstPtr &goal);
+
+	// worker thread of exploreRooms, takes the next task (counted by next_task under task_mutex) until all rooms have been planned
+	// or the goal is preempted, each worker uses its own planner objects and distance_matrix_threads threads for its distance matrices
+	void planRoomTasks(std::vector<RoomPlanningTask>& tasks, size_t& next_task, boost::mutex& task_mutex,
+			const ipa_building_msgs::MultiRoomExplorationGoalConstPtr& goal, const int distance_matrix_threads);
+
+	// Prepares the room map (closing operation, removal of unconnected parts) and plans the coverage path through it with the configured
+	// exploration algorithm. Returns false if the room is too small for planning. The exploration path is given in [m] and [rad].
+	// grid_spacing_in_pixel and fitting_circle_center_point_in_meter return the coverage grid size and the field of view center.
+	// The planners are passed in, so that several rooms can be planned concurrently with separate planner objects.
+	// distance_matrix_threads is the number of threads of the distance matrix computations (see DistanceMatrixSettings), callers that
+	// plan several rooms concurrently should use 1.
+	bool planCoveragePath(cv::Mat& room_map, const float map_resolution, const cv::Point2d& map_origin,
+			const cv::Point& starting_position, const int planning_mode, const float robot_radius, const float coverage_radius,
+			const std::vector<geometry_msgs::Point32>& field_of_view, ExplorationPlanners& planners, const int distance_matrix_threads,
+			std::vector<geometry_msgs::Pose2D>& exploration_path, double& grid_spacing_in_pixel,
+			Eigen::Matrix<float, 2, 1>& fitting_circle_center_point_in_meter);
+
 	// remove unconnected, i.e. inaccessible, parts of the room (i.e. obstructed by furniture), only keep the room with the largest area
 	bool removeUnconnectedRoomParts(cv::Mat& room_map);
 
@@ -280,8 +324,12 @@ protected:
 	//
 	ros::NodeHandle node_handle_;
 	actionlib::SimpleActionServer<ipa_building_msgs::RoomExplorationAction> room_exploration_server_;
+	actionlib::SimpleActionServer<ipa_building_msgs::MultiRoomExplorationAction> multi_room_exploration_server_;
 	dynamic_reconfigure::Server<ipa_room_exploration::RoomExplorationConfig> room_exploration_dynamic_reconfigure_server_;
 
+	InstrumentationPublisher instrumentation_publisher_;	// stage timings and counters of each call, see parameters instrumentation/*
+	boost::mutex instrumentation_mutex_;	// held by the instrumented call of either action while the instrumentation is enabled
+
 public:
 	enum PlanningMode {PLAN_FOR_FOOTPRINT=1, PLAN_FOR_FOV=2};
 
@@ -0,0 +1,80 @@
+#include <ipa_room_exploration/coverage_accumulator.h>
+
+CoverageAccumulator::CoverageAccumulator()
+: map_resolution_(0.f), map_resolution_inverse_(0.f), coverage_radius_(0.f), check_for_footprint_(false), coverage_radius_pixel_(0), number_of_poses_(0)
+{
+	fov_origin_.setZero();
+}
+
+void CoverageAccumulator::initialize(const cv::Mat& map, const float map_resolution, const cv::Point2d& map_origin,
+		const std::vector<Eigen::Matrix<float, 2, 1> >& field_of_view, const Eigen::Matrix<float, 2, 1>& fov_origin,
+		const float coverage_radius, const bool check_for_footprint)
+{
+	map_ = map.clone();
+	map_resolution_ = map_resolution;
+	map_resolution_inverse_ = 1./map_resolution;
+	map_origin_ = map_origin;
+	field_of_view_ = field_of_view;
+	fov_origin_ = fov_origin;
+	coverage_radius_ = coverage_radius;
+	check_for_footprint_ = check_for_footprint;
+
+	// prepare the data that stays the same for all poses
+	obstacle_distance_field_.release();
+	footprint_stamp_.release();
+	if (check_for_footprint_ == true)
+	{
+		coverage_radius_pixel_ = coverage_radius_*map_resolution_inverse_;
+		createFootprintStamp(coverage_radius_pixel_, footprint_stamp_);
+	}
+	else
+		LineOfSight::computeDistanceField(map_, obstacle_distance_field_, 1);
+
+	coverage_map_ = map_.clone();
+	number_of_coverage_image_ = cv::Mat::zeros(map_.rows, map_.cols, CV_32SC1);
+	number_of_poses_ = 0;
+}
+
+bool CoverageAccumulator::isInitializedFor(const cv::Mat& map, const float map_resolution, const cv::Point2d& map_origin,
+		const std::vector<Eigen::Matrix<float, 2, 1> >& field_of_view, const Eigen::Matrix<float, 2, 1>& fov_origin,
+		const float coverage_radius, const bool check_for_footprint) const
+{
+	if (map_.empty() == true || map.size() != map_.size() || map.type() != map_.type())
+		return false;
+	if (map_resolution != map_resolution_ || map_origin != map_origin_ || check_for_footprint != check_for_footprint_)
+		return false;
+	if (check_for_footprint == true && coverage_radius != coverage_radius_)
+		return false;
+	if (check_for_footprint == false && (fov_origin != fov_origin_ || field_of_view.size() != field_of_view_.size()))
+		return false;
+	for (size_t i=0; check_for_footprint == false && i<field_of_view.size(); ++i)
+		if (field_of_view[i] != field_of_view_[i])
+			return false;
+	return (cv::countNonZero(map != map_) == 0);
+}
+
+void CoverageAccumulator::addPoses(const std::vector<cv::Point3d>& robot_poses)
+{
+	if (map_.empty() == true || robot_poses.empty() == true)
+		return;
+
+	// image coordinates of the covered area of each new pose
+	std::vector<CoverageArea> coverage_areas(robot_poses.size());
+	for (size_t i=0; i<robot_poses.size(); ++i)
+	{
+		if (check_for_footprint_ == true)
+			computeFootprintCoverageArea(robot_poses[i], coverage_radius_pixel_, map_resolution_inverse_, map_origin_, map_.rows, map_.cols, coverage_areas[i]);
+		else
+			computeFovCoverageArea(robot_poses[i], field_of_view_, fov_origin_, map_resolution_inverse_, map_origin_, map_.rows, map_.cols, coverage_areas[i]);
+	}
+
+	// covered pixels are already 127 in coverage_map_, so drawing into free space (255) only adds the new coverage
+	accumulateCoverage(coverage_areas, map_, obstacle_distance_field_, footprint_stamp_, coverage_map_, &number_of_coverage_image_);
+	number_of_poses_ += robot_poses.size();
+}
+
+void CoverageAccumulator::getCoverage(cv::Mat& coverage_map, cv::Mat& number_of_coverage_image) const
+{
+	coverage_map = coverage_map_.clone();
+	number_of_coverage_image = number_of_coverage_image_.clone();
+}
@@ -2,16 +2,26 @@
 
 // The default constructors
 CoverageCheckServer::CoverageCheckServer()
+: number_of_threads_(1)
 {
 }
 
 CoverageCheckServer::CoverageCheckServer(ros::NodeHandle nh)
-:node_handle_(nh)
+:node_handle_(nh), number_of_threads_(1)
 {
+	int number_of_threads = 0;
+	node_handle_.param("number_of_threads", number_of_threads, 0);
+	setNumberOfThreads(number_of_threads);
+	std::cout << "coverage_check_server: number_of_threads = " << number_of_threads_ << std::endl;
 	coverage_check_server_ = node_handle_.advertiseService("coverage_check", &CoverageCheckServer::checkCoverage, this);
 	ROS_INFO("Server for coverage checking initialized.....");
 }
 
+void CoverageCheckServer::setNumberOfThreads(const int number_of_threads)
+{
+	number_of_threads_ = (number_of_threads < 1 ? std::max(1, (int)boost::thread::hardware_concurrency()) : number_of_threads);
+}
+
 // Callback function for the server.
 bool CoverageCheckServer::checkCoverage(ipa_building_msgs::CheckCoverageRequest& request, ipa_building_msgs::CheckCoverageResponse& response)
 {
@@ -100,74 +110,98 @@ void CoverageCheckServer::drawCoveredPointsPolygon(cv::Mat& reachable_areas_map,
 {
 	const float map_resolution_inverse = 1./map_resolution;
 
-	// go trough each given robot pose
-	for(std::vector<cv::Point3d>::const_iterator current_pose = robot_poses.begin(); current_pose != robot_poses.end(); ++current_pose)
+	// image coordinates of the field of view for each robot pose
+	std::vector<CoverageArea> coverage_areas(robot_poses.size());
+	for(size_t pose_index = 0; pose_index < robot_poses.size(); ++pose_index)
+		computeFovCoverageArea(robot_poses[pose_index], field_of_view, fov_origin, map_resolution_inverse, map_origin,
+				reachable_areas_map.rows, reachable_areas_map.cols, coverage_areas[pose_index]);
+
+	// distance of each pixel to the closest obstacle (value 0), lets the rays skip over open space
+	// marking covered pixels with 127 does not create new obstacles, but the rays read from an unchanged copy so that poses can be checked in parallel
+	const cv::Mat obstacle_map = reachable_areas_map.clone();
+	cv::Mat obstacle_distance_field;
+	LineOfSight::computeDistanceField(obstacle_map, obstacle_distance_field, 1);
+
+	// mark the visible pixels of all poses in the map and count them, if wanted
+	accumulateCoverage(coverage_areas, obstacle_map, obstacle_distance_field, cv::Mat(), reachable_areas_map, number_of_coverages_image);
+}
+
+
+void CoverageCheckServer::computeFovCoverageArea(const cv::Point3d& pose, const std::vector<Eigen::Matrix<float, 2, 1> >& field_of_view,
+			const Eigen::Matrix<float, 2, 1>& fov_origin, const float map_resolution_inverse, const cv::Point2d& map_origin,
+			const int rows, const int cols, CoverageArea& area)
+{
+	// get the rotation matrix
+	float sin_theta = std::sin(pose.z);
+	float cos_theta = std::cos(pose.z);
+	Eigen::Matrix<float, 2, 2> R;
+	R << cos_theta, -sin_theta, sin_theta, cos_theta;
+
+	// current pose as Eigen matrix
+	Eigen::Matrix<float, 2, 1> pose_as_matrix;
+	pose_as_matrix << pose.x, pose.y;
+
+	// transform field of view points
+	area.fov_points.clear();
+	for(size_t point = 0; point < field_of_view.size(); ++point)
 	{
-		// get the rotation matrix
-		float sin_theta = std::sin(current_pose->z);
-		float cos_theta = std::cos(current_pose->z);
-		Eigen::Matrix<float, 2, 2> R;
-		R << cos_theta, -sin_theta, sin_theta, cos_theta;
-
-		// current pose as Eigen matrix
-		Eigen::Matrix<float, 2, 1> pose_as_matrix;
-		pose_as_matrix << current_pose->x, current_pose->y;
-
-		// transform field of view points
-		std::vector<cv::Point> transformed_fov_points;
-		for(size_t point = 0; point < field_of_view.size(); ++point)
-		{
-			// linear transformation
-			const Eigen::Matrix<float, 2, 1> transformed_fov_point = pose_as_matrix + R * field_of_view[point];
+		// linear transformation
+		const Eigen::Matrix<float, 2, 1> transformed_fov_point = pose_as_matrix + R * field_of_view[point];
 
-			// save the transformed point as cv::Point, also check if map borders are satisfied and transform it into pixel values
-			transformed_fov_points.push_back(clampImageCoordinates(cv::Point((transformed_fov_point(0, 0)-map_origin.x)*map_resolution_inverse, (transformed_fov_point(1, 0)-map_origin.y)*map_resolution_inverse), reachable_areas_map.rows, reachable_areas_map.cols));
-		}
+		// save the transformed point as cv::Point, also check if map borders are satisfied and transform it into pixel values
+		area.fov_points.push_back(clampImageCoordinates(cv::Point((transformed_fov_point(0, 0)-map_origin.x)*map_resolution_inverse, (transformed_fov_point(1, 0)-map_origin.y)*map_resolution_inverse), rows, cols));
+	}
 
-		// transform field of view origin
-		const Eigen::Matrix<float, 2, 1> transformed_fov_origin = pose_as_matrix + R * fov_origin;
-		const cv::Point transformed_fov_origin_point = clampImageCoordinates(cv::Point((transformed_fov_origin(0, 0)-map_origin.x)*map_resolution_inverse, (transformed_fov_origin(1, 0)-map_origin.y)*map_resolution_inverse), reachable_areas_map.rows, reachable_areas_map.cols);
+	// transform field of view origin
+	const Eigen::Matrix<float, 2, 1> transformed_fov_origin = pose_as_matrix + R * fov_origin;
+	area.origin = clampImageCoordinates(cv::Point((transformed_fov_origin(0, 0)-map_origin.x)*map_resolution_inverse, (transformed_fov_origin(1, 0)-map_origin.y)*map_resolution_inverse), rows, cols);
 
-		// draw current field of view in map
-		cv::Mat fov_mat = cv::Mat::zeros(reachable_areas_map.rows, reachable_areas_map.cols, reachable_areas_map.type());
-		std::vector<std::vector<cv::Point> > contours(1, transformed_fov_points);
-		cv::drawContours(fov_mat, contours, 0, cv::Scalar(255), CV_FILLED);
+	// all visible pixels lie inside the field of view polygon
+	area.bounding_box = (area.fov_points.empty() == false ? cv::boundingRect(area.fov_points) : cv::Rect());
+}
 
-		// check visibility for each pixel of the fov area
-		for (int v=0; v<fov_mat.rows; ++v)
-		{
-			for (int u=0; u<fov_mat.cols; ++u)
-			{
-				if (fov_mat.at<uchar>(v,u)==0)
-					continue;
 
-				// create a line iterator from fov_origin to current fov point and verify visibility
-				bool point_visible = true;
-				const cv::Point current_goal(u,v);
-				cv::LineIterator ray_points(reachable_areas_map, transformed_fov_origin_point, current_goal, 8, false);
-				for(size_t point = 0; point < ray_points.count; ++point, ++ray_points)
-				{
-					if (reachable_areas_map.at<uchar>(ray_points.pos()) == 0)
-					{
-						point_visible = false;
-						break;
-					}
-				}
+void CoverageCheckServer::computeVisibleFovPixels(const cv::Mat& reachable_areas_map, const cv::Mat& obstacle_distance_field,
+			const std::vector<cv::Point>& fov_points, const cv::Point& fov_origin_point, cv::Mat& fov_mask,
+			std::vector<cv::Point>& visible_fov_pixels)
+{
+	visible_fov_pixels.clear();
+	if (fov_points.empty())
+		return;
 
-				// mark visible point in map
-				if (point_visible == true)
-				{
-					reachable_areas_map.at<uchar>(current_goal) = 127;
+	// bounding box of the fov polygon and its origin, all points are clamped to the map already
+	const cv::Rect fov_box = cv::boundingRect(fov_points) | cv::Rect(fov_origin_point, cv::Size(1,1));
 
-					// if wanted, count the coverage
-					if(number_of_coverages_image!=NULL)
-					{
-						number_of_coverages_image->at<int>(current_goal) = number_of_coverages_image->at<int>(current_goal)+1;
-					}
-				}
-			}
-		}
+	// draw the current field of view into the bounding box only, shifting the polygon by the box corner leaves the filled pixels unchanged
+	fov_mask.create(fov_box.height, fov_box.width, CV_8UC1);
+	fov_mask.setTo(0);
+	std::vector<std::vector<cv::Point> > contours(1, fov_points);
+	cv::drawContours(fov_mask, contours, 0, cv::Scalar(255), CV_FILLED, 8, cv::noArray(), INT_MAX, -fov_box.tl());
+
+	// collect the fov pixels in map coordinates
+	std::vector<cv::Point> fov_pixels;
+	for (int v=0; v<fov_mask.rows; ++v)
+	{
+		const uchar* fov_row = fov_mask.ptr<uchar>(v);
+		for (int u=0; u<fov_mask.cols; ++u)
+			if (fov_row[u]!=0)
+				fov_pixels.push_back(cv::Point(fov_box.x+u, fov_box.y+v));
 	}
+
+	// a line from the origin to a fov pixel never leaves the bounding box, so without obstacles (value 0) in the box all pixels are visible
+	const cv::Mat map_box = reachable_areas_map(fov_box);
+	if (cv::countNonZero(map_box) == fov_box.area())
+	{
+		visible_fov_pixels.swap(fov_pixels);
+		return;
+	}
+
+	// otherwise check visibility for each pixel of the fov area with one batch of rays from the fov origin
+	std::vector<bool> visible_pixels;
+	LineOfSight::checkVisibility(reachable_areas_map, fov_origin_point, fov_pixels, visible_pixels, 1, &obstacle_distance_field);
+	for (size_t i=0; i<fov_pixels.size(); ++i)
+		if (visible_pixels[i] == true)
+			visible_fov_pixels.push_back(fov_pixels[i]);
 }
 
 
@@ -177,29 +211,137 @@ void CoverageCheckServer::drawCoveredPointsCircle(cv::Mat& reachable_areas_map,
 {
 	const float map_resolution_inverse = 1./map_resolution;
 
-	cv::Mat map_copy = reachable_areas_map.clone(); // copy to draw positions that get later drawn into free space of the original map
 	const int coverage_radius_pixel = coverage_radius*map_resolution_inverse;
-	// iterate trough all poses and draw them into the given map
-	for(std::vector<cv::Point3d>::const_iterator pose=robot_poses.begin(); pose!=robot_poses.end(); ++pose)
+
+	// the filled circle is the same at each position, so it is drawn once and stamped at the footprint centers
+	cv::Mat footprint_stamp;
+	createFootprintStamp(coverage_radius_pixel, footprint_stamp);
+
+	// image coordinates of the footprint for each robot pose
+	std::vector<CoverageArea> coverage_areas(robot_poses.size());
+	for(size_t pose_index = 0; pose_index < robot_poses.size(); ++pose_index)
+		computeFootprintCoverageArea(robot_poses[pose_index], coverage_radius_pixel, map_resolution_inverse, map_origin,
+				reachable_areas_map.rows, reachable_areas_map.cols, coverage_areas[pose_index]);
+
+	// draw visited areas into free space of the map and count the number of visits, if wanted
+	accumulateCoverage(coverage_areas, cv::Mat(), cv::Mat(), footprint_stamp, reachable_areas_map, number_of_coverages_image);
+}
+
+
+void CoverageCheckServer::createFootprintStamp(const int coverage_radius_pixel, cv::Mat& footprint_stamp)
+{
+	footprint_stamp = cv::Mat::zeros(2*coverage_radius_pixel+1, 2*coverage_radius_pixel+1, CV_8UC1);
+	cv::circle(footprint_stamp, cv::Point(coverage_radius_pixel, coverage_radius_pixel), coverage_radius_pixel, cv::Scalar(1), -1);
+}
+
+
+void CoverageCheckServer::computeFootprintCoverageArea(const cv::Point3d& pose, const int coverage_radius_pixel, const float map_resolution_inverse,
+			const cv::Point2d& map_origin, const int rows, const int cols, CoverageArea& area)
+{
+	area.fov_points.clear();
+	area.origin = cv::Point((pose.x-map_origin.x)*map_resolution_inverse, (pose.y-map_origin.y)*map_resolution_inverse);
+	area.bounding_box = cv::Rect(area.origin.x-coverage_radius_pixel, area.origin.y-coverage_radius_pixel, 2*coverage_radius_pixel+1, 2*coverage_radius_pixel+1)
+			& cv::Rect(0, 0, cols, rows);
+}
+
+
+void CoverageCheckServer::accumulateCoverage(const std::vector<CoverageArea>& coverage_areas, const cv::Mat& obstacle_map,
+			const cv::Mat& obstacle_distance_field, const cv::Mat& footprint_stamp, cv::Mat& reachable_areas_map,
+			cv::Mat* number_of_coverages_image)
+{
+	if (coverage_areas.empty() == true)
+		return;
+
+	// the poses are split into consecutive chunks, one per thread, and each chunk is limited such that its 16 bit counters cannot overflow
+	const int number_of_threads = std::min(std::max(1, number_of_threads_), (int)coverage_areas.size());
+	const int chunk_size = std::min((int)std::numeric_limits<ushort>::max(), ((int)coverage_areas.size()+number_of_threads-1)/number_of_threads);
+	std::vector<std::vector<cv::Range> > thread_chunks(number_of_threads);
+	for (int chunk_begin = 0, chunk = 0; chunk_begin < (int)coverage_areas.size(); chunk_begin += chunk_size, ++chunk)
+		thread_chunks[chunk%number_of_threads].push_back(cv::Range(chunk_begin, std::min((int)coverage_areas.size(), chunk_begin+chunk_size)));
+
+	boost::mutex merge_mutex;
+	if (number_of_threads <= 1)
+		accumulateCoverageChunks(coverage_areas, obstacle_map, obstacle_distance_field, footprint_stamp, thread_chunks[0],
+				reachable_areas_map, number_of_coverages_image, merge_mutex);
+	else
 	{
-		// draw the transformed robot footprint
-		cv::Point current_point((pose->x-map_origin.x)*map_resolution_inverse, (pose->y-map_origin.y)*map_resolution_inverse);
-		cv::circle(map_copy, current_point, coverage_radius_pixel, cv::Scalar(127), -1);
+		boost::thread_group workers;
+		for (int t = 0; t < number_of_threads; ++t)
+			workers.create_thread(boost::bind(&CoverageCheckServer::accumulateCoverageChunks, boost::cref(coverage_areas), boost::cref(obstacle_map),
+					boost::cref(obstacle_distance_field), boost::cref(footprint_stamp), boost::cref(thread_chunks[t]),
+					boost::ref(reachable_areas_map), number_of_coverages_image, boost::ref(merge_mutex)));
+		workers.join_all();
+	}
+}
 
-		// update the number of visits at this location, if wanted
-		if(number_of_coverages_image!=NULL)
+
+void CoverageCheckServer::accumulateCoverageChunks(const std::vector<CoverageArea>& coverage_areas, const cv::Mat& obstacle_map,
+			const cv::Mat& obstacle_distance_field, const cv::Mat& footprint_stamp, const std::vector<cv::Range>& chunks,
+			cv::Mat& reachable_areas_map, cv::Mat* number_of_coverages_image, boost::mutex& merge_mutex)
+{
+	// buffers reused for all poses of this thread
+	cv::Mat fov_mask, tile_counts;
+	std::vector<cv::Point> visible_fov_pixels;
+
+	for (size_t chunk = 0; chunk < chunks.size(); ++chunk)
+	{
+		// the tile spans the bounding box of all pixels that the poses of this chunk can cover
+		cv::Rect tile;
+		for (int i = chunks[chunk].start; i < chunks[chunk].end; ++i)
+			if (coverage_areas[i].bounding_box.area() > 0)
+				tile = (tile.area() > 0 ? tile | coverage_areas[i].bounding_box : coverage_areas[i].bounding_box);
+		if (tile.area() == 0)
+			continue;
+		tile_counts.create(tile.height, tile.width, CV_16UC1);
+		tile_counts.setTo(0);
+
+		// count the coverages of this chunk in the tile
+		for (int i = chunks[chunk].start; i < chunks[chunk].end; ++i)
 		{
-			cv::Mat coverage_area = cv::Mat::zeros(map_copy.rows, map_copy.cols, CV_32SC1);
-			cv::circle(coverage_area, current_point, coverage_radius_pixel, cv::Scalar(1), -1);
-			*number_of_coverages_image = *number_of_coverages_image + coverage_area;
+			const CoverageArea& area = coverage_areas[i];
+			if (area.bounding_box.area() == 0)
+				continue;
+
+			if (footprint_stamp.empty() == false)
+			{
+				// add the footprint, the stamp is shifted by the same amount as the bounding box has been clipped at the map border
+				const int stamp_radius = footprint_stamp.rows/2;
+				const cv::Rect& box = area.bounding_box;
+				for (int v = 0; v < box.height; ++v)
+				{
+					const uchar* stamp_row = footprint_stamp.ptr<uchar>(box.y-area.origin.y+stamp_radius+v) + (box.x-area.origin.x+stamp_radius);
+					ushort* count_row = tile_counts.ptr<ushort>(box.y-tile.y+v) + (box.x-tile.x);
+					for (int u = 0; u < box.width; ++u)
+						count_row[u] += stamp_row[u];
+				}
+			}
+			else
+			{
+				// add the visible pixels of the field of view
+				computeVisibleFovPixels(obstacle_map, obstacle_distance_field, area.fov_points, area.origin, fov_mask, visible_fov_pixels);
+				for (size_t p = 0; p < visible_fov_pixels.size(); ++p)
+					++tile_counts.at<ushort>(visible_fov_pixels[p].y-tile.y, visible_fov_pixels[p].x-tile.x);
+			}
 		}
-	}
 
-	// draw visited areas into free space of the original map
-	for(size_t y=0; y<map_copy.rows; ++y)
-		for(size_t x=0; x<map_copy.cols; ++x)
-			if(reachable_areas_map.at<uchar>(y, x) == 255)
-				reachable_areas_map.at<uchar>(y, x) = map_copy.at<uchar>(y, x);
+		// merge the tile into the results, footprints are only drawn into free space (255) while visible pixels are always marked
+		boost::mutex::scoped_lock lock(merge_mutex);
+		for (int v = 0; v < tile.height; ++v)
+		{
+			const ushort* count_row = tile_counts.ptr<ushort>(v);
+			uchar* map_row = reachable_areas_map.ptr<uchar>(tile.y+v) + tile.x;
+			int* number_row = (number_of_coverages_image!=NULL ? number_of_coverages_image->ptr<int>(tile.y+v) + tile.x : NULL);
+			for (int u = 0; u < tile.width; ++u)
+			{
+				if (count_row[u] == 0)
+					continue;
+				if (footprint_stamp.empty() == true || map_row[u] == 255)
+					map_row[u] = 127;
+				if (number_row != NULL)
+					number_row[u] += count_row[u];
+			}
+		}
+	}
 }
 
 
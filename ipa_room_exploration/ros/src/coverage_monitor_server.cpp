@@ -68,7 +68,7 @@
 #include <dynamic_reconfigure/Reconfigure.h>
 #include <dynamic_reconfigure/Config.h>
 #include <ipa_room_exploration/CoverageMonitorConfig.h>
-#include <ipa_room_exploration/coverage_check_server.h>
+#include <ipa_room_exploration/coverage_accumulator.h>
 #include <ipa_building_msgs/CheckCoverage.h>
 
 #include <visualization_msgs/Marker.h>
@@ -79,15 +79,109 @@
 #include <tf/transform_listener.h>
 
 #include <boost/thread/mutex.hpp>
+#include <boost/lockfree/spsc_queue.hpp>
+#include <boost/circular_buffer.hpp>
 
 #include <opencv2/opencv.hpp>
 
 
+
+// Stores a trajectory with bounded memory. A pose is only stored if it is at least min_distance or min_angle away from the last
+// stored pose, and the oldest poses are overwritten once the capacity is reached. The stored poses are numbered consecutively since
+// the start, so users can keep track of the poses they have already processed even after old poses have been dropped.
+class TrajectoryBuffer
+{
+public:
+	TrajectoryBuffer()
+	: min_distance_(0.), min_angle_(0.), number_of_stored_poses_(0), number_of_marker_poses_(0)
+	{
+	}
+
+	void configure(const size_t capacity, const double min_distance, const double min_angle)
+	{
+		poses_.set_capacity(std::max((size_t)1, capacity));
+		min_distance_ = min_distance;
+		min_angle_ = min_angle;
+	}
+
+	// stores the pose if it is far enough from the last stored pose, returns true if it has been stored
+	bool addPose(const tf::StampedTransform& pose)
+	{
+		if (poses_.empty() == false)
+		{
+			const tf::StampedTransform& last_pose = poses_.back();
+			if (pose.getOrigin().distance(last_pose.getOrigin()) < min_distance_ &&
+					pose.getRotation().angleShortestPath(last_pose.getRotation()) < min_angle_)
+				return false;
+		}
+		poses_.push_back(pose);
+		++number_of_stored_poses_;
+		return true;
+	}
+
+	// number of poses stored since the start, including those that have been dropped already
+	size_t getNumberOfStoredPoses() const
+	{
+		return number_of_stored_poses_;
+	}
+
+	// number of the oldest pose that is still contained in the buffer
+	size_t getFirstAvailablePose() const
+	{
+		return number_of_stored_poses_ - poses_.size();
+	}
+
+	// returns the pose with the given number, which has to be in [getFirstAvailablePose(), getNumberOfStoredPoses())
+	const tf::StampedTransform& getPose(const size_t pose_number) const
+	{
+		return poses_[pose_number - getFirstAvailablePose()];
+	}
+
+	// Adds the poses stored since the last call (transformed by offset) to the line strip marker and publishes it. The marker is split
+	// into segments of at most max_segment_size points with consecutive ids, so each call only sends the points of the current segment.
+	void publishNewMarkerPoints(visualization_msgs::Marker& marker, const tf::Transform& offset, const size_t max_segment_size,
+			ros::Publisher& marker_pub)
+	{
+		if (number_of_marker_poses_ == number_of_stored_poses_)
+			return;
+
+		marker.header.stamp = ros::Time::now();
+		for (size_t i = std::max(number_of_marker_poses_, getFirstAvailablePose()); i < number_of_stored_poses_; ++i)
+		{
+			// close the full segment and continue the line in the next one
+			if (marker.points.size() >= std::max((size_t)2, max_segment_size))
+			{
+				marker_pub.publish(marker);
+				const geometry_msgs::Point last_point = marker.points.back();
+				marker.points.clear();
+				marker.points.push_back(last_point);
+				++marker.id;
+			}
+			geometry_msgs::Point point;
+			tf::pointTFToMsg((getPose(i)*offset).getOrigin(), point);
+			marker.points.push_back(point);
+		}
+		number_of_marker_poses_ = number_of_stored_poses_;
+
+		// a line strip needs at least two points
+		if (marker.points.size() >= 2)
+			marker_pub.publish(marker);
+	}
+
+protected:
+	boost::circular_buffer<tf::StampedTransform> poses_;	// the most recently stored poses
+	double min_distance_;			// minimum distance to the last stored pose, in [m]
+	double min_angle_;				// minimum rotation with respect to the last stored pose, in [rad]
+	size_t number_of_stored_poses_;	// number of poses stored since the start
+	size_t number_of_marker_poses_;	// number of stored poses that have been added to the marker already
+};
+
+
 class CoverageMonitor
 {
 public:
 	CoverageMonitor(ros::NodeHandle nh) :
-		node_handle_(nh)
+		node_handle_(nh), coverage_accumulator_initialized_(false), number_of_accumulated_poses_(0)
 	{
 		// dynamic reconfigure
 		coverage_monitor_dynamic_reconfigure_server_.setCallback(boost::bind(&CoverageMonitor::dynamicReconfigureCallback, this, _1, _2));
@@ -109,6 +203,22 @@ public:
 			coverage_circle_offset_transform_.setOrigin(tf::Vector3(0.29035, -0.114, 0.));
 		node_handle_.param("robot_trajectory_recording_active", robot_trajectory_recording_active_, false);
 		std::cout << "coverage_monitor/robot_trajectory_recording_active = " << robot_trajectory_recording_active_ << std::endl;
+		int trajectory_buffer_size = 100000;
+		node_handle_.param("trajectory_buffer_size", trajectory_buffer_size, 100000);
+		std::cout << "coverage_monitor/trajectory_buffer_size = " << trajectory_buffer_size << std::endl;
+		double trajectory_min_distance = 0.02;
+		node_handle_.param("trajectory_min_distance", trajectory_min_distance, 0.02);
+		std::cout << "coverage_monitor/trajectory_min_distance = " << trajectory_min_distance << std::endl;
+		double trajectory_min_angle = 0.05;
+		node_handle_.param("trajectory_min_angle", trajectory_min_angle, 0.05);
+		std::cout << "coverage_monitor/trajectory_min_angle = " << trajectory_min_angle << std::endl;
+		int marker_segment_size = 500;
+		node_handle_.param("marker_segment_size", marker_segment_size, 500);
+		marker_segment_size = std::max(2, marker_segment_size);
+		std::cout << "coverage_monitor/marker_segment_size = " << marker_segment_size << std::endl;
+		robot_trajectory_.configure(std::max(1, trajectory_buffer_size), trajectory_min_distance, trajectory_min_angle);
+		robot_computed_trajectory_.configure(std::max(1, trajectory_buffer_size), trajectory_min_distance, trajectory_min_angle);
+		robot_commanded_trajectory_.configure(std::max(1, trajectory_buffer_size), trajectory_min_distance, trajectory_min_angle);
 
 		// setup publishers and subscribers
 		coverage_marker_pub_ = node_handle_.advertise<visualization_msgs::Marker>("coverage_marker", 1);
@@ -154,8 +264,6 @@ public:
 		coverage_marker_msg.color.b = 0.0f;
 		coverage_marker_msg.color.a = 0.33;
 		coverage_marker_msg.lifetime = ros::Duration();
-		geometry_msgs::Point p; p.x=0; p.y=0; p.z=0;
-		coverage_marker_msg.points.push_back(p);
 
 		// prepare computed_trajectory_marker_msg message
 		visualization_msgs::Marker computed_trajectory_marker_msg;
@@ -188,7 +296,6 @@ public:
 		computed_trajectory_marker_msg.color.b = 0.0f;
 		computed_trajectory_marker_msg.color.a = 0.8;
 		computed_trajectory_marker_msg.lifetime = ros::Duration();
-		computed_trajectory_marker_msg.points.push_back(p);
 
 		// prepare commanded_trajectory_marker_msg message
 		visualization_msgs::Marker commanded_trajectory_marker_msg;
@@ -221,7 +328,6 @@ public:
 		commanded_trajectory_marker_msg.color.b = 1.0f;
 		commanded_trajectory_marker_msg.color.a = 0.8;
 		commanded_trajectory_marker_msg.lifetime = ros::Duration();
-		commanded_trajectory_marker_msg.points.push_back(p);
 
 		// cyclically publish marker messages
 		ros::AsyncSpinner spinner(2);	// asynch. spinner (2) is needed to call dynamic reconfigure from this node without blocking the node
@@ -240,48 +346,36 @@ public:
 					tf::StampedTransform transform;
 					transform_listener_.lookupTransform(map_frame_, robot_frame_, time, transform);
 					{
-						boost::mutex::scoped_lock lock(robot_trajectory_vector_mutex_);
-						robot_trajectory_vector_.push_back(transform);
+						boost::mutex::scoped_lock lock(robot_trajectory_mutex_);
+						robot_trajectory_.addPose(transform);
 					}
+
+					// keep the coverage up to date with the new pose
+					boost::mutex::scoped_lock lock(coverage_accumulator_mutex_);
+					accumulateRecordedPoses();
 				}
 //				// this can be used for testing if no data is available
 //				tf::StampedTransform transform(tf::Transform(tf::Quaternion(0, 0, 0, 1), tf::Vector3(0.1*index, 0., 0.)), ros::Time::now(), map_frame_, robot_frame_);
-//				robot_trajectory_vector_.push_back(transform);
-//				robot_computed_trajectory_vector_.push_back(transform);
-//				robot_commanded_trajectory_vector_.push_back(transform);
+//				robot_trajectory_.addPose(transform);
+//				computed_trajectory_queue_.push(transform);
+//				commanded_trajectory_queue_.push(transform);
 //				++index;
 			}
 
-			// update and publish coverage_marker_msg
-			coverage_marker_msg.header.stamp = ros::Time::now();
-			coverage_marker_msg.points.resize(robot_trajectory_vector_.size());
-			for (size_t i=0; i<robot_trajectory_vector_.size(); ++i)
-				tf::pointTFToMsg((robot_trajectory_vector_[i]*coverage_circle_offset_transform_).getOrigin(), coverage_marker_msg.points[i]);
-			coverage_marker_pub_.publish(coverage_marker_msg);
-
-			// update and publish computed_trajectory_marker_msg
-			{
-				// secure this access with a mutex
-				boost::mutex::scoped_lock lock(robot_computed_trajectory_vector_mutex_);
-
-				computed_trajectory_marker_msg.header.stamp = ros::Time::now();
-				computed_trajectory_marker_msg.points.resize(robot_computed_trajectory_vector_.size());
-				for (size_t i=0; i<robot_computed_trajectory_vector_.size(); ++i)
-					tf::pointTFToMsg((robot_computed_trajectory_vector_[i]*coverage_circle_offset_transform_).getOrigin(), computed_trajectory_marker_msg.points[i]);
-			}
-			computed_trajectory_marker_pub_.publish(computed_trajectory_marker_msg);
+			// move the received target trajectories into their buffers
+			tf::StampedTransform received_transform;
+			while (computed_trajectory_queue_.pop(received_transform) == true)
+				robot_computed_trajectory_.addPose(received_transform);
+			while (commanded_trajectory_queue_.pop(received_transform) == true)
+				robot_commanded_trajectory_.addPose(received_transform);
 
-			// update and publish commanded_trajectory_marker_msg
+			// publish the newly added parts of the trajectories
 			{
-				// secure this access with a mutex
-				boost::mutex::scoped_lock lock(robot_commanded_trajectory_vector_mutex_);
-
-				commanded_trajectory_marker_msg.header.stamp = ros::Time::now();
-				commanded_trajectory_marker_msg.points.resize(robot_commanded_trajectory_vector_.size());
-				for (size_t i=0; i<robot_commanded_trajectory_vector_.size(); ++i)
-					tf::pointTFToMsg((robot_commanded_trajectory_vector_[i]*coverage_circle_offset_transform_).getOrigin(), commanded_trajectory_marker_msg.points[i]);
+				boost::mutex::scoped_lock lock(robot_trajectory_mutex_);
+				robot_trajectory_.publishNewMarkerPoints(coverage_marker_msg, coverage_circle_offset_transform_, marker_segment_size, coverage_marker_pub_);
 			}
-			commanded_trajectory_marker_pub_.publish(commanded_trajectory_marker_msg);
+			robot_computed_trajectory_.publishNewMarkerPoints(computed_trajectory_marker_msg, coverage_circle_offset_transform_, marker_segment_size, computed_trajectory_marker_pub_);
+			robot_commanded_trajectory_.publishNewMarkerPoints(commanded_trajectory_marker_msg, coverage_circle_offset_transform_, marker_segment_size, commanded_trajectory_marker_pub_);
 
 			r.sleep();
 		}
@@ -292,11 +386,9 @@ public:
 	{
 		tf::StampedTransform transform;
 		tf::transformStampedMsgToTF(*trajectory_msg, transform);
-		{
-			// secure this access with a mutex
-			boost::mutex::scoped_lock lock(robot_computed_trajectory_vector_mutex_);
-			robot_computed_trajectory_vector_.push_back(transform);
-		}
+		// this callback is the only producer of the queue, the main loop the only consumer
+		if (computed_trajectory_queue_.push(transform) == false)
+			ROS_WARN_THROTTLE(1., "CoverageMonitor: computed trajectory queue is full, dropping pose.");
 	}
 
 	// receive commanded trajectory targets
@@ -304,11 +396,9 @@ public:
 	{
 		tf::StampedTransform transform;
 		tf::transformStampedMsgToTF(*trajectory_msg, transform);
-		{
-			// secure this access with a mutex
-			boost::mutex::scoped_lock lock(robot_commanded_trajectory_vector_mutex_);
-			robot_commanded_trajectory_vector_.push_back(transform);
-		}
+		// this callback is the only producer of the queue, the main loop the only consumer
+		if (commanded_trajectory_queue_.push(transform) == false)
+			ROS_WARN_THROTTLE(1., "CoverageMonitor: commanded trajectory queue is full, dropping pose.");
 	}
 
 	bool startCoverageMonitoringCallback(std_srvs::Trigger::Request &req, std_srvs::Trigger::Response &res)
@@ -371,33 +461,62 @@ public:
 		std::cout << "######################################################################################" << std::endl;
 	}
 
+	// adds the recorded robot poses that are not contained in the coverage yet, coverage_accumulator_mutex_ has to be locked by the caller
+	void accumulateRecordedPoses()
+	{
+		// nothing is accumulated before the first coverage request provides the map and coverage device
+		if (coverage_accumulator_initialized_ == false)
+			return;
+
+		std::vector<cv::Point3d> new_poses;
+		{
+			boost::mutex::scoped_lock lock(robot_trajectory_mutex_);
+			for (size_t i=std::max(number_of_accumulated_poses_, robot_trajectory_.getFirstAvailablePose()); i<robot_trajectory_.getNumberOfStoredPoses(); ++i)
+			{
+				const tf::StampedTransform& pose = robot_trajectory_.getPose(i);
+				new_poses.push_back(cv::Point3d(pose.getOrigin().getX(), pose.getOrigin().getY(), tf::getYaw(pose.getRotation())));
+			}
+			number_of_accumulated_poses_ = robot_trajectory_.getNumberOfStoredPoses();
+		}
+		coverage_accumulator_.addPoses(new_poses);
+	}
+
 	bool getCoverageImageCallback(ipa_building_msgs::CheckCoverage::Request &req, ipa_building_msgs::CheckCoverage::Response &res)
 	{
 		std::cout << "req.input_map.encoding:" << req.input_map.encoding << std::endl;
 		std::cout << "CoverageMonitor::getCoverageImageCallback." << std::endl;
 
-		// insert path to request message
+		// convert the request to cv and Eigen format
+		cv_bridge::CvImagePtr cv_ptr_obj;
+		cv_ptr_obj = cv_bridge::toCvCopy(req.input_map, sensor_msgs::image_encodings::MONO8);
+		const cv::Mat map = cv_ptr_obj->image;
+		const cv::Point2d map_origin(req.map_origin.position.x, req.map_origin.position.y);
+		std::vector<Eigen::Matrix<float, 2, 1> > field_of_view;
+		for (size_t i=0; i<req.field_of_view.size(); ++i)
+		{
+			Eigen::Matrix<float, 2, 1> current_vector;
+			current_vector << req.field_of_view[i].x, req.field_of_view[i].y;
+			field_of_view.push_back(current_vector);
+		}
+		Eigen::Matrix<float, 2, 1> fov_origin;
+		fov_origin << req.field_of_view_origin.x, req.field_of_view_origin.y;
+
+		// the coverage is accumulated while the poses are recorded, only a request with a different map or coverage device
+		// requires to check the whole recorded trajectory once
+		cv::Mat coverage_map, number_of_coverage_image;
 		{
-			boost::mutex::scoped_lock lock(robot_trajectory_vector_mutex_);
-			req.path.resize(robot_trajectory_vector_.size());
-			for (size_t i=0; i<robot_trajectory_vector_.size(); ++i)
+			boost::mutex::scoped_lock lock(coverage_accumulator_mutex_);
+			if (coverage_accumulator_.isInitializedFor(map, req.map_resolution, map_origin, field_of_view, fov_origin, req.coverage_radius, req.check_for_footprint) == false)
 			{
-				req.path[i].x = robot_trajectory_vector_[i].getOrigin().getX();
-				req.path[i].y = robot_trajectory_vector_[i].getOrigin().getY();
-				req.path[i].theta = tf::getYaw(robot_trajectory_vector_[i].getRotation());
+				coverage_accumulator_.initialize(map, req.map_resolution, map_origin, field_of_view, fov_origin, req.coverage_radius, req.check_for_footprint);
+				coverage_accumulator_initialized_ = true;
+				number_of_accumulated_poses_ = 0;	// replays all poses that are still contained in the trajectory buffer
 			}
+			accumulateRecordedPoses();
+			coverage_accumulator_.getCoverage(coverage_map, number_of_coverage_image);
 		}
 
-		// call coverage check server
-		CoverageCheckServer coverage_checker;
-		coverage_checker.checkCoverage(req, res);
-
-		std::cout << "res.coverage_map.encoding=" << res.coverage_map.encoding << std::endl;
 		// simplify returned coverage_map (remove room pixels [255] and remap the covered pixels from 127 to 255)
-		cv_bridge::CvImagePtr cv_ptr_obj;
-		cv_ptr_obj = cv_bridge::toCvCopy(res.coverage_map, res.coverage_map.encoding);	//sensor_msgs::image_encodings::MONO8);
-		cv::Mat coverage_map = cv_ptr_obj->image;
-
 		for (int v=0; v<coverage_map.rows; ++v)
 		{
 			for (int u=0; u<coverage_map.cols; ++u)
@@ -408,12 +527,23 @@ public:
 					coverage_map.at<uchar>(v,u) = 255;
 			}
 		}
+		ros::Time now = ros::Time::now();
 		cv_bridge::CvImage cv_image;
-		cv_image.header.stamp = res.coverage_map.header.stamp;
-		cv_image.encoding = res.coverage_map.encoding;
+		cv_image.header.stamp = now;
+		cv_image.encoding = sensor_msgs::image_encodings::MONO8;
 		cv_image.image = coverage_map;
 		cv_image.toImageMsg(res.coverage_map);
 
+		// if needed, return the image with number of coverages drawn in
+		if (req.check_number_of_coverages == true)
+		{
+			cv_bridge::CvImage number_image;
+			number_image.header.stamp = now;
+			number_image.encoding = sensor_msgs::image_encodings::TYPE_32SC1;
+			number_image.image = number_of_coverage_image;
+			number_image.toImageMsg(res.number_of_coverage_image);
+		}
+
 		return true;
 	}
 
@@ -442,12 +572,17 @@ protected:
 
 	bool robot_trajectory_recording_active_;		// the robot trajectory is only recorded if this is true (can be set from outside)
 
-	boost::mutex robot_trajectory_vector_mutex_;				// secures read and write operations on robot_trajectory_vector_
-	std::vector<tf::StampedTransform> robot_trajectory_vector_;				// vector of actual robot trajectory
-	std::vector<tf::StampedTransform> robot_computed_trajectory_vector_;	// vector of computed target robot trajectory
-	boost::mutex robot_computed_trajectory_vector_mutex_;		// secures read and write operations on robot_computed_trajectory_vector_
-	std::vector<tf::StampedTransform> robot_commanded_trajectory_vector_;	// vector of commanded target robot trajectory
-	boost::mutex robot_commanded_trajectory_vector_mutex_;		// secures read and write operations on robot_commanded_trajectory_vector_
+	boost::mutex robot_trajectory_mutex_;				// secures read and write operations on robot_trajectory_
+	TrajectoryBuffer robot_trajectory_;				// actual robot trajectory
+	TrajectoryBuffer robot_computed_trajectory_;	// computed target robot trajectory, only accessed by the main loop
+	TrajectoryBuffer robot_commanded_trajectory_;	// commanded target robot trajectory, only accessed by the main loop
+	boost::lockfree::spsc_queue<tf::StampedTransform, boost::lockfree::capacity<1000> > computed_trajectory_queue_;	// passes the received computed targets to the main loop
+	boost::lockfree::spsc_queue<tf::StampedTransform, boost::lockfree::capacity<1000> > commanded_trajectory_queue_;	// passes the received commanded targets to the main loop
+
+	CoverageAccumulator coverage_accumulator_;		// coverage of robot_trajectory_, updated with each recorded pose
+	bool coverage_accumulator_initialized_;		// the accumulator is initialized with the map and coverage device of the first coverage request
+	size_t number_of_accumulated_poses_;		// number of poses of robot_trajectory_ that are contained in coverage_accumulator_
+	boost::mutex coverage_accumulator_mutex_;		// secures read and write operations on coverage_accumulator_
 };
 
 
@@ -58,6 +58,7 @@
  ****************************************************************/
 
 #include <ipa_room_exploration/fov_to_robot_mapper.h>
+#include <ipa_building_navigation/instrumentation.h>
 
 // Function that provides the functionality that a given fov path gets mapped to a robot path by using the given parameters.
 // To do so simply a vector operation is applied. If the computed robot pose is not in the free space, another accessible
@@ -69,6 +70,8 @@ void mapPath(const cv::Mat& room_map, std::vector<geometry_msgs::Pose2D>& robot_
 		const std::vector<geometry_msgs::Pose2D>& fov_path, const Eigen::Matrix<float, 2, 1>& robot_to_fov_vector,
 		const double map_resolution, const cv::Point2d map_origin, const cv::Point& starting_point)
 {
+	ScopedSpan span("fov_mapping");
+
 	// initialize helper classes
 	MapAccessibilityAnalysis map_accessibility;
 	AStarPlanner path_planner;
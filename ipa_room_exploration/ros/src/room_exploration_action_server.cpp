@@ -63,7 +63,9 @@
 // constructor
 RoomExplorationServer::RoomExplorationServer(ros::NodeHandle nh, std::string name_of_the_action) :
 	node_handle_(nh),
-	room_exploration_server_(node_handle_, name_of_the_action, boost::bind(&RoomExplorationServer::exploreRoom, this, _1), false)
+	room_exploration_server_(node_handle_, name_of_the_action, boost::bind(&RoomExplorationServer::exploreRoom, this, _1), false),
+	multi_room_exploration_server_(node_handle_, name_of_the_action + "/multi_room", boost::bind(&RoomExplorationServer::exploreRooms, this, _1), false),
+	instrumentation_publisher_(node_handle_, "room_exploration")
 {
 	// dynamic reconfigure
 	room_exploration_dynamic_reconfigure_server_.setCallback(boost::bind(&RoomExplorationServer::dynamic_reconfigure_callback, this, _1, _2));
@@ -74,10 +76,15 @@ RoomExplorationServer::RoomExplorationServer(ros::NodeHandle nh, std::string nam
 	std::cout << "room_exploration/room_exploration_algorithm = " << room_exploration_algorithm_ << std::endl;
 	node_handle_.param("display_trajectory", display_trajectory_, false);
 	std::cout << "room_exploration/display_trajectory = " << display_trajectory_ << std::endl;
+	node_handle_.param("multi_room_planning_threads", multi_room_planning_threads_, 0);
+	std::cout << "room_exploration/multi_room_planning_threads = " << multi_room_planning_threads_ << std::endl;
 
 	node_handle_.param("map_correction_closing_neighborhood_size", map_correction_closing_neighborhood_size_, 2);
 	std::cout << "room_exploration/map_correction_closing_neighborhood_size = " << map_correction_closing_neighborhood_size_ << std::endl;
 
+	node_handle_.param("astar_search_mode", astar_search_mode_, (int)ASTAR_STANDARD);
+	std::cout << "room_exploration/astar_search_mode = " << astar_search_mode_ << std::endl;
+
 	node_handle_.param("return_path", return_path_, true);
 	std::cout << "room_exploration/return_path = " << return_path_ << std::endl;
 	node_handle_.param("execute_path", execute_path_, false);
@@ -130,6 +137,13 @@ RoomExplorationServer::RoomExplorationServer(ros::NodeHandle nh, std::string nam
 		node_handle_.param("tsp_solver_timeout", timeout, 600);
 		tsp_solver_timeout_ = timeout;
 		std::cout << "room_exploration/tsp_solver_timeout = " << tsp_solver_timeout_ << std::endl;
+		node_handle_.param("distance_matrix_backend", distance_matrix_backend_, (int)DISTANCE_MATRIX_ASTAR);
+		std::cout << "room_exploration/distance_matrix_backend = " << distance_matrix_backend_ << std::endl;
+		node_handle_.param("distance_matrix_cache_size", distance_matrix_cache_size_, 5);
+		std::cout << "room_exploration/distance_matrix_cache_size = " << distance_matrix_cache_size_ << std::endl;
+		node_handle_.param<std::string>("distance_matrix_cache_directory", distance_matrix_cache_directory_, "");
+		std::cout << "room_exploration/distance_matrix_cache_directory = " << distance_matrix_cache_directory_ << std::endl;
+		DistanceMatrixCache::getInstance().configure(std::max(0, distance_matrix_cache_size_), distance_matrix_cache_directory_);
 
 	}
 	else if ((room_exploration_algorithm_ == 2) || (room_exploration_algorithm_ == 8)) // set boustrophedon (variant) exploration parameters
@@ -199,6 +213,7 @@ RoomExplorationServer::RoomExplorationServer(ros::NodeHandle nh, std::string nam
 
 	//Start action server
 	room_exploration_server_.start();
+	multi_room_exploration_server_.start();
 
 	ROS_INFO("Action server for room exploration has been initialized......");
 }
@@ -217,6 +232,9 @@ void RoomExplorationServer::dynamic_reconfigure_callback(ipa_room_exploration::R
 	map_correction_closing_neighborhood_size_ = config.map_correction_closing_neighborhood_size;
 	std::cout << "room_exploration/map_correction_closing_neighborhood_size_ = " << map_correction_closing_neighborhood_size_ << std::endl;
 
+	astar_search_mode_ = config.astar_search_mode;
+	std::cout << "room_exploration/astar_search_mode_ = " << astar_search_mode_ << std::endl;
+
 	return_path_ = config.return_path;
 	std::cout << "room_exploration/return_path_ = " << return_path_ << std::endl;
 	execute_path_ = config.execute_path;
@@ -247,6 +265,13 @@ void RoomExplorationServer::dynamic_reconfigure_callback(ipa_room_exploration::R
 		std::cout << "room_exploration/tsp_solver_ = " << tsp_solver_ << std::endl;
 		tsp_solver_timeout_ = config.tsp_solver_timeout;
 		std::cout << "room_exploration/tsp_solver_timeout_ = " << tsp_solver_timeout_ << std::endl;
+		distance_matrix_backend_ = config.distance_matrix_backend;
+		std::cout << "room_exploration/distance_matrix_backend_ = " << distance_matrix_backend_ << std::endl;
+		distance_matrix_cache_size_ = config.distance_matrix_cache_size;
+		std::cout << "room_exploration/distance_matrix_cache_size_ = " << distance_matrix_cache_size_ << std::endl;
+		distance_matrix_cache_directory_ = config.distance_matrix_cache_directory;
+		std::cout << "room_exploration/distance_matrix_cache_directory_ = " << distance_matrix_cache_directory_ << std::endl;
+		DistanceMatrixCache::getInstance().configure(std::max(0, distance_matrix_cache_size_), distance_matrix_cache_directory_);
 	}
 	else if ((room_exploration_algorithm_ == 2) || (room_exploration_algorithm_ == 8)) // set boustrophedon (variant) exploration parameters
 	{
@@ -317,6 +342,12 @@ void RoomExplorationServer::dynamic_reconfigure_callback(ipa_room_exploration::R
 void RoomExplorationServer::exploreRoom(const ipa_building_msgs::RoomExplorationGoalConstPtr &goal)
 {
 	ROS_INFO("*****Room Exploration action server*****");
+	// the instrumentation is process-wide, so the calls of the single and the multi room action, which run in different threads,
+	// are serialized while it is enabled, otherwise beginCall would discard the statistics of the other call
+	boost::unique_lock<boost::mutex> instrumentation_lock(instrumentation_mutex_, boost::defer_lock);
+	if (Instrumentation::isEnabled() == true)
+		instrumentation_lock.lock();
+	instrumentation_publisher_.beginCall();
 
 	// ***************** I. read the given parameters out of the goal *****************
 	// todo: this is only correct if the map is not rotated
@@ -344,6 +375,114 @@ void RoomExplorationServer::exploreRoom(const ipa_building_msgs::RoomExploration
 	cv_ptr_obj = cv_bridge::toCvCopy(goal->input_map, sensor_msgs::image_encodings::MONO8);
 	cv::Mat room_map = cv_ptr_obj->image;
 
+	// ***************** II. plan the path using the wanted planner *****************
+	std::vector<geometry_msgs::Pose2D> exploration_path;
+	double grid_spacing_in_pixel = 0.;
+	Eigen::Matrix<float, 2, 1> fitting_circle_center_point_in_meter;
+	const bool room_not_empty = planCoveragePath(room_map, map_resolution, map_origin, starting_position, planning_mode_, robot_radius,
+			goal->coverage_radius, goal->field_of_view, exploration_planners_, 0, exploration_path, grid_spacing_in_pixel, fitting_circle_center_point_in_meter);
+	if (room_not_empty == false)
+	{
+		std::cout << "RoomExplorationServer::exploreRoom: Warning: the requested room is too small for generating exploration trajectories." << std::endl;
+		ipa_building_msgs::RoomExplorationResult action_result;
+		room_exploration_server_.setAborted(action_result);
+		instrumentation_publisher_.publish();
+		return;
+	}
+
+	// display finally planned path
+	if (display_trajectory_ == true)
+	{
+		std::cout << "printing path" << std::endl;
+		cv::Mat fov_path_map;
+		for(size_t step=1; step<exploration_path.size(); ++step)
+		{
+			fov_path_map = room_map.clone();
+			cv::resize(fov_path_map, fov_path_map, cv::Size(), 2, 2, cv::INTER_LINEAR);
+			if (exploration_path.size() > 0)
+				cv::circle(fov_path_map, 2*cv::Point((exploration_path[0].x-map_origin.x)/map_resolution, (exploration_path[0].y-map_origin.y)/map_resolution), 2, cv::Scalar(150), CV_FILLED);
+			for(size_t i=1; i<=step; ++i)
+			{
+				cv::Point p1((exploration_path[i-1].x-map_origin.x)/map_resolution, (exploration_path[i-1].y-map_origin.y)/map_resolution);
+				cv::Point p2((exploration_path[i].x-map_origin.x)/map_resolution, (exploration_path[i].y-map_origin.y)/map_resolution);
+				cv::circle(fov_path_map, 2*p2, 2, cv::Scalar(200), CV_FILLED);
+				cv::line(fov_path_map, 2*p1, 2*p2, cv::Scalar(150), 1);
+				cv::Point p3(p2.x+5*cos(exploration_path[i].theta), p2.y+5*sin(exploration_path[i].theta));
+				if (i==step)
+				{
+					cv::circle(fov_path_map, 2*p2, 2, cv::Scalar(80), CV_FILLED);
+					cv::line(fov_path_map, 2*p1, 2*p2, cv::Scalar(150), 1);
+					cv::line(fov_path_map, 2*p2, 2*p3, cv::Scalar(50), 1);
+				}
+			}
+//			cv::imshow("cell path", fov_path_map);
+//			cv::waitKey();
+		}
+		cv::imshow("cell path", fov_path_map);
+		cv::waitKey();
+	}
+
+	ROS_INFO("Room exploration planning finished.");
+
+	ipa_building_msgs::RoomExplorationResult action_result;
+	// check if the size of the exploration path is larger then zero
+	if(exploration_path.size()==0)
+	{
+		room_exploration_server_.setAborted(action_result);
+		instrumentation_publisher_.publish();
+		return;
+	}
+
+	// if wanted, return the path as the result
+	if(return_path_ == true)
+	{
+		action_result.coverage_path = exploration_path;
+		// return path in PoseStamped format as well (e.g. necessary for move_base commands)
+		std::vector<geometry_msgs::PoseStamped> exploration_path_pose_stamped(exploration_path.size());
+		std_msgs::Header header;
+		header.stamp = ros::Time::now();
+		header.frame_id = "/map";
+		for (size_t i=0; i<exploration_path.size(); ++i)
+		{
+			exploration_path_pose_stamped[i].header = header;
+			exploration_path_pose_stamped[i].header.seq = i;
+			exploration_path_pose_stamped[i].pose.position.x = exploration_path[i].x;
+			exploration_path_pose_stamped[i].pose.position.y = exploration_path[i].y;
+			exploration_path_pose_stamped[i].pose.position.z = 0.;
+			Eigen::Quaterniond quaternion;
+			quaternion = Eigen::AngleAxisd((double)exploration_path[i].theta, Eigen::Vector3d::UnitZ());
+			tf::quaternionEigenToMsg(quaternion, exploration_path_pose_stamped[i].pose.orientation);
+		}
+		action_result.coverage_path_pose_stamped = exploration_path_pose_stamped;
+
+		nav_msgs::Path coverage_path;
+		coverage_path.header.frame_id = "map";
+		coverage_path.header.stamp = ros::Time::now();
+		coverage_path.poses = exploration_path_pose_stamped;
+		path_pub_.publish(coverage_path);
+	}
+
+	// ***************** III. Navigate trough all points and save the robot poses to check what regions have been seen *****************
+	// [optionally] execute the path
+	if(execute_path_ == true)
+	{
+		navigateExplorationPath(exploration_path, goal->field_of_view, goal->field_of_view_origin, goal->coverage_radius, fitting_circle_center_point_in_meter.norm(),
+					map_resolution, goal->map_origin, grid_spacing_in_pixel, room_map.rows * map_resolution);
+		ROS_INFO("Explored room.");
+	}
+
+	room_exploration_server_.setSucceeded(action_result);
+	instrumentation_publisher_.publish();
+
+	return;
+}
+
+bool RoomExplorationServer::planCoveragePath(cv::Mat& room_map, const float map_resolution, const cv::Point2d& map_origin,
+		const cv::Point& starting_position, const int planning_mode, const float robot_radius, const float coverage_radius,
+		const std::vector<geometry_msgs::Point32>& field_of_view, ExplorationPlanners& planners, const int distance_matrix_threads,
+		std::vector<geometry_msgs::Pose2D>& exploration_path, double& grid_spacing_in_pixel,
+		Eigen::Matrix<float, 2, 1>& fitting_circle_center_point_in_meter)
+{
 	// determine room size
 	int area_px = 0;		// room area in pixels
 	for (int v=0; v<room_map.rows; ++v)
@@ -360,91 +499,97 @@ void RoomExplorationServer::exploreRoom(const ipa_building_msgs::RoomExploration
 	// remove unconnected, i.e. inaccessible, parts of the room (i.e. obstructed by furniture), only keep the room with the largest area
 	const bool room_not_empty = removeUnconnectedRoomParts(room_map);
 	if (room_not_empty == false)
-	{
-		std::cout << "RoomExplorationServer::exploreRoom: Warning: the requested room is too small for generating exploration trajectories." << std::endl;
-		ipa_building_msgs::RoomExplorationResult action_result;
-		room_exploration_server_.setAborted(action_result);
-		return;
-	}
+		return false;
 
 	// get the grid size, to check the areas that should be revisited later
 	double grid_spacing_in_meter = 0.0;		// is the square grid cell side length that fits into the circle with the robot's coverage radius or fov coverage radius
 	float fitting_circle_radius_in_meter = 0;
-	Eigen::Matrix<float, 2, 1> fitting_circle_center_point_in_meter;	// this is also considered the center of the field of view, because around this point the maximum radius incircle can be found that is still inside the fov
+	fitting_circle_center_point_in_meter << 0, 0;	// this is also considered the center of the field of view, because around this point the maximum radius incircle can be found that is still inside the fov
 	std::vector<Eigen::Matrix<float, 2, 1> > fov_corners_meter(4);
 	const double fov_resolution = 1000;		// in [cell/meter]
-	if(planning_mode_ == PLAN_FOR_FOV) // read out the given fov-vectors, if needed
+	if(planning_mode == PLAN_FOR_FOV) // read out the given fov-vectors, if needed
 	{
 		// Get the size of one grid cell s.t. the grid can be completely covered by the field of view (fov) from all rotations around it.
 		for(int i = 0; i < 4; ++i)
-			fov_corners_meter[i] << goal->field_of_view[i].x, goal->field_of_view[i].y;
+			fov_corners_meter[i] << field_of_view[i].x, field_of_view[i].y;
 		computeFOVCenterAndRadius(fov_corners_meter, fitting_circle_radius_in_meter, fitting_circle_center_point_in_meter, fov_resolution);
 		// get the edge length of the grid square that fits into the fitting_circle_radius
 		grid_spacing_in_meter = fitting_circle_radius_in_meter*std::sqrt(2);
 	}
 	else // if planning should be done for the footprint, read out the given coverage radius
 	{
-		grid_spacing_in_meter = goal->coverage_radius*std::sqrt(2);
+		grid_spacing_in_meter = coverage_radius*std::sqrt(2);
 	}
 	// map the grid size to an int in pixel coordinates, using floor method
-	const double grid_spacing_in_pixel = grid_spacing_in_meter/map_resolution;		// is the square grid cell side length that fits into the circle with the robot's coverage radius or fov coverage radius, multiply with sqrt(2) to receive the whole working width
+	grid_spacing_in_pixel = grid_spacing_in_meter/map_resolution;		// is the square grid cell side length that fits into the circle with the robot's coverage radius or fov coverage radius, multiply with sqrt(2) to receive the whole working width
 	std::cout << "grid size: " << grid_spacing_in_meter << " m   (" << grid_spacing_in_pixel << " px)" << std::endl;
-	// set the cell_size_ for #4 convexSPP explorator or #5 flowNetwork explorator if it is not provided
-	if (cell_size_ <= 0)
-		cell_size_ = std::floor(grid_spacing_in_pixel);
+	// set the cell_size for #4 convexSPP explorator or #5 flowNetwork explorator if it is not provided
+	int cell_size = cell_size_;
+	if (cell_size <= 0)
+		cell_size = std::floor(grid_spacing_in_pixel);
 
 
-	// ***************** II. plan the path using the wanted planner *****************
 	// todo: consider option to provide the inflated map or the robot radius to the functions instead of inflating with half cell size there
 	Eigen::Matrix<float, 2, 1> zero_vector;
 	zero_vector << 0, 0;
-	std::vector<geometry_msgs::Pose2D> exploration_path;
+	exploration_path.clear();
+	planners.boustrophedon_explorer.setSearchMode(astar_search_mode_);
+	planners.boustrophedon_variant_explorer.setSearchMode(astar_search_mode_);
+	planners.convex_SPP_explorator.setSearchMode(astar_search_mode_);
+	planners.flow_network_explorator.setSearchMode(astar_search_mode_);
+	ScopedSpan planning_span("exploration_planning");
 	if (room_exploration_algorithm_ == 1) // use grid point explorator
 	{
+		DistanceMatrixSettings distance_matrix_settings;
+		distance_matrix_settings.number_of_threads = distance_matrix_threads;
+		distance_matrix_settings.backend = distance_matrix_backend_;
+		distance_matrix_settings.astar_search_mode = astar_search_mode_;
+		planners.grid_point_planner.setDistanceMatrixSettings(distance_matrix_settings);
+
 		// plan path
-		if(planning_mode_ == PLAN_FOR_FOV)
-			grid_point_planner.getExplorationPath(room_map, exploration_path, map_resolution, starting_position, map_origin, std::floor(grid_spacing_in_pixel), false, fitting_circle_center_point_in_meter, tsp_solver_, tsp_solver_timeout_);
+		if(planning_mode == PLAN_FOR_FOV)
+			planners.grid_point_planner.getExplorationPath(room_map, exploration_path, map_resolution, starting_position, map_origin, std::floor(grid_spacing_in_pixel), false, fitting_circle_center_point_in_meter, tsp_solver_, tsp_solver_timeout_);
 		else
-			grid_point_planner.getExplorationPath(room_map, exploration_path, map_resolution, starting_position, map_origin, std::floor(grid_spacing_in_pixel), true, zero_vector, tsp_solver_, tsp_solver_timeout_);
+			planners.grid_point_planner.getExplorationPath(room_map, exploration_path, map_resolution, starting_position, map_origin, std::floor(grid_spacing_in_pixel), true, zero_vector, tsp_solver_, tsp_solver_timeout_);
 	}
 	else if (room_exploration_algorithm_ == 2) // use boustrophedon explorator
 	{
 		// plan path
-		if(planning_mode_ == PLAN_FOR_FOV)
-			boustrophedon_explorer_.getExplorationPath(room_map, exploration_path, map_resolution, starting_position, map_origin, grid_spacing_in_pixel, grid_obstacle_offset_, path_eps_, cell_visiting_order_, false, fitting_circle_center_point_in_meter, min_cell_area_, max_deviation_from_track_);
+		if(planning_mode == PLAN_FOR_FOV)
+			planners.boustrophedon_explorer.getExplorationPath(room_map, exploration_path, map_resolution, starting_position, map_origin, grid_spacing_in_pixel, grid_obstacle_offset_, path_eps_, cell_visiting_order_, false, fitting_circle_center_point_in_meter, min_cell_area_, max_deviation_from_track_);
 		else
-			boustrophedon_explorer_.getExplorationPath(room_map, exploration_path, map_resolution, starting_position, map_origin, grid_spacing_in_pixel, grid_obstacle_offset_, path_eps_, cell_visiting_order_, true, zero_vector, min_cell_area_, max_deviation_from_track_);
+			planners.boustrophedon_explorer.getExplorationPath(room_map, exploration_path, map_resolution, starting_position, map_origin, grid_spacing_in_pixel, grid_obstacle_offset_, path_eps_, cell_visiting_order_, true, zero_vector, min_cell_area_, max_deviation_from_track_);
 	}
 	else if (room_exploration_algorithm_ == 3) // use neural network explorator
 	{
-		neural_network_explorator_.setParameters(A_, B_, D_, E_, mu_, step_size_, delta_theta_weight_);
+		planners.neural_network_explorator.setParameters(A_, B_, D_, E_, mu_, step_size_, delta_theta_weight_);
 		// plan path
-		if(planning_mode_ == PLAN_FOR_FOV)
-			neural_network_explorator_.getExplorationPath(room_map, exploration_path, map_resolution, starting_position, map_origin, grid_spacing_in_pixel, false, fitting_circle_center_point_in_meter, false);
+		if(planning_mode == PLAN_FOR_FOV)
+			planners.neural_network_explorator.getExplorationPath(room_map, exploration_path, map_resolution, starting_position, map_origin, grid_spacing_in_pixel, false, fitting_circle_center_point_in_meter, false);
 		else
-			neural_network_explorator_.getExplorationPath(room_map, exploration_path, map_resolution, starting_position, map_origin, grid_spacing_in_pixel, true, zero_vector, false);
+			planners.neural_network_explorator.getExplorationPath(room_map, exploration_path, map_resolution, starting_position, map_origin, grid_spacing_in_pixel, true, zero_vector, false);
 	}
 	else if (room_exploration_algorithm_ == 4) // use convexSPP explorator
 	{
 		// plan coverage path
-		if(planning_mode_ == PLAN_FOR_FOV)
-			convex_SPP_explorator_.getExplorationPath(room_map, exploration_path, map_resolution, starting_position, map_origin, cell_size_, delta_theta_, fov_corners_meter, fitting_circle_center_point_in_meter, 0., 7, false);
+		if(planning_mode == PLAN_FOR_FOV)
+			planners.convex_SPP_explorator.getExplorationPath(room_map, exploration_path, map_resolution, starting_position, map_origin, cell_size, delta_theta_, fov_corners_meter, fitting_circle_center_point_in_meter, 0., 7, false);
 		else
-			convex_SPP_explorator_.getExplorationPath(room_map, exploration_path, map_resolution, starting_position, map_origin, cell_size_, delta_theta_, fov_corners_meter, zero_vector, goal->coverage_radius, 7, true);
+			planners.convex_SPP_explorator.getExplorationPath(room_map, exploration_path, map_resolution, starting_position, map_origin, cell_size, delta_theta_, fov_corners_meter, zero_vector, coverage_radius, 7, true);
 	}
 	else if (room_exploration_algorithm_ == 5) // use flow network explorator
 	{
-		if(planning_mode_ == PLAN_FOR_FOV)
-			flow_network_explorator_.getExplorationPath(room_map, exploration_path, map_resolution, starting_position, map_origin, cell_size_, fitting_circle_center_point_in_meter, grid_spacing_in_pixel, false, path_eps_, curvature_factor_, max_distance_factor_);
+		if(planning_mode == PLAN_FOR_FOV)
+			planners.flow_network_explorator.getExplorationPath(room_map, exploration_path, map_resolution, starting_position, map_origin, cell_size, fitting_circle_center_point_in_meter, grid_spacing_in_pixel, false, path_eps_, curvature_factor_, max_distance_factor_);
 		else
-			flow_network_explorator_.getExplorationPath(room_map, exploration_path, map_resolution, starting_position, map_origin, cell_size_, zero_vector, grid_spacing_in_pixel, true, path_eps_, curvature_factor_, max_distance_factor_);
+			planners.flow_network_explorator.getExplorationPath(room_map, exploration_path, map_resolution, starting_position, map_origin, cell_size, zero_vector, grid_spacing_in_pixel, true, path_eps_, curvature_factor_, max_distance_factor_);
 	}
 	else if (room_exploration_algorithm_ == 6) // use energy functional explorator
 	{
-		if(planning_mode_ == PLAN_FOR_FOV)
-			energy_functional_explorator_.getExplorationPath(room_map, exploration_path, map_resolution, starting_position, map_origin, grid_spacing_in_pixel, false, fitting_circle_center_point_in_meter);
+		if(planning_mode == PLAN_FOR_FOV)
+			planners.energy_functional_explorator.getExplorationPath(room_map, exploration_path, map_resolution, starting_position, map_origin, grid_spacing_in_pixel, false, fitting_circle_center_point_in_meter);
 		else
-			energy_functional_explorator_.getExplorationPath(room_map, exploration_path, map_resolution, starting_position, map_origin, grid_spacing_in_pixel, true, zero_vector);
+			planners.energy_functional_explorator.getExplorationPath(room_map, exploration_path, map_resolution, starting_position, map_origin, grid_spacing_in_pixel, true, zero_vector);
 	}
 	else if (room_exploration_algorithm_ == 7) // use voronoi explorator
 	{
@@ -453,7 +598,7 @@ void RoomExplorationServer::exploreRoom(const ipa_building_msgs::RoomExploration
 		matToMap(room_gridmap, room_map);
 
 		// do not find nearest pose to starting-position and start there because of issue in planner when starting position is provided
-		if(planning_mode_==PLAN_FOR_FOV)
+		if(planning_mode==PLAN_FOR_FOV)
 		{
 //			cv::Mat distance_transform;
 //			cv::distanceTransform(room_map, distance_transform, CV_DIST_L2, CV_DIST_MASK_PRECISE);
@@ -501,13 +646,13 @@ void RoomExplorationServer::exploreRoom(const ipa_building_msgs::RoomExploration
 			ROS_INFO("Starting to map from field of view pose to robot pose");
 			cv::Point robot_starting_position = (fov_path.size()>0 ? cv::Point(fov_path[0].x, fov_path[0].y) : starting_position);
 			cv::Mat inflated_room_map;
-			cv::erode(room_map, inflated_room_map, cv::Mat(), cv::Point(-1, -1), (int)std::floor(goal->robot_radius/map_resolution));
+			cv::erode(room_map, inflated_room_map, cv::Mat(), cv::Point(-1, -1), (int)std::floor(robot_radius/map_resolution));
 			mapPath(inflated_room_map, exploration_path, fov_path, fitting_circle_center_point_in_meter, map_resolution, map_origin, robot_starting_position);
 		}
 		else
 		{
 			// convert coverage-radius to pixel integer
-			//int coverage_diameter = (int)std::floor(2.*goal->coverage_radius/map_resolution);
+			//int coverage_diameter = (int)std::floor(2.*coverage_radius/map_resolution);
 			//std::cout << "coverage radius in pixel: " << coverage_diameter << std::endl;
 			const int grid_spacing_as_int = (int)std::floor(grid_spacing_in_pixel);
 			std::cout << "grid spacing in pixel: " << grid_spacing_as_int << std::endl;
@@ -537,97 +682,196 @@ void RoomExplorationServer::exploreRoom(const ipa_building_msgs::RoomExploration
 	else if (room_exploration_algorithm_ == 8) // use boustrophedon variant explorator
 	{
 		// plan path
-		if(planning_mode_ == PLAN_FOR_FOV)
-			boustrophedon_variant_explorer_.getExplorationPath(room_map, exploration_path, map_resolution, starting_position, map_origin, grid_spacing_in_pixel, grid_obstacle_offset_, path_eps_, cell_visiting_order_, false, fitting_circle_center_point_in_meter, min_cell_area_, max_deviation_from_track_);
+		if(planning_mode == PLAN_FOR_FOV)
+			planners.boustrophedon_variant_explorer.getExplorationPath(room_map, exploration_path, map_resolution, starting_position, map_origin, grid_spacing_in_pixel, grid_obstacle_offset_, path_eps_, cell_visiting_order_, false, fitting_circle_center_point_in_meter, min_cell_area_, max_deviation_from_track_);
 		else
-			boustrophedon_variant_explorer_.getExplorationPath(room_map, exploration_path, map_resolution, starting_position, map_origin, grid_spacing_in_pixel, grid_obstacle_offset_, path_eps_, cell_visiting_order_, true, zero_vector, min_cell_area_, max_deviation_from_track_);
+			planners.boustrophedon_variant_explorer.getExplorationPath(room_map, exploration_path, map_resolution, starting_position, map_origin, grid_spacing_in_pixel, grid_obstacle_offset_, path_eps_, cell_visiting_order_, true, zero_vector, min_cell_area_, max_deviation_from_track_);
 	}
 
-	// display finally planned path
-	if (display_trajectory_ == true)
-	{
-		std::cout << "printing path" << std::endl;
-		cv::Mat fov_path_map;
-		for(size_t step=1; step<exploration_path.size(); ++step)
-		{
-			fov_path_map = room_map.clone();
-			cv::resize(fov_path_map, fov_path_map, cv::Size(), 2, 2, cv::INTER_LINEAR);
-			if (exploration_path.size() > 0)
-				cv::circle(fov_path_map, 2*cv::Point((exploration_path[0].x-map_origin.x)/map_resolution, (exploration_path[0].y-map_origin.y)/map_resolution), 2, cv::Scalar(150), CV_FILLED);
-			for(size_t i=1; i<=step; ++i)
-			{
-				cv::Point p1((exploration_path[i-1].x-map_origin.x)/map_resolution, (exploration_path[i-1].y-map_origin.y)/map_resolution);
-				cv::Point p2((exploration_path[i].x-map_origin.x)/map_resolution, (exploration_path[i].y-map_origin.y)/map_resolution);
-				cv::circle(fov_path_map, 2*p2, 2, cv::Scalar(200), CV_FILLED);
-				cv::line(fov_path_map, 2*p1, 2*p2, cv::Scalar(150), 1);
-				cv::Point p3(p2.x+5*cos(exploration_path[i].theta), p2.y+5*sin(exploration_path[i].theta));
-				if (i==step)
-				{
-					cv::circle(fov_path_map, 2*p2, 2, cv::Scalar(80), CV_FILLED);
-					cv::line(fov_path_map, 2*p1, 2*p2, cv::Scalar(150), 1);
-					cv::line(fov_path_map, 2*p2, 2*p3, cv::Scalar(50), 1);
-				}
-			}
-//			cv::imshow("cell path", fov_path_map);
-//			cv::waitKey();
-		}
-		cv::imshow("cell path", fov_path_map);
-		cv::waitKey();
-	}
+	planning_span.stop();
 
-	ROS_INFO("Room exploration planning finished.");
+	return true;
+}
 
-	ipa_building_msgs::RoomExplorationResult action_result;
-	// check if the size of the exploration path is larger then zero
-	if(exploration_path.size()==0)
+
+void RoomExplorationServer::exploreRooms(const ipa_building_msgs::MultiRoomExplorationGoalConstPtr &goal)
+{
+	ROS_INFO("*****Room Exploration action server: multi room exploration*****");
+	// the instrumentation is process-wide, so the calls of the single and the multi room action, which run in different threads,
+	// are serialized while it is enabled, otherwise beginCall would discard the statistics of the other call
+	boost::unique_lock<boost::mutex> instrumentation_lock(instrumentation_mutex_, boost::defer_lock);
+	if (Instrumentation::isEnabled() == true)
+		instrumentation_lock.lock();
+	instrumentation_publisher_.beginCall();
+	const ros::WallTime start_time = ros::WallTime::now();
+
+	// todo: this is only correct if the map is not rotated
+	const cv::Point2d map_origin(goal->map_origin.position.x, goal->map_origin.position.y);
+	const float map_resolution = goal->map_resolution;	// in [m/cell]
+	std::cout << "map origin: " << map_origin << " m       map resolution: " << map_resolution << " m/cell" << std::endl;
+
+	// converting the segmented map msg in cv format
+	cv_bridge::CvImagePtr cv_ptr_obj;
+	cv_ptr_obj = cv_bridge::toCvCopy(goal->segmented_map, sensor_msgs::image_encodings::TYPE_32SC1);
+	const cv::Mat segmented_map = cv_ptr_obj->image;
+
+	// determine bounding box, area and center of each room, rooms are labeled from 1 to N (65280 = free space without room)
+	std::map<int, cv::Rect> room_boxes;
+	std::map<int, cv::Point2d> room_centers;
+	std::map<int, int> room_areas;
+	for (int v=0; v<segmented_map.rows; ++v)
 	{
-		room_exploration_server_.setAborted(action_result);
-		return;
+		for (int u=0; u<segmented_map.cols; ++u)
+		{
+			const int label = segmented_map.at<int>(v,u);
+			if (label <= 0 || label >= 65280)
+				continue;
+			std::map<int, cv::Rect>::iterator box = room_boxes.find(label);
+			if (box == room_boxes.end())
+				room_boxes[label] = cv::Rect(u, v, 1, 1);
+			else
+				box->second |= cv::Rect(u, v, 1, 1);
+			room_centers[label] += cv::Point2d(u, v);
+			room_areas[label]++;
+		}
 	}
 
-	// if wanted, return the path as the result
-	if(return_path_ == true)
+	// the requested rooms, or all rooms of the map
+	std::vector<int> room_labels(goal->room_labels.begin(), goal->room_labels.end());
+	if (room_labels.empty() == true)
+		for (std::map<int, cv::Rect>::iterator box = room_boxes.begin(); box != room_boxes.end(); ++box)
+			room_labels.push_back(box->first);
+	std::sort(room_labels.begin(), room_labels.end());
+	room_labels.erase(std::unique(room_labels.begin(), room_labels.end()), room_labels.end());
+
+	// cut out the map of each room, a margin of obstacle pixels keeps the closing operation on the room map the same as on the full map
+	const int margin = 2;
+	std::vector<RoomPlanningTask> tasks(room_labels.size());
+	for (size_t i=0; i<room_labels.size(); ++i)
 	{
-		action_result.coverage_path = exploration_path;
-		// return path in PoseStamped format as well (e.g. necessary for move_base commands)
-		std::vector<geometry_msgs::PoseStamped> exploration_path_pose_stamped(exploration_path.size());
-		std_msgs::Header header;
-		header.stamp = ros::Time::now();
-		header.frame_id = "/map";
-		for (size_t i=0; i<exploration_path.size(); ++i)
+		RoomPlanningTask& task = tasks[i];
+		const int label = room_labels[i];
+		task.result.room_label = label;
+		task.result.success = false;
+		task.result.planning_time = 0.;
+		if (room_boxes.find(label) == room_boxes.end())
 		{
-			exploration_path_pose_stamped[i].header = header;
-			exploration_path_pose_stamped[i].header.seq = i;
-			exploration_path_pose_stamped[i].pose.position.x = exploration_path[i].x;
-			exploration_path_pose_stamped[i].pose.position.y = exploration_path[i].y;
-			exploration_path_pose_stamped[i].pose.position.z = 0.;
-			Eigen::Quaterniond quaternion;
-			quaternion = Eigen::AngleAxisd((double)exploration_path[i].theta, Eigen::Vector3d::UnitZ());
-			tf::quaternionEigenToMsg(quaternion, exploration_path_pose_stamped[i].pose.orientation);
+			ROS_WARN("RoomExplorationServer::exploreRooms: room %d does not exist in the segmented map.", label);
+			continue;
 		}
-		action_result.coverage_path_pose_stamped = exploration_path_pose_stamped;
 
-		nav_msgs::Path coverage_path;
-		coverage_path.header.frame_id = "map";
-		coverage_path.header.stamp = ros::Time::now();
-		coverage_path.poses = exploration_path_pose_stamped;
-		path_pub_.publish(coverage_path);
+		const cv::Rect& box = room_boxes[label];
+		const cv::Rect crop(box.x-margin, box.y-margin, box.width+2*margin, box.height+2*margin);
+		const cv::Rect crop_inside_map = crop & cv::Rect(0, 0, segmented_map.cols, segmented_map.rows);
+		task.room_map = cv::Mat::zeros(crop.height, crop.width, CV_8UC1);
+		cv::Mat room_map_inside_map = task.room_map(cv::Rect(crop_inside_map.x-crop.x, crop_inside_map.y-crop.y, crop_inside_map.width, crop_inside_map.height));
+		room_map_inside_map.setTo(cv::Scalar(255), segmented_map(crop_inside_map) == label);
+		task.map_origin = cv::Point2d(map_origin.x + crop.x*map_resolution, map_origin.y + crop.y*map_resolution);
+
+		// start at the room center, planRoomTasks moves it into the room if necessary
+		const cv::Point2d room_center = room_centers[label] * (1./room_areas[label]);
+		task.starting_position = cv::Point(room_center.x-crop.x, room_center.y-crop.y);
+		task.result.starting_position.x = room_center.x*map_resolution + map_origin.x;
+		task.result.starting_position.y = room_center.y*map_resolution + map_origin.y;
+		task.result.starting_position.theta = 0.;
 	}
 
-	// ***************** III. Navigate trough all points and save the robot poses to check what regions have been seen *****************
-	// [optionally] execute the path
-	if(execute_path_ == true)
+	// plan the rooms concurrently, each worker takes the next unplanned room when it has finished the previous one
+	int number_of_threads = (multi_room_planning_threads_ < 1 ? (int)boost::thread::hardware_concurrency() : multi_room_planning_threads_);
+	number_of_threads = std::max(1, std::min(number_of_threads, (int)tasks.size()));
+	std::cout << "planning " << tasks.size() << " rooms with " << number_of_threads << " threads" << std::endl;
+	const int distance_matrix_threads = (number_of_threads > 1 ? 1 : 0);	// the cores are already busy with the rooms
+	size_t next_task = 0;
+	boost::mutex task_mutex;
+	if (number_of_threads <= 1)
+		planRoomTasks(tasks, next_task, task_mutex, goal, distance_matrix_threads);
+	else
 	{
-		navigateExplorationPath(exploration_path, goal->field_of_view, goal->field_of_view_origin, goal->coverage_radius, fitting_circle_center_point_in_meter.norm(),
-					map_resolution, goal->map_origin, grid_spacing_in_pixel, room_map.rows * map_resolution);
-		ROS_INFO("Explored room.");
+		boost::thread_group workers;
+		for (int t=0; t<number_of_threads; ++t)
+			workers.create_thread(boost::bind(&RoomExplorationServer::planRoomTasks, this, boost::ref(tasks), boost::ref(next_task), boost::ref(task_mutex), goal, distance_matrix_threads));
+		workers.join_all();
 	}
 
-	room_exploration_server_.setSucceeded(action_result);
+	ipa_building_msgs::MultiRoomExplorationResult action_result;
+	for (size_t i=0; i<tasks.size(); ++i)
+		action_result.room_paths.push_back(tasks[i].result);
+	action_result.planning_time = (ros::WallTime::now()-start_time).toSec();
+	ROS_INFO("Multi room exploration planning finished after %f s.", action_result.planning_time);
 
-	return;
+	if (multi_room_exploration_server_.isPreemptRequested() == true)
+		multi_room_exploration_server_.setPreempted(action_result);
+	else
+		multi_room_exploration_server_.setSucceeded(action_result);
+	instrumentation_publisher_.publish();
 }
 
+
+void RoomExplorationServer::planRoomTasks(std::vector<RoomPlanningTask>& tasks, size_t& next_task, boost::mutex& task_mutex,
+		const ipa_building_msgs::MultiRoomExplorationGoalConstPtr& goal, const int distance_matrix_threads)
+{
+	ExplorationPlanners planners;
+	while (true)
+	{
+		// take the next room
+		size_t task_index = 0;
+		{
+			boost::mutex::scoped_lock lock(task_mutex);
+			if (next_task >= tasks.size() || multi_room_exploration_server_.isPreemptRequested() == true)
+				return;
+			task_index = next_task;
+			++next_task;
+		}
+		RoomPlanningTask& task = tasks[task_index];
+		if (task.room_map.empty() == true)
+			continue;
+
+		// the center of L- or U-shaped rooms may lie outside of the room, then the path starts at the closest room pixel that is at
+		// least the robot radius away from the room border, or as far away as possible in narrower rooms
+		cv::Mat room_distances;
+		cv::distanceTransform(task.room_map, room_distances, CV_DIST_L2, 5);
+		double max_room_distance = 0.;
+		cv::minMaxLoc(room_distances, 0, &max_room_distance);
+		const float min_room_distance = (float)std::min(max_room_distance, (double)(goal->robot_radius/goal->map_resolution));
+		const cv::Rect room_map_rect(0, 0, task.room_map.cols, task.room_map.rows);
+		if (room_map_rect.contains(task.starting_position) == false || room_distances.at<float>(task.starting_position) < min_room_distance)
+		{
+			cv::Point closest_position = task.starting_position;
+			double min_squared_distance = 1e100;
+			for (int v=0; v<room_distances.rows; ++v)
+			{
+				for (int u=0; u<room_distances.cols; ++u)
+				{
+					if (room_distances.at<float>(v,u) < min_room_distance)
+						continue;
+					const double squared_distance = (double)(u-task.starting_position.x)*(u-task.starting_position.x) + (double)(v-task.starting_position.y)*(v-task.starting_position.y);
+					if (squared_distance < min_squared_distance)
+					{
+						min_squared_distance = squared_distance;
+						closest_position = cv::Point(u, v);
+					}
+				}
+			}
+			task.starting_position = closest_position;
+			task.result.starting_position.x = closest_position.x*goal->map_resolution + task.map_origin.x;
+			task.result.starting_position.y = closest_position.y*goal->map_resolution + task.map_origin.y;
+		}
+
+		// plan the coverage path of the room
+		const ros::WallTime room_start_time = ros::WallTime::now();
+		double grid_spacing_in_pixel = 0.;
+		Eigen::Matrix<float, 2, 1> fitting_circle_center_point_in_meter;
+		const bool room_not_empty = planCoveragePath(task.room_map, goal->map_resolution, task.map_origin, task.starting_position, goal->planning_mode,
+				goal->robot_radius, goal->coverage_radius, goal->field_of_view, planners, distance_matrix_threads, task.result.coverage_path, grid_spacing_in_pixel,
+				fitting_circle_center_point_in_meter);
+		task.result.success = (room_not_empty == true && task.result.coverage_path.size() > 0);
+		task.result.planning_time = (ros::WallTime::now()-room_start_time).toSec();
+		if (task.result.success == false)
+			ROS_WARN("RoomExplorationServer::planRoomTasks: no coverage path could be planned for room %d.", task.result.room_label);
+	}
+}
+
+
 	// remove unconnected, i.e. inaccessible, parts of the room (i.e. obstructed by furniture), only keep the room with the largest area
 bool RoomExplorationServer::removeUnconnectedRoomParts(cv::Mat& room_map)
 {
@@ -786,6 +1030,7 @@ void RoomExplorationServer::navigateExplorationPath(const std::vector<geometry_m
 		fov_origin <<field_of_view_origin.x, field_of_view_origin.y;
 		//   --> call coverage checker
 		CoverageCheckServer coverage_checker;
+		coverage_checker.setNumberOfThreads(0);	// top-level call of the single room action, use all cores
 		if (coverage_checker.checkCoverage(costmap_as_mat, map_resolution, cv::Point2d(map_origin.position.x, map_origin.position.y),
 				path, fov, fov_origin, coverage_radius, (planning_mode_==PLAN_FOR_FOOTPRINT), false, coverage_map, number_of_coverage_image) == true)
 		{
@@ -1202,6 +1202,7 @@ public:
 			fov_origin << data.fov_origin_.x, data.fov_origin_.y;
 			//   --> call coverage checker
 			CoverageCheckServer coverage_checker;
+			coverage_checker.setNumberOfThreads(0);
 			if (coverage_checker.checkCoverage(data.room_maps_[room], data.map_resolution_, cv::Point2d(data.map_origin_.position.x, data.map_origin_.position.y),
 					path, field_of_view, fov_origin, data.coverage_radius_, (data.planning_mode_==FOOTPRINT), true, coverage_map, number_of_coverage_image) == true)
 			{
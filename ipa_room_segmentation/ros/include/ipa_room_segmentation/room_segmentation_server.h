@@ -80,6 +80,8 @@
 #include <ipa_building_msgs/RoomInformation.h>
 #include <ipa_building_msgs/ExtractAreaMapFromLabeledMap.h>
 
+#include <ipa_building_navigation/instrumentation_publisher.h>
+
 #include <ipa_room_segmentation/distance_segmentation.h>
 #include <ipa_room_segmentation/morphological_segmentation.h>
 #include <ipa_room_segmentation/voronoi_segmentation.h>
@@ -158,6 +160,8 @@ protected:
 	actionlib::SimpleActionServer<ipa_building_msgs::MapSegmentationAction> room_segmentation_server_;
 	dynamic_reconfigure::Server<ipa_room_segmentation::RoomSegmentationConfig> room_segmentation_dynamic_reconfigure_server_;
 
+	InstrumentationPublisher instrumentation_publisher_;	// stage timings and counters of each call, see parameters instrumentation/*
+
 public:
 	//initialize the action-server
 	RoomSegmentationServer(ros::NodeHandle nh, std::string name_of_the_action);
@@ -69,7 +69,8 @@ static bool DEBUG_DISPLAYS=false;
 
 RoomSegmentationServer::RoomSegmentationServer(ros::NodeHandle nh, std::string name_of_the_action) :
 	node_handle_(nh),
-	room_segmentation_server_(node_handle_, name_of_the_action, boost::bind(&RoomSegmentationServer::execute_segmentation_server, this, _1), false)
+	room_segmentation_server_(node_handle_, name_of_the_action, boost::bind(&RoomSegmentationServer::execute_segmentation_server, this, _1), false),
+	instrumentation_publisher_(node_handle_, "room_segmentation")
 {
 	// parameters to check if the algorithms need to be trained (not part of dynamic reconfigure)
 	node_handle_.param("train_semantic", train_semantic_, false);
@@ -385,6 +386,7 @@ void RoomSegmentationServer::execute_segmentation_server(const ipa_building_msgs
 
 	ros::Rate looping_rate(1);
 	ROS_INFO("*****Segmentation action server*****");
+	instrumentation_publisher_.beginCall();
 	ROS_INFO("map resolution is : %f", goal->map_resolution);
 	ROS_INFO("segmentation algorithm: %d", room_segmentation_algorithm_);
 
@@ -446,6 +448,7 @@ void RoomSegmentationServer::execute_segmentation_server(const ipa_building_msgs
 
 	//segment the given map
 	cv::Mat segmented_map;
+	ScopedSpan segmentation_span("segmentation");
 	if (room_segmentation_algorithm_ == 1)
 	{
 		MorphologicalSegmentation morphological_segmentation; //morphological segmentation method
@@ -540,13 +543,17 @@ void RoomSegmentationServer::execute_segmentation_server(const ipa_building_msgs
 	{
 		ROS_ERROR("Undefined algorithm selected.");
 		room_segmentation_algorithm_ = stored_room_segmentation_algorithm;
+		segmentation_span.stop();
+		instrumentation_publisher_.publish();
 		return;
 	}
 
+	segmentation_span.stop();
 	ROS_INFO("********Segmented the map************");
 	//	looping_rate.sleep();
 
 	// get the min/max-values and the room-centers
+	ScopedSpan room_centers_span("room_centers");
 	// compute room label codebook
 	std::map<int, size_t> label_vector_index_codebook; // maps each room label to a position in the rooms vector
 	size_t vector_index = 0;
@@ -700,6 +707,8 @@ void RoomSegmentationServer::execute_segmentation_server(const ipa_building_msgs
 		}
 	}
 
+	room_centers_span.stop();
+
 	// convert the segmented map into an indexed map which labels the segments with consecutive numbers (instead of arbitrary unordered labels in segmented map)
 	cv::Mat indexed_map = segmented_map.clone();
 	for (int y = 0; y < segmented_map.rows; ++y)
@@ -840,6 +849,7 @@ void RoomSegmentationServer::execute_segmentation_server(const ipa_building_msgs
 
 	//publish result
 	room_segmentation_server_.setSucceeded(action_result);
+	instrumentation_publisher_.publish();
 
 	ROS_INFO("********Map segmentation finished************");
 }